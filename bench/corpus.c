@@ -0,0 +1,214 @@
+/*
+    bench/corpus.c -- timed runs of espresso over a corpus of PLAs, compared
+    with a baseline
+
+    usage: bench_corpus [-r repeat] [-s slack] [-b baseline] [-w baseline]
+                        [-d dir] file.pla ...
+
+    Each PLA is read and minimized "repeat" times (default 3), each time in
+    a child process so that its peak resident size can be taken from
+    wait4().  The best wall time, the peak size and the cubes and literals
+    (cover_cost()) of the result are printed for each file.
+
+    With -b, the results are compared with those of a baseline file (as
+    written by -w): a file whose best time exceeds the baseline time by more
+    than the slack (default 0.5, i.e. 50%, and at least 50 ms), or whose
+    result has more cubes or literals, is flagged, and the exit status is 1.
+    The names of the files are taken relative to "dir" (default ".").
+*/
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "espresso.h"
+
+#define NOISE 0.05 /* seconds of difference never taken as a regression */
+
+typedef struct {
+    char name[256];
+    double seconds;
+    long rss_kb;
+    int cubes, literals;
+} result_t;
+
+/* minimize -- read and minimize "path", writing the cost on "fd" */
+static void minimize(char *path, int fd) {
+    FILE *fp;
+    pPLA PLA;
+    cost_t cost;
+
+    if ((fp = fopen(path, "r")) == NULL)
+        _exit(1);
+    PLA = NIL(PLA_t);
+    if (read_pla(fp, &PLA) == EOF)
+        _exit(1);
+    PLA->F = espresso(PLA->F, PLA->D, PLA->R);
+    cover_cost(PLA->F, &cost);
+    if (write(fd, &cost, sizeof(cost)) != sizeof(cost))
+        _exit(1);
+    _exit(0);
+}
+
+/* run -- minimize "path" in a child process; FALSE if that fails */
+static bool run(char *path, result_t *r) {
+    int fds[2], status;
+    pid_t pid;
+    struct rusage ru;
+    cost_t cost;
+    double start, t;
+    bool ok;
+
+    if (pipe(fds) != 0)
+        return FALSE;
+    start = wall_time();
+    if ((pid = fork()) == 0) {
+        /* the warnings of the reader are of no interest here */
+        (void)close(fds[0]);
+        (void)freopen("/dev/null", "w", stderr);
+        minimize(path, fds[1]);
+    }
+    (void)close(fds[1]);
+    ok = pid > 0 && read(fds[0], &cost, sizeof(cost)) == sizeof(cost);
+    (void)close(fds[0]);
+    if (pid < 0 || wait4(pid, &status, 0, &ru) != pid || status != 0)
+        return FALSE;
+    t = wall_time() - start;
+
+    if (ok) {
+        r->seconds = r->seconds < 0 ? t : MIN(r->seconds, t);
+        r->rss_kb = MAX(r->rss_kb, ru.ru_maxrss);
+        r->cubes = cost.cubes;
+        r->literals = cost.total;
+    }
+    return ok;
+}
+
+/* read_baseline -- the results of a baseline file (NULL if unreadable) */
+static result_t *read_baseline(char *file, int *n) {
+    FILE *fp;
+    result_t *base = NIL(result_t), r;
+    int size = 0;
+
+    *n = 0;
+    if ((fp = fopen(file, "r")) == NULL)
+        return NIL(result_t);
+    while (fscanf(fp, "%255s %lf %ld %d %d", r.name, &r.seconds, &r.rss_kb,
+                  &r.cubes, &r.literals) == 5) {
+        if (*n == size)
+            base = REALLOC(result_t, base, size = 2 * size + 64);
+        base[(*n)++] = r;
+    }
+    (void)fclose(fp);
+    return base;
+}
+
+/* regression -- describe how "r" is worse than its baseline "b" (or NULL) */
+static char *regression(result_t *r, result_t *b, double slack) {
+    if (r->cubes > b->cubes || r->literals > b->literals)
+        return "LARGER";
+    if (r->seconds > b->seconds * (1 + slack) &&
+        r->seconds - b->seconds > NOISE)
+        return "SLOWER";
+    return NIL(char);
+}
+
+int main(int argc, char **argv) {
+    result_t *results, *base = NIL(result_t), *b;
+    char *dir = ".", *baseline = NIL(char), *write_file = NIL(char), *path;
+    char *worse;
+    double slack = 0.5, total = 0, base_total = 0;
+    int c, i, j, k, n, nbase = 0, repeat = 3, failed = 0, regressions = 0;
+    FILE *fp;
+
+    while ((c = getopt(argc, argv, "b:d:r:s:w:")) != EOF) {
+        switch (c) {
+            case 'b':
+                baseline = optarg;
+                break;
+            case 'd':
+                dir = optarg;
+                break;
+            case 'r':
+                repeat = MAX(atoi(optarg), 1);
+                break;
+            case 's':
+                slack = atof(optarg);
+                break;
+            case 'w':
+                write_file = optarg;
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-r repeat] [-s slack] [-b baseline] "
+                        "[-w baseline] [-d dir] file.pla ...\n",
+                        argv[0]);
+                exit(2);
+        }
+    }
+    if (baseline != NIL(char) &&
+        (base = read_baseline(baseline, &nbase)) == NIL(result_t)) {
+        fprintf(stderr, "%s: unable to read baseline %s\n", argv[0],
+                baseline);
+        exit(2);
+    }
+
+    n = argc - optind;
+    results = ALLOC(result_t, MAX(n, 1));
+    path = ALLOC(char, strlen(dir) + 512);
+    printf("%-28s %9s %9s %7s %9s  %s\n", "file", "seconds", "rss(KB)",
+           "cubes", "literals", "baseline");
+    for (i = 0; i < n; i++) {
+        result_t *r = &results[i];
+        (void)snprintf(r->name, sizeof(r->name), "%s", argv[optind + i]);
+        (void)sprintf(path, "%s/%.255s", dir, r->name);
+        r->seconds = -1;
+        r->rss_kb = 0;
+        for (k = 0; k < repeat; k++)
+            if (!run(path, r))
+                break;
+        if (k < repeat) {
+            printf("%-28s failed\n", r->name);
+            r->seconds = -1;
+            failed++;
+            continue;
+        }
+        printf("%-28s %9.3f %9ld %7d %9d", r->name, r->seconds, r->rss_kb,
+               r->cubes, r->literals);
+        total += r->seconds;
+
+        for (b = NIL(result_t), j = 0; j < nbase; j++)
+            if (equal(base[j].name, r->name))
+                b = &base[j];
+        if (b != NIL(result_t)) {
+            base_total += b->seconds;
+            printf("  %5.2fx", b->seconds > 0 ? r->seconds / b->seconds : 0);
+            if ((worse = regression(r, b, slack)) != NIL(char)) {
+                printf(" %s (%.3fs, %d cubes, %d literals)", worse,
+                       b->seconds, b->cubes, b->literals);
+                regressions++;
+            }
+        }
+        printf("\n");
+        (void)fflush(stdout);
+    }
+    printf("# %d files, %d failed, %.3fs", n, failed, total);
+    if (baseline != NIL(char))
+        printf(" (baseline %.3fs), %d regressions", base_total, regressions);
+    printf("\n");
+
+    if (write_file != NIL(char)) {
+        if ((fp = fopen(write_file, "w")) == NULL) {
+            fprintf(stderr, "%s: unable to write %s\n", argv[0], write_file);
+            exit(2);
+        }
+        for (i = 0; i < n; i++)
+            if (results[i].seconds >= 0)
+                fprintf(fp, "%s %.4f %ld %d %d\n", results[i].name,
+                        results[i].seconds, results[i].rss_kb,
+                        results[i].cubes, results[i].literals);
+        (void)fclose(fp);
+    }
+    FREE(path);
+    FREE(results);
+    return failed > 0 || regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+/*
+    bench/count.c -- microbenchmark of the column counting of massive_count,
+    sf_count and sf_count_restricted
+
+    usage: bench_count [-n repeat] file.pla ...
+
+    For each PLA, the counts are computed over the ON-set and over its
+    cofactors against each literal of the first few variables (the cube
+    lists seen near the top of the unate recursion), both with the bit-sliced
+    counters of espresso and with the bit-at-a-time loops they replaced.
+    The counts must agree exactly; the times are reported on stdout.
+*/
+
+#include <time.h>
+#include "espresso.h"
+
+#define NVARS_COF 8 /* cofactor against the literals of this many variables */
+
+/* ref_massive_count -- the zero count of the old massive_count */
+static void ref_massive_count(pcube *T, int *count) {
+    pcube *T1;
+    int i;
+
+    for (i = cube.size - 1; i >= 0; i--)
+        count[i] = 0;
+    {
+        int i, *cnt;
+        set_word_t val;
+        pcube p, cof = T[0], full = cube.fullset;
+        for (T1 = T + 2; (p = *T1++) != NULL;)
+            for (i = LOOP(p); i > 0; i--)
+                if ((val = full[i] & ~(p[i] | cof[i]))) {
+                    cnt = count + ((i - 1) << LOGBPI);
+#if BPI == 64
+                    if (val >> 32) {
+                        int b;
+                        set_word_t hi = val >> 32;
+                        for (b = 32; hi != 0; b++, hi >>= 1)
+                            if (hi & 1)
+                                cnt[b]++;
+                    }
+#endif
+#if BPI >= 32
+                    if (val & 0xFF000000) {
+                        if (val & 0x80000000)
+                            cnt[31]++;
+                        if (val & 0x40000000)
+                            cnt[30]++;
+                        if (val & 0x20000000)
+                            cnt[29]++;
+                        if (val & 0x10000000)
+                            cnt[28]++;
+                        if (val & 0x08000000)
+                            cnt[27]++;
+                        if (val & 0x04000000)
+                            cnt[26]++;
+                        if (val & 0x02000000)
+                            cnt[25]++;
+                        if (val & 0x01000000)
+                            cnt[24]++;
+                    }
+                    if (val & 0x00FF0000) {
+                        if (val & 0x00800000)
+                            cnt[23]++;
+                        if (val & 0x00400000)
+                            cnt[22]++;
+                        if (val & 0x00200000)
+                            cnt[21]++;
+                        if (val & 0x00100000)
+                            cnt[20]++;
+                        if (val & 0x00080000)
+                            cnt[19]++;
+                        if (val & 0x00040000)
+                            cnt[18]++;
+                        if (val & 0x00020000)
+                            cnt[17]++;
+                        if (val & 0x00010000)
+                            cnt[16]++;
+                    }
+#endif
+                    if (val & 0xFF00) {
+                        if (val & 0x8000)
+                            cnt[15]++;
+                        if (val & 0x4000)
+                            cnt[14]++;
+                        if (val & 0x2000)
+                            cnt[13]++;
+                        if (val & 0x1000)
+                            cnt[12]++;
+                        if (val & 0x0800)
+                            cnt[11]++;
+                        if (val & 0x0400)
+                            cnt[10]++;
+                        if (val & 0x0200)
+                            cnt[9]++;
+                        if (val & 0x0100)
+                            cnt[8]++;
+                    }
+                    if (val & 0x00FF) {
+                        if (val & 0x0080)
+                            cnt[7]++;
+                        if (val & 0x0040)
+                            cnt[6]++;
+                        if (val & 0x0020)
+                            cnt[5]++;
+                        if (val & 0x0010)
+                            cnt[4]++;
+                        if (val & 0x0008)
+                            cnt[3]++;
+                        if (val & 0x0004)
+                            cnt[2]++;
+                        if (val & 0x0002)
+                            cnt[1]++;
+                        if (val & 0x0001)
+                            cnt[0]++;
+                    }
+                }
+    }
+}
+
+/* ref_sf_count -- the old sf_count */
+static void ref_sf_count(pset_family A, int *count) {
+    pset p, last;
+    int i, base;
+    set_word_t val;
+
+    for (i = A->sf_size - 1; i >= 0; i--)
+        count[i] = 0;
+    foreach_set(A, last, p) {
+        for (i = LOOP(p); i > 0;)
+            for (val = p[i], base = --i << LOGBPI; val != 0; base++, val >>= 1)
+                if (val & 1)
+                    count[base]++;
+    }
+}
+
+/* ref_sf_count_restricted -- the old sf_count_restricted */
+static void ref_sf_count_restricted(pset_family A, pset r, int *count) {
+    pset p, last;
+    int i, base, weight;
+    set_word_t val;
+
+    for (i = A->sf_size - 1; i >= 0; i--)
+        count[i] = 0;
+    foreach_set(A, last, p) {
+        weight = 1024 / (set_ord(p) - 1);
+        for (i = LOOP(p); i > 0;)
+            for (val = p[i] & r[i], base = --i << LOGBPI; val != 0;
+                 base++, val >>= 1)
+                if (val & 1)
+                    count[base] += weight;
+    }
+}
+
+static double seconds() {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void report(char *what, double told, double tnew) {
+    printf("  %-20s old %8.3fs  new %8.3fs  speedup %5.2fx\n", what, told,
+           tnew, tnew > 0 ? told / tnew : 0.0);
+}
+
+/* bench_file -- time the counting on one PLA; FALSE if the counts differ */
+static bool bench_file(char *name, int repeat) {
+    FILE *fp;
+    pPLA PLA;
+    pcube **lists, *T, temp;
+    pset r;
+    int *ref, *count, nlists, i, k, var, part;
+    double t, told, tnew;
+    bool ok = TRUE;
+
+    if ((fp = fopen(name, "r")) == NULL) {
+        perror(name);
+        return FALSE;
+    }
+    PLA = NIL(PLA_t);
+    if (read_pla(fp, &PLA) == EOF) {
+        fprintf(stderr, "%s: no PLA found\n", name);
+        (void)fclose(fp);
+        return FALSE;
+    }
+    (void)fclose(fp);
+
+    /* the ON-set and its cofactors against some literals */
+    lists = ALLOC(pcube *, 1 + 2 * NVARS_COF);
+    lists[0] = cube1list(PLA->F);
+    nlists = 1;
+    temp = new_cube();
+    for (var = 0; var < MIN(NVARS_COF, cube.num_binary_vars); var++)
+        for (part = 0; part < 2; part++) {
+            set_diff(temp, cube.fullset, cube.var_mask[var]);
+            set_insert(temp, cube.first_part[var] + part);
+            lists[nlists++] = cofactor(lists[0], temp);
+        }
+    free_cube(temp);
+    ref = ALLOC(int, cube.size);
+    count = ALLOC(int, cube.size);
+    r = set_fill(new_cube(), cube.size);
+
+    printf("%s: %d cubes, %d columns\n", name, PLA->F->count, cube.size);
+
+    /* massive_count */
+    told = tnew = 0;
+    for (k = 0; k < nlists; k++) {
+        T = lists[k];
+        ref_massive_count(T, ref);
+        massive_count(T);
+        if (memcmp(ref, cdata.part_zeros, sizeof(int) * cube.size) != 0)
+            ok = FALSE;
+        t = seconds();
+        for (i = 0; i < repeat; i++)
+            ref_massive_count(T, ref);
+        told += seconds() - t;
+        t = seconds();
+        for (i = 0; i < repeat; i++)
+            massive_count(T);
+        tnew += seconds() - t;
+    }
+    report("massive_count", told, tnew);
+
+    /* sf_count */
+    ref_sf_count(PLA->F, ref);
+    FREE(count);
+    count = sf_count(PLA->F);
+    if (memcmp(ref, count, sizeof(int) * cube.size) != 0)
+        ok = FALSE;
+    t = seconds();
+    for (i = 0; i < repeat * nlists; i++)
+        ref_sf_count(PLA->F, ref);
+    told = seconds() - t;
+    t = seconds();
+    for (i = 0; i < repeat * nlists; i++) {
+        FREE(count);
+        count = sf_count(PLA->F);
+    }
+    tnew = seconds() - t;
+    report("sf_count", told, tnew);
+
+    /* sf_count_restricted (over the cubes with at least two elements) */
+    if (PLA->F->count > 0 && cube.size > 1) {
+        ref_sf_count_restricted(PLA->F, r, ref);
+        FREE(count);
+        count = sf_count_restricted(PLA->F, r);
+        if (memcmp(ref, count, sizeof(int) * cube.size) != 0)
+            ok = FALSE;
+        t = seconds();
+        for (i = 0; i < repeat * nlists; i++)
+            ref_sf_count_restricted(PLA->F, r, ref);
+        told = seconds() - t;
+        t = seconds();
+        for (i = 0; i < repeat * nlists; i++) {
+            FREE(count);
+            count = sf_count_restricted(PLA->F, r);
+        }
+        tnew = seconds() - t;
+        report("sf_count_restricted", told, tnew);
+    }
+
+    if (!ok)
+        printf("  counts DIFFER\n");
+    for (k = 0; k < nlists; k++) {
+        free_cubelist(lists[k]);
+    }
+    FREE(lists);
+    FREE(ref);
+    FREE(count);
+    free_cube(r);
+    free_PLA(PLA);
+    setdown_cube();
+    FREE(cube.part_size);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int i, repeat = 100;
+    bool ok = TRUE;
+
+    for (i = 1; i < argc; i++) {
+        if (equal(argv[i], "-n") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            ok &= bench_file(argv[i], repeat);
+        }
+    }
+    return ok ? 0 : 1;
+}
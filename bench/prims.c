@@ -0,0 +1,203 @@
+/*
+    bench/prims.c -- microbenchmarks of the primitives of the minimization
+
+    usage: bench_prims [-n repeat] file.pla ...
+
+    For each PLA, the primitives are timed on the cubes they see when the
+    PLA is minimized:
+
+        cdist0          the ON-set cubes against the OFF-set cubes
+        cofactor        the cover F u D against each cube of F
+        scofactor       the cover F u D against each literal
+        massive_count   the cover F u D and its cofactors against literals
+        complement      the OFF-set, from F u D
+        tautology       each cube of the expanded F against the others and D
+        sm_minimum_cover  the covering table of irredundant on the expanded F
+        sf_contain      the unravelled F together with the expanded F
+        mini_sort       the unravelled F, and sort_reduce the expanded F
+
+    and the time per call is reported on stdout.  Each loop runs "repeat"
+    times (default 10); the pairs of cdist0 and the cubes of cofactor and
+    tautology are limited to the first few thousand.
+*/
+
+#include <time.h>
+#include "espresso.h"
+
+#define MAX_CUBES 2000 /* cubes taken from a cover at most */
+
+static double seconds() {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void report(char *what, long calls, double t) {
+    printf("  %-18s %10ld calls %12.1f ns/call %9.3fs\n", what, calls,
+           calls > 0 ? t * 1e9 / calls : 0.0, t);
+}
+
+/* bench_file -- time the primitives on one PLA */
+static bool bench_file(char *name, int repeat) {
+    FILE *fp;
+    pPLA PLA;
+    pcover F, Rbar, E, Rt, Rp, U;
+    pcube p, temp, *T, *T1, *L, save;
+    sm_matrix *table;
+    sm_row *cover;
+    long calls, hits;
+    int i, j, k, n, nF, var, part;
+    double t;
+
+    if ((fp = fopen(name, "r")) == NULL) {
+        perror(name);
+        return FALSE;
+    }
+    PLA = NIL(PLA_t);
+    if (read_pla(fp, &PLA) == EOF) {
+        fprintf(stderr, "%s: no PLA found\n", name);
+        (void)fclose(fp);
+        return FALSE;
+    }
+    (void)fclose(fp);
+    printf("%s: %d cubes, %d in the OFF-set, %d columns\n", name,
+           PLA->F->count, PLA->R->count, cube.size);
+    nF = MIN(PLA->F->count, MAX_CUBES);
+
+    /* cdist0 */
+    n = MIN(PLA->R->count, MAX_CUBES);
+    calls = hits = 0;
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        for (i = 0; i < nF; i++)
+            for (j = 0, p = GETSET(PLA->F, i); j < n; j++, calls++)
+                hits += cdist0(p, GETSET(PLA->R, j));
+    report("cdist0", calls, seconds() - t);
+    if (hits != 0)
+        printf("  (%ld intersections of F and R ?)\n", hits);
+
+    /* cofactor */
+    T = cube2list(PLA->F, PLA->D);
+    calls = 0;
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        for (i = 0; i < nF; i++, calls++)
+            free_cubelist(cofactor(T, GETSET(PLA->F, i)));
+    report("cofactor", calls, seconds() - t);
+
+    /* scofactor and massive_count (on the literals of the binary inputs) */
+    temp = new_cube();
+    calls = 0;
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        for (var = 0; var < cube.num_binary_vars; var++)
+            for (part = 0; part < 2; part++, calls++) {
+                (void)set_diff(temp, cube.fullset, cube.var_mask[var]);
+                set_insert(temp, cube.first_part[var] + part);
+                free_cubelist(scofactor(T, temp, var));
+            }
+    report("scofactor", calls, seconds() - t);
+
+    calls = 0;
+    t = seconds();
+    for (k = 0; k < repeat; k++) {
+        massive_count(T);
+        calls++;
+        for (var = 0; var < MIN(cube.num_binary_vars, 8); var++)
+            for (part = 0; part < 2; part++, calls++) {
+                (void)set_diff(temp, cube.fullset, cube.var_mask[var]);
+                set_insert(temp, cube.first_part[var] + part);
+                T1 = scofactor(T, temp, var);
+                massive_count(T1);
+                free_cubelist(T1);
+            }
+    }
+    report("massive_count", calls, seconds() - t);
+    free_cube(temp);
+    free_cubelist(T);
+
+    /* complement */
+    t = seconds();
+    for (k = 0; k < repeat; k++) {
+        Rbar = complement(cube2list(PLA->F, PLA->D));
+        free_cover(Rbar);
+    }
+    report("complement", repeat, seconds() - t);
+
+    /* tautology, as irredundant asks it: each cube against the others */
+    F = expand(sf_save(PLA->F), PLA->R, FALSE);
+    nF = MIN(F->count, MAX_CUBES);
+    L = cube2list(F, PLA->D);
+    n = CUBELISTSIZE(L);
+    calls = hits = 0;
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        for (i = 0; i < nF; i++, calls++) {
+            /* move cube i to the end of the list and leave it out */
+            save = L[2 + i], L[2 + i] = L[2 + n - 1], L[2 + n - 1] = NULL;
+            L[1] = (pcube)(L + 2 + n);
+            hits += cube_is_covered(L, save);
+            L[2 + n - 1] = L[2 + i], L[2 + i] = save;
+            L[1] = (pcube)(L + 3 + n);
+        }
+    report("tautology", calls, seconds() - t);
+    printf("  (%ld of %d cubes redundant)\n", hits / repeat, nF);
+    free_cubelist(L);
+
+    /* sm_minimum_cover, on the table irredundant builds */
+    irred_split_cover(F, PLA->D, &E, &Rt, &Rp);
+    table = irred_derive_table(PLA->D, E, Rp);
+    t = seconds();
+    for (k = 0; k < repeat; k++) {
+        cover = sm_minimum_cover(table, NIL(int), /* heuristic */ 1);
+        sm_row_free(cover);
+    }
+    report("sm_minimum_cover", repeat, seconds() - t);
+    printf("  (a table of %d rows and %d columns)\n", table->nrows,
+           table->ncols);
+    sm_free(table);
+    free_cover(E);
+    free_cover(Rt);
+    free_cover(Rp);
+
+    /* sf_contain, where each cube of the unravelled F is within another */
+    E = unravel(sf_save(PLA->F), cube.num_binary_vars);
+    U = sf_join(E, F);
+    free_cover(E);
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        free_cover(sf_contain(sf_save(U)));
+    report("sf_contain", repeat, seconds() - t);
+    printf("  (%d sets)\n", U->count);
+    free_cover(U);
+
+    /* mini_sort and sort_reduce, the orderings of expand and reduce */
+    U = unravel(sf_save(PLA->F), cube.num_binary_vars);
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        U = mini_sort(U, k % 2 ? SORT_ASCEND : SORT_DESCEND);
+    report("mini_sort", repeat, seconds() - t);
+    free_cover(U);
+    t = seconds();
+    for (k = 0; k < repeat; k++)
+        F = sort_reduce(F);
+    report("sort_reduce", repeat, seconds() - t);
+    free_cover(F);
+
+    free_PLA(PLA);
+    setdown_cube();
+    FREE(cube.part_size);
+    return TRUE;
+}
+
+int main(int argc, char **argv) {
+    int i, repeat = 10;
+    bool ok = TRUE;
+
+    for (i = 1; i < argc; i++) {
+        if (equal(argv[i], "-n") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            ok &= bench_file(argv[i], repeat);
+        }
+    }
+    return ok ? 0 : 1;
+}
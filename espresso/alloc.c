@@ -0,0 +1,261 @@
+/*
+    module: alloc.c
+    purpose: a profile of the storage allocated through ALLOC and REALLOC
+
+    With ESPRESSO_ALLOC_PROFILE set in the environment, ALLOC, REALLOC
+    and FREE (port.h) go through the functions below, which keep a small
+    header in front of each block: its size, the call site which
+    allocated it and the phase of espresso() then running (see PHASE;
+    tasks run in the phase of the context which spawned them).  For each
+    call site, and for each phase, the number of blocks and of bytes
+    allocated are counted, with the high-water mark of the bytes in use
+    (for a phase, those of the whole run while the phase was running).
+    The largest capacities given to a set family (sf_new() and its
+    growth) are kept as well.  The counters are updated with atomic
+    operations, so the overhead is a few of them per allocation, and the
+    profile is written with the one of -P (see profile_write()).
+
+    The setting is read once, by main() before anything is allocated: a
+    block allocated without its header must never be given to FREE while
+    profiling.  The storage which the C library allocates (getline(),
+    open_memstream()) is released with free() for that reason.
+*/
+
+#include <pthread.h>
+
+#include "espresso.h"
+
+#define ALLOC_SITES    4096 /* call sites of ALLOC and REALLOC (at most) */
+#define ALLOC_TOP      20   /* call sites written out */
+#define ALLOC_FAMILIES 8    /* largest set family capacities kept */
+
+int alloc_profiling = 0;
+
+/* in front of each block (keeping the block aligned as by malloc) */
+typedef union {
+    struct {
+        size_t size; /* bytes of the block */
+        int site;    /* index in alloc_sites */
+        int phase;   /* index in alloc_phases */
+    } h;
+    double align[2];
+} alloc_header_t;
+
+typedef struct {
+    const char *file; /* __FILE__ and __LINE__ of the call */
+    int line;
+    int used;                    /* the slot is taken (set last) */
+    long long count, bytes;      /* blocks and bytes allocated */
+    long long live, peak;        /* bytes in use, and their most */
+} alloc_site_t;
+
+typedef struct {
+    long long count, bytes; /* blocks and bytes allocated in the phase */
+    long long peak;         /* most bytes in use while it ran */
+} alloc_phase_t;
+
+typedef struct {
+    pset_family family;
+    long long bytes; /* of the data */
+    int capacity;    /* sets */
+    int wsize;       /* words of a set */
+    int phase;
+} alloc_family_t;
+
+static alloc_site_t alloc_sites[ALLOC_SITES];
+static alloc_phase_t alloc_phases[PHASES + 1]; /* the last one: no phase */
+static alloc_family_t alloc_families[ALLOC_FAMILIES];
+static long long alloc_live, alloc_peak, alloc_family_min;
+static pthread_mutex_t alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* alloc_profile_setup -- profile the storage if the environment says so */
+void alloc_profile_setup() {
+    char *env = getenv("ESPRESSO_ALLOC_PROFILE");
+
+    alloc_profiling = env != NIL(char) && *env != '\0' && !equal(env, "0");
+}
+
+/* alloc_max -- raise *p to v */
+static void alloc_max(long long *p, long long v) {
+    long long old = __atomic_load_n(p, __ATOMIC_RELAXED);
+
+    while (v > old && !__atomic_compare_exchange_n(
+                          p, &old, v, TRUE, __ATOMIC_RELAXED,
+                          __ATOMIC_RELAXED))
+        ;
+}
+
+/* alloc_site -- the slot of a call site, taking a free one the first time */
+static int alloc_site(const char *file, int line) {
+    alloc_site_t *s;
+    unsigned long h = ((unsigned long)file >> 4) * 31 + (unsigned long)line;
+    int i, n;
+
+    for (n = 0; n < ALLOC_SITES; n++) {
+        i = (h * 2654435761UL + n) % ALLOC_SITES;
+        s = &alloc_sites[i];
+        if (!__atomic_load_n(&s->used, __ATOMIC_ACQUIRE)) {
+            (void)pthread_mutex_lock(&alloc_lock);
+            if (!s->used) {
+                s->file = file;
+                s->line = line;
+                __atomic_store_n(&s->used, 1, __ATOMIC_RELEASE);
+            }
+            (void)pthread_mutex_unlock(&alloc_lock);
+        }
+        if (s->file == file && s->line == line)
+            return i;
+    }
+    return 0; /* the table is full: counted with another site */
+}
+
+/* alloc_count -- note a block of "size" bytes allocated at "site" */
+static void alloc_count(alloc_header_t *b, size_t size, int site) {
+    alloc_site_t *s = &alloc_sites[site];
+    alloc_phase_t *p;
+    long long live;
+    int phase = current_context->phase;
+
+    b->h.size = size;
+    b->h.site = site;
+    b->h.phase = phase = phase < 0 ? PHASES : phase;
+    p = &alloc_phases[phase];
+    (void)__atomic_add_fetch(&s->count, 1, __ATOMIC_RELAXED);
+    (void)__atomic_add_fetch(&s->bytes, size, __ATOMIC_RELAXED);
+    alloc_max(&s->peak, __atomic_add_fetch(&s->live, size, __ATOMIC_RELAXED));
+    (void)__atomic_add_fetch(&p->count, 1, __ATOMIC_RELAXED);
+    (void)__atomic_add_fetch(&p->bytes, size, __ATOMIC_RELAXED);
+    live = __atomic_add_fetch(&alloc_live, size, __ATOMIC_RELAXED);
+    alloc_max(&p->peak, live);
+    alloc_max(&alloc_peak, live);
+}
+
+/* alloc_uncount -- note that the block is no longer in use */
+static void alloc_uncount(alloc_header_t *b) {
+    (void)__atomic_sub_fetch(&alloc_sites[b->h.site].live, b->h.size,
+                             __ATOMIC_RELAXED);
+    (void)__atomic_sub_fetch(&alloc_live, b->h.size, __ATOMIC_RELAXED);
+}
+
+/* alloc_malloc -- ALLOC while profiling */
+void *alloc_malloc(size_t size, const char *file, int line) {
+    alloc_header_t *b = (alloc_header_t *)malloc(sizeof(*b) + size);
+
+    if (b == NULL)
+        return NULL;
+    alloc_count(b, size, alloc_site(file, line));
+    return b + 1;
+}
+
+/* alloc_realloc -- REALLOC while profiling (the block moves to this site) */
+void *alloc_realloc(void *obj, size_t size, const char *file, int line) {
+    alloc_header_t *b = obj == NULL ? NULL : (alloc_header_t *)obj - 1;
+
+    if (b != NULL)
+        alloc_uncount(b);
+    b = (alloc_header_t *)realloc(b, sizeof(*b) + size);
+    if (b == NULL)
+        return NULL;
+    alloc_count(b, size, alloc_site(file, line));
+    return b + 1;
+}
+
+/* alloc_free -- FREE while profiling */
+void alloc_free(void *obj) {
+    alloc_header_t *b = (alloc_header_t *)obj - 1;
+
+    alloc_uncount(b);
+    free(b);
+}
+
+/* alloc_family -- note the capacity given to a set family */
+void alloc_family(pset_family A) {
+    alloc_family_t *f = alloc_families;
+    long long bytes = (long long)A->capacity * A->wsize * sizeof(set_word_t);
+    int i, j, phase = current_context->phase;
+
+    if (bytes <= __atomic_load_n(&alloc_family_min, __ATOMIC_RELAXED))
+        return;
+    (void)pthread_mutex_lock(&alloc_lock);
+
+    /* a family which grows is listed once, at its largest */
+    for (j = 0; j < ALLOC_FAMILIES - 1 && f[j].family != A; j++)
+        ;
+    if (f[j].family == A && f[j].bytes >= bytes) {
+        (void)pthread_mutex_unlock(&alloc_lock);
+        return;
+    }
+    for (i = j; i > 0 && f[i - 1].bytes < bytes; i--)
+        f[i] = f[i - 1];
+    if (f[i].bytes < bytes) {
+        f[i].family = A;
+        f[i].bytes = bytes;
+        f[i].capacity = A->capacity;
+        f[i].wsize = A->wsize;
+        f[i].phase = phase < 0 ? PHASES : phase;
+    }
+    __atomic_store_n(&alloc_family_min, f[ALLOC_FAMILIES - 1].bytes,
+                     __ATOMIC_RELAXED);
+    (void)pthread_mutex_unlock(&alloc_lock);
+}
+
+/* alloc_base -- the file name of a path */
+static const char *alloc_base(const char *path) {
+    const char *p = strrchr(path, '/');
+
+    return p != NIL(char) ? p + 1 : path;
+}
+
+/* alloc_by_bytes -- the call sites by decreasing bytes (for qsort) */
+static int alloc_by_bytes(const void *a, const void *b) {
+    long long x = alloc_sites[*(const int *)a].bytes;
+    long long y = alloc_sites[*(const int *)b].bytes;
+
+    return x > y ? -1 : x < y ? 1 : *(const int *)a - *(const int *)b;
+}
+
+/*
+    alloc_profile_write -- write the "allocations" member of the profile
+    (see profile_write()), given the names of the phases
+*/
+void alloc_profile_write(FILE *fp, char **phase_name) {
+    alloc_site_t *s;
+    alloc_phase_t *p;
+    alloc_family_t *f;
+    int i, n, order[ALLOC_SITES];
+
+    fprintf(fp, "  \"allocations\": {\"live_bytes\": %lld, \"peak_bytes\": "
+                "%lld,\n    \"phases\": {",
+            alloc_live, alloc_peak);
+    for (i = 0; i <= PHASES; i++) {
+        p = &alloc_phases[i];
+        fprintf(fp, "%s\n      \"%s\": {\"count\": %lld, \"bytes\": %lld, "
+                    "\"peak_bytes\": %lld}",
+                i == 0 ? "" : ",", i < PHASES ? phase_name[i] : "other",
+                p->count, p->bytes, p->peak);
+    }
+
+    for (i = n = 0; i < ALLOC_SITES; i++)
+        if (alloc_sites[i].used)
+            order[n++] = i;
+    qsort(order, n, sizeof(int), alloc_by_bytes);
+    fprintf(fp, "\n    },\n    \"sites\": [");
+    for (i = 0; i < n && i < ALLOC_TOP; i++) {
+        s = &alloc_sites[order[i]];
+        fprintf(fp, "%s\n      {\"site\": \"%s:%d\", \"count\": %lld, "
+                    "\"bytes\": %lld, \"peak_bytes\": %lld, "
+                    "\"live_bytes\": %lld}",
+                i == 0 ? "" : ",", alloc_base(s->file), s->line, s->count,
+                s->bytes, s->peak, s->live);
+    }
+
+    fprintf(fp, "\n    ],\n    \"families\": [");
+    for (i = 0; i < ALLOC_FAMILIES && alloc_families[i].bytes > 0; i++) {
+        f = &alloc_families[i];
+        fprintf(fp, "%s\n      {\"capacity\": %d, \"words\": %d, "
+                    "\"bytes\": %lld, \"phase\": \"%s\"}",
+                i == 0 ? "" : ",", f->capacity, f->wsize, f->bytes,
+                f->phase < PHASES ? phase_name[f->phase] : "other");
+    }
+    fprintf(fp, "\n    ]\n  },\n");
+}
@@ -0,0 +1,155 @@
+/*
+    module: arena.c
+    purpose: a stack of storage for the cube lists of the recursions
+
+    The unate recursive routines (complement, tautology, sccc, ...)
+    allocate a cube list and a few cubes at every level of the recursion,
+    and release them when the level returns.  Rather than going through
+    malloc() each time, the storage is taken from the top of a stack
+    belonging to the current context, and given back by popping it.
+
+    A block must be released while its context is current, but need not
+    be released in the reverse order of allocation (cubelist_partition()
+    releases a list below the two it creates, for instance): a block
+    released out of order is only marked as free, and is popped with the
+    last block above it.  Everything left on the stack is released with
+    the context.
+
+    When built with NO_ARENA defined, the blocks come from malloc() one
+    at a time, so that a leak checker can see them.
+*/
+
+#include "espresso.h"
+
+#define ARENA_CHUNK 65536 /* bytes in a chunk of the stack (at least) */
+
+typedef struct arena_block_struct {
+    struct arena_block_struct *prev; /* block below this one in the chunk */
+    union {
+        bool freed;           /* released, waiting to be popped */
+        double align;         /* keeps the data aligned */
+    } u;
+} arena_block_t;
+
+struct arena_struct {
+    struct arena_struct *prev; /* chunk below this one */
+    size_t size;               /* bytes of storage in the chunk */
+    size_t top;                /* bytes in use */
+    arena_block_t *last;       /* topmost block (or NULL) */
+};
+
+#define CHUNK_DATA(a) ((char *)((a) + 1))
+
+#ifndef NO_ARENA
+/* arena_chunk -- a new chunk able to hold "bytes" bytes, on top of "prev" */
+static arena_t *arena_chunk(arena_t *prev, size_t bytes) {
+    arena_t *a;
+
+    bytes = MAX(bytes, ARENA_CHUNK);
+    a = (arena_t *)ALLOC(char, sizeof(arena_t) + bytes);
+    a->prev = prev;
+    a->size = bytes;
+    a->top = 0;
+    a->last = NIL(arena_block_t);
+    return a;
+}
+#endif
+
+/* arena_alloc -- allocate "bytes" bytes from the stack of the context */
+void *arena_alloc(size_t bytes) {
+#ifdef NO_ARENA
+    return ALLOC(char, bytes);
+#else
+    arena_t *a = current_context->arena;
+    arena_block_t *b;
+    size_t need;
+
+    need = sizeof(arena_block_t) +
+           (bytes + sizeof(arena_block_t) - 1) / sizeof(arena_block_t) *
+               sizeof(arena_block_t);
+    if (a == NIL(arena_t) || a->top + need > a->size) {
+        if (a != NIL(arena_t) && a->last == NIL(arena_block_t)) {
+            /* an empty chunk too small for the block */
+            current_context->arena = a->prev;
+            FREE(a);
+        }
+        a = current_context->arena = arena_chunk(current_context->arena, need);
+    }
+    b = (arena_block_t *)(CHUNK_DATA(a) + a->top);
+    b->prev = a->last;
+    b->u.freed = FALSE;
+    a->last = b;
+    a->top += need;
+    return (void *)(b + 1);
+#endif
+}
+
+/* arena_free -- release a block allocated by arena_alloc() */
+void arena_free(void *p) {
+#ifdef NO_ARENA
+    FREE(p);
+#else
+    arena_t *a;
+    arena_block_t *b;
+
+    ((arena_block_t *)p - 1)->u.freed = TRUE;
+
+    /* pop every released block from the top of the stack */
+    for (a = current_context->arena; a != NIL(arena_t); a = a->prev) {
+        while ((b = a->last) != NIL(arena_block_t) && b->u.freed) {
+            a->top = (char *)b - CHUNK_DATA(a);
+            a->last = b->prev;
+        }
+        if (b != NIL(arena_block_t))
+            break;
+    }
+
+    /* keep a single empty chunk on top, so a level which crosses the end
+     * of a chunk does not allocate and free a chunk each time */
+    while ((a = current_context->arena)->last == NIL(arena_block_t) &&
+           a->prev != NIL(arena_t) && a->prev->last == NIL(arena_block_t)) {
+        current_context->arena = a->prev;
+        FREE(a);
+    }
+#endif
+}
+
+/* arena_release -- free the whole stack of a context */
+void arena_release(pcontext ctx) {
+    arena_t *a;
+
+    while ((a = ctx->arena) != NIL(arena_t)) {
+        ctx->arena = a->prev;
+        FREE(a);
+    }
+}
+
+/*
+    arena_reset -- empty the stack of a context (blocks left on it are
+    dropped), keeping its largest chunk for the next PLA
+*/
+void arena_reset(pcontext ctx) {
+    arena_t *a, *keep = NIL(arena_t);
+
+    while ((a = ctx->arena) != NIL(arena_t)) {
+        ctx->arena = a->prev;
+        if (keep == NIL(arena_t) || a->size > keep->size) {
+            FREE(keep);
+            keep = a;
+        } else {
+            FREE(a);
+        }
+    }
+    if (keep != NIL(arena_t)) {
+        keep->prev = NIL(arena_t);
+        keep->top = 0;
+        keep->last = NIL(arena_block_t);
+    }
+    ctx->arena = keep;
+}
+
+/* arena_cube -- an empty cube from the stack (released by arena_free) */
+pcube arena_cube() {
+    pcube p = (pcube)arena_alloc(sizeof(set_word_t) * SET_SIZE(cube.size));
+    return set_clear(p, cube.size);
+}
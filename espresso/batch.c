@@ -0,0 +1,247 @@
+/*
+    module: batch.c
+    purpose: minimize many PLA files in one process
+
+    The input files are sorted by decreasing size (so that the long jobs
+    start first) and handed out to a pool of worker threads.  Each job
+    runs in a context of its own, so that the jobs are independent of
+    each other; the minimized PLA is written to a file of the same name
+    in the output directory (so of input files with the same name, only
+    the first is run), and a one-line status is printed for each
+    input file once all of the jobs have finished.
+*/
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include "espresso.h"
+
+typedef struct {
+    char *name;    /* input file name */
+    long size;     /* input file size (for the scheduling order) */
+    char *status;  /* "ok", or the reason for the failure */
+    int cubes_in;  /* cubes in the ON-set as read */
+    int cubes_out; /* cubes in the minimized ON-set */
+    double time;   /* wall time to read, minimize and write */
+} batch_job_t;
+
+typedef struct {
+    batch_job_t **order; /* jobs in the order they are started */
+    int njobs;
+    int next; /* next job to hand out */
+    char *outdir;
+    pthread_mutex_t lock;
+} batch_t;
+
+/* batch_base -- the file name of a path (that of its output file) */
+static char *batch_base(char *name) {
+    char *base = strrchr(name, '/');
+
+    return base == NULL ? name : base + 1;
+}
+
+/* batch_output_name -- the output file for an input file */
+static char *batch_output_name(char *outdir, char *name) {
+    char *base, *path;
+
+    base = batch_base(name);
+    path = ALLOC(char, strlen(outdir) + strlen(base) + 2);
+    (void)sprintf(path, "%s/%s", outdir, base);
+    return path;
+}
+
+/* batch_run_job -- minimize a single PLA in a fresh context */
+static void batch_run_job(batch_t *batch, batch_job_t *job) {
+    pcontext ctx, save;
+    jmp_buf env;
+    FILE *volatile fp, *volatile fpout;
+    pPLA PLA;
+    pcover F0;
+    bool solved;
+    cache_key_t key;
+    char *outname, mode[64];
+    double start;
+
+    start = wall_time();
+    ctx = context_new();
+    save = context_set(ctx);
+    fp = fpout = NULL;
+    outname = batch_output_name(batch->outdir, job->name);
+
+    ctx->fatal_env = &env;
+    if (setjmp(env) != 0) {
+        /* fatal() was called; the covers of this job are abandoned */
+        job->status = "fatal error";
+    } else if ((fp = fopen(job->name, "r")) == NULL) {
+        job->status = "cannot open input";
+    } else if (read_pla(fp, &PLA) == EOF) {
+        job->status = "no PLA found";
+        free_PLA(PLA);
+    } else if ((fpout = fopen(outname, "w")) == NULL) {
+        job->status = "cannot open output";
+        free_PLA(PLA);
+    } else {
+        job->cubes_in = PLA->F->count;
+        (void)sprintf(mode, "groups 1 passes %d strategy %d starts %d",
+                      pass_limit, espresso_strategy(), portfolio_starts);
+        cache_key(&key, CACHE_RESULT, PLA, mode);
+        F0 = verify_result ? sf_save(PLA->F) : (pcover)NULL;
+        ctx->truncated = FALSE;
+        solved = !cache_get(&key, PLA);
+        if (solved) {
+            if (decompose_function)
+                PLA->F = espresso_decomposed(PLA->F, PLA->D, PLA->R);
+            else
+                PLA->F = espresso_portfolio(PLA->F, PLA->D, PLA->R);
+        }
+        job->cubes_out = PLA->F->count;
+        if (F0 != (pcover)NULL && !espresso_verify(PLA->F, F0, PLA->D)) {
+            job->status = "verification failed";
+        } else {
+            if (solved && !ctx->truncated)
+                cache_put(&key, PLA);
+            if (print_binary)
+                fprint_binary_pla(fpout, PLA);
+            else
+                fprint_pla(fpout, PLA);
+            job->status = ferror(fpout)     ? "write error"
+                          : ctx->truncated ? "ok (stopped early)"
+                                           : "ok";
+        }
+        if (F0 != (pcover)NULL)
+            free_cover(F0);
+        free_PLA(PLA);
+    }
+    ctx->fatal_env = NULL;
+
+    if (fp != NULL)
+        (void)fclose(fp);
+    if (fpout != NULL)
+        (void)fclose(fpout);
+    FREE(outname);
+    (void)context_set(save);
+    context_free(ctx);
+    sm_cleanup();
+    job->time = wall_time() - start;
+}
+
+/* batch_worker -- keep taking jobs until there are none left */
+static void *batch_worker(void *arg) {
+    batch_t *batch = (batch_t *)arg;
+    batch_job_t *job;
+
+    for (;;) {
+        pthread_mutex_lock(&batch->lock);
+        job = batch->next < batch->njobs ? batch->order[batch->next++] : NULL;
+        pthread_mutex_unlock(&batch->lock);
+        if (job == NULL)
+            break;
+        batch_run_job(batch, job);
+    }
+    return NULL;
+}
+
+/* batch_compare_base -- order of output file name, then of the input */
+static int batch_compare_base(const void *a, const void *b) {
+    batch_job_t *ja = *(batch_job_t **)a, *jb = *(batch_job_t **)b;
+    int c = strcmp(batch_base(ja->name), batch_base(jb->name));
+
+    return c != 0 ? c : ja < jb ? -1 : ja > jb ? 1 : 0;
+}
+
+/* batch_compare -- descending order of input file size */
+static int batch_compare(const void *a, const void *b) {
+    long sa = (*(batch_job_t **)a)->size, sb = (*(batch_job_t **)b)->size;
+    return sa > sb ? -1 : sa < sb ? 1 : 0;
+}
+
+/*
+    batch_read_manifest -- append the file names listed in a manifest
+    (one per line, blank lines and lines starting with '#' are ignored)
+*/
+int batch_read_manifest(char *manifest, char ***files, int *nfiles) {
+    FILE *fp;
+    char line[4096], *p, *end;
+
+    if ((fp = fopen(manifest, "r")) == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        for (p = line; isspace((unsigned char)*p); p++)
+            ;
+        for (end = p + strlen(p); end > p && isspace((unsigned char)end[-1]);)
+            *--end = '\0';
+        if (*p == '\0' || *p == '#')
+            continue;
+        *files = REALLOC(char *, *files, *nfiles + 1);
+        (*files)[(*nfiles)++] = strcpy(ALLOC(char, strlen(p) + 1), p);
+    }
+    (void)fclose(fp);
+    return 1;
+}
+
+/*
+    batch_minimize -- minimize each of the files, writing the results
+    into "outdir" using "nthreads" worker threads; returns the number of
+    files which failed
+*/
+int batch_minimize(char **files, int nfiles, char *outdir, int nthreads,
+                   FILE *fpsummary) {
+    batch_t batch;
+    batch_job_t *jobs;
+    pthread_t *threads;
+    struct stat st;
+    int i, n, nfailed;
+    double start;
+
+    start = wall_time();
+    jobs = ALLOC(batch_job_t, nfiles);
+    batch.order = ALLOC(batch_job_t *, nfiles);
+    for (i = 0; i < nfiles; i++) {
+        jobs[i].name = files[i];
+        jobs[i].size = stat(files[i], &st) == 0 ? (long)st.st_size : 0;
+        jobs[i].status = "not run";
+        jobs[i].cubes_in = jobs[i].cubes_out = 0;
+        jobs[i].time = 0.0;
+        batch.order[i] = &jobs[i];
+    }
+
+    /* a file whose output would overwrite that of an earlier one is not run */
+    qsort(batch.order, nfiles, sizeof(batch_job_t *), batch_compare_base);
+    for (i = n = 0; i < nfiles; i++)
+        if (n > 0 && equal(batch_base(batch.order[i]->name),
+                           batch_base(batch.order[n - 1]->name)))
+            batch.order[i]->status = "duplicate output";
+        else
+            batch.order[n++] = batch.order[i];
+    qsort(batch.order, n, sizeof(batch_job_t *), batch_compare);
+    batch.njobs = n;
+    batch.next = 0;
+    batch.outdir = outdir;
+    pthread_mutex_init(&batch.lock, NULL);
+
+    /* run the jobs, the calling thread is one of the workers */
+    nthreads = MAX(1, MIN(nthreads, n));
+    threads = ALLOC(pthread_t, nthreads);
+    for (i = 1; i < nthreads; i++)
+        if (pthread_create(&threads[i], NULL, batch_worker, &batch) != 0)
+            fatal("batch: cannot create worker thread");
+    (void)batch_worker(&batch);
+    for (i = 1; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    FREE(threads);
+    pthread_mutex_destroy(&batch.lock);
+
+    /* report the jobs in the order they were given */
+    nfailed = 0;
+    for (i = 0; i < nfiles; i++) {
+        fprintf(fpsummary, "%-20s %9.3fs %7d -> %-7d %s\n", jobs[i].status,
+                jobs[i].time, jobs[i].cubes_in, jobs[i].cubes_out,
+                jobs[i].name);
+        nfailed += strncmp(jobs[i].status, "ok", 2) != 0;
+    }
+    fprintf(fpsummary, "# %d files, %d failed, %d threads, %.3fs\n", nfiles,
+            nfailed, nthreads, wall_time() - start);
+
+    FREE(batch.order);
+    FREE(jobs);
+    return nfailed;
+}
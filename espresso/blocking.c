@@ -0,0 +1,363 @@
+/*
+    module: blocking.c
+    purpose: a bit-sliced index of the blocking matrix of expand()
+
+    While a cube is expanded, the cubes of the OFF-set R (the blocking
+    matrix BB of expand1()) are checked again and again against RAISE:
+    which are orthogonal to the overexpanded cube, which are at distance
+    1 (and force parts low), which parts of FREESET they use.  Cube by
+    cube, each of these is a scan of all of R.
+
+    The index turns R on its side: for each part, the set of the cubes
+    of R which have it, one bit per cube.  The cubes of R which meet a
+    cube r in a variable are then the union of the columns of the parts
+    of r in that variable, and each question above is answered for 64
+    cubes of R at a time, by a few ANDs and ORs per variable.  The set
+    of active cubes is kept alongside (and the ACTIVE flags of BB with
+    it, for the code which still looks at the cubes), and only the words
+    where some cube is still active are visited.
+
+    expand() builds the index of R once and installs it in the current
+    context; essen_parts(), elim_lowering(), essen_raising() and
+    feasibly_covered() then use it when they are given that cover.
+    ESPRESSO_EXPAND=scan (or =index) turns it off (or on regardless of
+    the size of R).  The cubes found are the same either way.  With
+    batch_expand, the threads expanding cubes have indexes of their own
+    copies of R, which share the columns.
+*/
+
+#include "espresso.h"
+
+typedef unsigned long long bl_word;
+
+#define BL_BITS     64
+#define BL_WORDS(n) (((n) + BL_BITS - 1) / BL_BITS)
+#define BL_BIT(i)   ((bl_word)1 << ((i) % BL_BITS))
+
+#ifdef __GNUC__
+#define BL_LOWEST(w) __builtin_ctzll(w)
+#else
+#define BL_LOWEST(w) bl_lowest(w)
+static int bl_lowest(bl_word w) {
+    int i;
+    for (i = 0; (w & 1) == 0; i++, w >>= 1)
+        ;
+    return i;
+}
+#endif
+
+/* the index is built for an OFF-set of at least BLOCKING_MIN cubes, and
+ * of at most BLOCKING_MAX_BYTES bytes of columns */
+#define BLOCKING_MIN       256
+#define BLOCKING_MAX_BYTES (1 << 28)
+
+struct blocking_struct {
+    pcover R;           /* the cover indexed */
+    int n, words;       /* cubes of R, and words of a set of them */
+    bl_word *cols;      /* for each part, the cubes of R which have it */
+    bool shared;        /* the columns belong to another index */
+    bl_word *active;    /* the cubes of BB still active */
+    int *live, nlive;   /* the words of "active" which are not empty */
+    bl_word *meet;      /* the cubes meeting r in the current variable */
+    bl_word *one, *two; /* cubes at distance at least 1, at least 2 */
+    bl_word *conf;      /* for each variable, the cubes disjoint from r */
+    bool *var_conf;     /* some cube is disjoint from r in the variable */
+};
+
+#define COL(bi, j) ((bi)->cols + (size_t)(j) * (bi)->words)
+
+/* activate -- make every cube active */
+static void activate(blocking_t *bi) {
+    int k;
+
+    for (k = 0; k < bi->words; k++) {
+        bi->active[k] = ~(bl_word)0;
+        bi->live[k] = k;
+    }
+    if (bi->n % BL_BITS != 0)
+        bi->active[bi->words - 1] = BL_BIT(bi->n) - 1;
+    bi->nlive = bi->words;
+}
+
+/* scratch -- the sets of an index which change while cubes are expanded */
+static blocking_t *scratch(blocking_t *bi) {
+    bi->active = ALLOC(bl_word, bi->words);
+    bi->live = ALLOC(int, bi->words);
+    bi->meet = ALLOC(bl_word, bi->words);
+    bi->one = ALLOC(bl_word, bi->words);
+    bi->two = ALLOC(bl_word, bi->words);
+    bi->conf = ALLOC(bl_word, (size_t)cube.num_vars * bi->words);
+    bi->var_conf = ALLOC(bool, cube.num_vars);
+    activate(bi);
+    return bi;
+}
+
+/*
+    blocking_new -- the index of R, or NULL if it is not worth building
+    (or R has a cube with an empty variable, which the index cannot see)
+*/
+blocking_t *blocking_new(pcover R) {
+    blocking_t *bi;
+    pcube p, last;
+    char *mode = getenv("ESPRESSO_EXPAND");
+    int i, j, var;
+    bool empty;
+
+    if (mode != NULL && equal(mode, "scan"))
+        return NIL(blocking_t);
+    if ((mode == NULL || !equal(mode, "index")) && R->count < BLOCKING_MIN)
+        return NIL(blocking_t);
+    if ((double)cube.size * BL_WORDS(R->count) * sizeof(bl_word) >
+        BLOCKING_MAX_BYTES)
+        return NIL(blocking_t);
+
+    bi = ALLOC(blocking_t, 1);
+    bi->R = R;
+    bi->n = R->count;
+    bi->words = BL_WORDS(R->count);
+    bi->cols = ALLOC(bl_word, (size_t)cube.size * bi->words);
+    memset(bi->cols, 0, (size_t)cube.size * bi->words * sizeof(bl_word));
+    i = 0;
+    foreach_set(R, last, p) {
+        for (var = 0; var < cube.num_vars; var++) {
+            empty = TRUE;
+            for (j = cube.first_part[var]; j <= cube.last_part[var]; j++)
+                if (is_in_set(p, j)) {
+                    COL(bi, j)[i / BL_BITS] |= BL_BIT(i);
+                    empty = FALSE;
+                }
+            if (empty) {
+                FREE(bi->cols);
+                FREE(bi);
+                return NIL(blocking_t);
+            }
+        }
+        i++;
+    }
+
+    bi->shared = FALSE;
+    return scratch(bi);
+}
+
+/*
+    blocking_share -- an index of R, a copy of the cover indexed by "bi",
+    which shares the columns of "bi" (so that threads can expand cubes
+    against copies of R of their own); NULL if "bi" is
+*/
+blocking_t *blocking_share(blocking_t *bi, pcover R) {
+    blocking_t *copy;
+
+    if (bi == NIL(blocking_t))
+        return NIL(blocking_t);
+    copy = ALLOC(blocking_t, 1);
+    copy->R = R;
+    copy->n = bi->n;
+    copy->words = bi->words;
+    copy->cols = bi->cols;
+    copy->shared = TRUE;
+    return scratch(copy);
+}
+
+/* blocking_free -- release an index */
+void blocking_free(blocking_t *bi) {
+    if (bi != NIL(blocking_t)) {
+        if (!bi->shared)
+            FREE(bi->cols);
+        FREE(bi->active);
+        FREE(bi->live);
+        FREE(bi->meet);
+        FREE(bi->one);
+        FREE(bi->two);
+        FREE(bi->conf);
+        FREE(bi->var_conf);
+        FREE(bi);
+    }
+}
+
+/* blocking_of -- the index of the current context, if it indexes BB */
+static blocking_t *blocking_of(pcover BB) {
+    blocking_t *bi = current_context->blocking;
+
+    return bi != NIL(blocking_t) && bi->R == BB ? bi : NIL(blocking_t);
+}
+
+/* blocking_reset -- make every cube of BB active again, if BB is indexed */
+void blocking_reset(pcover BB) {
+    blocking_t *bi = blocking_of(BB);
+
+    if (bi != NIL(blocking_t))
+        activate(bi);
+}
+
+/* deactivate -- take the cubes of "gone" out of the active ones (and BB) */
+static void deactivate(blocking_t *bi, pcover BB, bl_word *gone) {
+    int i, k, l, nlive;
+    bl_word w;
+
+    for (nlive = l = 0; l < bi->nlive; l++) {
+        k = bi->live[l];
+        for (w = gone[k] & bi->active[k]; w != 0; w &= w - 1) {
+            i = k * BL_BITS + BL_LOWEST(w);
+            RESET(GETSET(BB, i), ACTIVE);
+            BB->active_count--;
+        }
+        if ((bi->active[k] &= ~gone[k]) != 0)
+            bi->live[nlive++] = k;
+    }
+    bi->nlive = nlive;
+}
+
+/*
+    meet -- the cubes which have a part of r in "var", in bi->meet (over
+    the live words); FALSE if r is full in "var", so that every cube does
+*/
+static bool meet(blocking_t *bi, pcube r, int var) {
+    bl_word *col;
+    int j, k, l, first = cube.first_part[var], last = cube.last_part[var];
+
+    for (j = first; j <= last && is_in_set(r, j); j++)
+        ;
+    if (j > last)
+        return FALSE;
+
+    for (l = 0; l < bi->nlive; l++)
+        bi->meet[bi->live[l]] = 0;
+    for (j = first; j <= last; j++)
+        if (is_in_set(r, j)) {
+            col = COL(bi, j);
+            for (l = 0; l < bi->nlive; l++) {
+                k = bi->live[l];
+                bi->meet[k] |= col[k];
+            }
+        }
+    return TRUE;
+}
+
+/*
+    classify -- find the active cubes at distance 1 from r (in bi->one),
+    and the parts of their conflicting variables (added to "lower");
+    FALSE if some active cube is at distance 0 from r
+*/
+static bool classify(blocking_t *bi, pcube r, pcube lower) {
+    bl_word *conf, *col, c, any;
+    int var, j, k, l;
+
+    for (l = 0; l < bi->nlive; l++) {
+        k = bi->live[l];
+        bi->one[k] = bi->two[k] = 0;
+    }
+    for (var = 0; var < cube.num_vars; var++) {
+        bi->var_conf[var] = FALSE;
+        if (!meet(bi, r, var))
+            continue;
+        conf = bi->conf + (size_t)var * bi->words;
+        for (any = 0, l = 0; l < bi->nlive; l++) {
+            k = bi->live[l];
+            c = conf[k] = bi->active[k] & ~bi->meet[k];
+            bi->two[k] |= bi->one[k] & c;
+            bi->one[k] |= c;
+            any |= c;
+        }
+        bi->var_conf[var] = any != 0;
+    }
+
+    for (l = 0; l < bi->nlive; l++) {
+        k = bi->live[l];
+        if (bi->active[k] & ~bi->one[k])
+            return FALSE;
+        bi->one[k] &= ~bi->two[k];
+    }
+
+    /* the parts of the cubes at distance 1 in the variable they conflict */
+    for (var = 0; var < cube.num_vars; var++) {
+        if (!bi->var_conf[var])
+            continue;
+        conf = bi->conf + (size_t)var * bi->words;
+        for (j = cube.first_part[var]; j <= cube.last_part[var]; j++) {
+            col = COL(bi, j);
+            for (l = 0; l < bi->nlive; l++) {
+                k = bi->live[l];
+                if (bi->one[k] & conf[k] & col[k]) {
+                    set_insert(lower, j);
+                    break;
+                }
+            }
+        }
+    }
+    return TRUE;
+}
+
+/*
+    blocking_essen -- the loop of essen_parts() over BB, by the index:
+    the cubes at distance 1 from r are made inactive, and the parts they
+    force low are added to "xlower"; FALSE if BB is not indexed
+*/
+bool blocking_essen(pcover BB, pcube r, pcube xlower) {
+    blocking_t *bi = blocking_of(BB);
+
+    if (bi == NIL(blocking_t))
+        return FALSE;
+    if (!classify(bi, r, xlower))
+        fatal("ON-set and OFF-set are not orthogonal");
+    deactivate(bi, BB, bi->one);
+    return TRUE;
+}
+
+/*
+    blocking_feasible -- feasibly_covered() by the index: TRUE (with the
+    parts forced low in "new_lower") or FALSE, or MAYBE if BB is not indexed
+*/
+int blocking_feasible(pcover BB, pcube r, pcube new_lower) {
+    blocking_t *bi = blocking_of(BB);
+
+    if (bi == NIL(blocking_t))
+        return MAYBE;
+    return classify(bi, r, new_lower);
+}
+
+/*
+    blocking_elim -- the loop of elim_lowering() over BB, by the index:
+    the cubes orthogonal to r are made inactive; FALSE if BB is not indexed
+*/
+bool blocking_elim(pcover BB, pcube r) {
+    blocking_t *bi = blocking_of(BB);
+    int var, k, l;
+
+    if (bi == NIL(blocking_t))
+        return FALSE;
+    for (var = 0; var < cube.num_vars && bi->nlive > 0; var++)
+        if (meet(bi, r, var)) {
+            for (l = 0; l < bi->nlive; l++) {
+                k = bi->live[l];
+                bi->meet[k] = ~bi->meet[k];
+            }
+            deactivate(bi, BB, bi->meet);
+        }
+    return TRUE;
+}
+
+/*
+    blocking_union -- the parts of "parts" which some active cube of BB
+    has, added to "xunion" (as essen_raising() needs); FALSE if BB is not
+    indexed
+*/
+bool blocking_union(pcover BB, pcube parts, pcube xunion) {
+    blocking_t *bi = blocking_of(BB);
+    bl_word *col;
+    int j, k, l;
+
+    if (bi == NIL(blocking_t))
+        return FALSE;
+    for (j = 0; j < cube.size; j++)
+        if (is_in_set(parts, j)) {
+            col = COL(bi, j);
+            for (l = 0; l < bi->nlive; l++) {
+                k = bi->live[l];
+                if (col[k] & bi->active[k]) {
+                    set_insert(xunion, j);
+                    break;
+                }
+            }
+        }
+    return TRUE;
+}
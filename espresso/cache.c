@@ -0,0 +1,294 @@
+/*
+    module: cache.c
+    purpose: a cache of complements and minimized covers on disk
+
+    With a cache directory (-c), the complement computed by read_pla()
+    and the cover computed by espresso() are saved as binary cover files
+    (cvrbin.c) named after a hash of what they were computed from:
+
+        complement  the cube structure, the type of the PLA and the
+                    two covers given in the input (F and D, or F and R)
+        result      the cube structure, F, D and R after read_pla(),
+                    and the options which change the result
+
+    so that reading or minimizing the same function again is only a file
+    lookup.  The sets are hashed without their flags.  An entry is used
+    only if the covers it was computed from are the ones in the entry,
+    and an entry which cannot be read is taken as a miss.
+
+    Entries are written to a temporary file and renamed into place, so
+    that several processes (or the threads of batch mode) can share a
+    directory.  A hit renews the time of an entry, and once the entries
+    take more than ESPRESSO_CACHE_SIZE megabytes (default 1024) the
+    oldest ones are removed.
+*/
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "espresso.h"
+
+#define CACHE_VERSION "espresso cache 2"
+#define CACHE_SIZE    1024 /* default size bound, in megabytes */
+#define KEY_CHARS     32   /* hex digits of a key */
+
+static char *cache_dir = NIL(char);
+static long long cache_limit;
+static struct {
+    int hits[2], misses[2];
+} cache_stats;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* cache_open -- use (and create if needed) the cache directory "dir" */
+bool cache_open(char *dir) {
+    char *env;
+
+    if (mkdir(dir, 0777) != 0 && access(dir, W_OK) != 0)
+        return FALSE;
+    cache_dir = dir;
+    env = getenv("ESPRESSO_CACHE_SIZE");
+    cache_limit = (env != NULL && atoi(env) > 0 ? atoi(env) : CACHE_SIZE) *
+                  1048576LL;
+    return TRUE;
+}
+
+/* cache_report -- print the hits and misses on "fp" */
+void cache_report(FILE *fp) {
+    if (cache_dir != NIL(char))
+        fprintf(fp, "# cache: complement %d hits %d misses, "
+                    "result %d hits %d misses\n",
+                cache_stats.hits[CACHE_COMPLEMENT],
+                cache_stats.misses[CACHE_COMPLEMENT],
+                cache_stats.hits[CACHE_RESULT],
+                cache_stats.misses[CACHE_RESULT]);
+}
+
+static void hash_word(cache_key_t *key, unsigned long long w) {
+    key->h[0] = (key->h[0] ^ w) * 0x100000001b3ULL;
+    key->h[1] = (key->h[1] ^ w) * 0x9e3779b97f4a7c15ULL;
+    key->h[1] ^= key->h[1] >> 29;
+}
+
+static void hash_string(cache_key_t *key, char *s) {
+    for (; *s != '\0'; s++)
+        hash_word(key, (unsigned char)*s);
+    hash_word(key, 0);
+}
+
+static void hash_cover(cache_key_t *key, pcover A) {
+    pcube last, p;
+    int i;
+
+    hash_word(key, A->count);
+    foreach_set(A, last, p) {
+        for (i = 1; i <= LOOP(p); i++)
+            hash_word(key, p[i]);
+    }
+}
+
+/* cache_key -- the key of "kind" for a PLA (and for "mode", for a result) */
+void cache_key(cache_key_t *key, int kind, pPLA PLA, char *mode) {
+    int var;
+
+    key->kind = kind;
+    if (cache_dir == NIL(char))
+        return;
+    key->h[0] = 0xcbf29ce484222325ULL;
+    key->h[1] = 0x6a09e667f3bcc908ULL;
+    hash_string(key, CACHE_VERSION);
+    hash_word(key, BPI);
+    hash_word(key, kind);
+    hash_word(key, cube.num_binary_vars);
+    hash_word(key, cube.num_vars);
+    for (var = 0; var < cube.num_vars; var++)
+        hash_word(key, ABS(cube.part_size[var]));
+    if (kind == CACHE_COMPLEMENT) {
+        hash_word(key, current_context->pla_type);
+        hash_cover(key, PLA->F);
+        hash_cover(key, current_context->pla_type == TYPE_FR ? PLA->R
+                                                             : PLA->D);
+    } else {
+        hash_string(key, mode);
+        hash_cover(key, PLA->F);
+        hash_cover(key, PLA->D);
+        hash_cover(key, PLA->R);
+    }
+}
+
+/* cache_name -- the file of an entry (or a temporary file if key is NULL) */
+static char *cache_name(cache_key_t *key) {
+    char *path = ALLOC(char, strlen(cache_dir) + KEY_CHARS + 2);
+
+    if (key == NULL)
+        (void)sprintf(path, "%s/tmp.XXXXXX", cache_dir);
+    else
+        (void)sprintf(path, "%s/%016llx%016llx", cache_dir, key->h[0],
+                      key->h[1]);
+    return path;
+}
+
+/* same_cover -- do A and B have the same sets (ignoring flags and SIZE) ? */
+static bool same_cover(pcover A, pcover B) {
+    int i;
+
+    if (A->count != B->count || A->wsize != B->wsize)
+        return FALSE;
+    for (i = 0; i < A->count; i++)
+        if (memcmp(GETSET(A, i) + 1, GETSET(B, i) + 1,
+                   LOOP(cube.fullset) * sizeof(set_word_t)) != 0)
+            return FALSE;
+    return TRUE;
+}
+
+/* cache_read -- the PLA of an entry, or NULL if there is none to be read */
+static pPLA cache_read(char *path) {
+    pcontext ctx = current_context;
+    jmp_buf env, *volatile save = ctx->fatal_env;
+    FILE *volatile fp;
+    pPLA volatile E = NIL(PLA_t);
+    pPLA P;
+
+    if ((fp = fopen(path, "r")) == NULL)
+        return NIL(PLA_t);
+    ctx->fatal_env = &env;
+    if (setjmp(env) != 0) {
+        /* a damaged entry: the covers read so far are abandoned */
+        E = NIL(PLA_t);
+    } else if (read_pla(fp, &P) == EOF || P->map == NULL) {
+        free_PLA(P);
+    } else {
+        E = P;
+    }
+    ctx->fatal_env = save;
+    (void)fclose(fp);
+    return E;
+}
+
+/*
+    cache_get -- take the complement (or the result) of the PLA from the
+    cache: R (or D for .type fr) for a complement, F for a result.
+*/
+bool cache_get(cache_key_t *key, pPLA PLA) {
+    char *path;
+    pPLA E;
+    bool hit = FALSE;
+
+    if (cache_dir == NIL(char))
+        return FALSE;
+    path = cache_name(key);
+    if ((E = cache_read(path)) != NIL(PLA_t)) {
+        if (key->kind == CACHE_COMPLEMENT) {
+            if (current_context->pla_type == TYPE_FR) {
+                if ((hit = same_cover(E->F, PLA->F) &&
+                           same_cover(E->R, PLA->R))) {
+                    free_cover(PLA->D);
+                    PLA->D = sf_save(E->D);
+                }
+            } else if ((hit = same_cover(E->F, PLA->F) &&
+                              same_cover(E->D, PLA->D))) {
+                free_cover(PLA->R);
+                PLA->R = sf_save(E->R);
+            }
+        } else if ((hit = same_cover(E->D, PLA->D) &&
+                          same_cover(E->R, PLA->R))) {
+            free_cover(PLA->F);
+            PLA->F = sf_save(E->F);
+        }
+        free_PLA(E);
+        if (hit)
+            (void)utimes(path, NULL);
+    }
+    FREE(path);
+
+    (void)pthread_mutex_lock(&cache_lock);
+    if (hit)
+        cache_stats.hits[key->kind]++;
+    else
+        cache_stats.misses[key->kind]++;
+    (void)pthread_mutex_unlock(&cache_lock);
+    return hit;
+}
+
+typedef struct {
+    char *name;
+    time_t time;
+    long long size;
+} cache_entry_t;
+
+/* by_age -- order entries by increasing modification time */
+static int by_age(const void *a, const void *b) {
+    time_t ta = ((cache_entry_t *)a)->time, tb = ((cache_entry_t *)b)->time;
+    return ta < tb ? -1 : ta > tb;
+}
+
+/* cache_evict -- remove the oldest entries while they exceed the bound */
+static void cache_evict() {
+    DIR *dir;
+    struct dirent *d;
+    struct stat st;
+    cache_entry_t *entry = NIL(cache_entry_t);
+    int i, n = 0, size = 0;
+    long long total = 0;
+    char *path;
+
+    if ((dir = opendir(cache_dir)) == NULL)
+        return;
+    path = ALLOC(char, strlen(cache_dir) + KEY_CHARS + 2);
+    while ((d = readdir(dir)) != NULL) {
+        if (strlen(d->d_name) != KEY_CHARS ||
+            strspn(d->d_name, "0123456789abcdef") != KEY_CHARS)
+            continue;
+        (void)sprintf(path, "%s/%s", cache_dir, d->d_name);
+        if (stat(path, &st) != 0)
+            continue;
+        if (n == size)
+            entry = REALLOC(cache_entry_t, entry, size = 2 * size + 16);
+        entry[n].name = strcpy(ALLOC(char, KEY_CHARS + 1), d->d_name);
+        entry[n].time = st.st_mtime;
+        entry[n++].size = st.st_size;
+        total += st.st_size;
+    }
+    (void)closedir(dir);
+
+    qsort(entry, n, sizeof(cache_entry_t), by_age);
+    for (i = 0; i < n; i++) {
+        if (total > cache_limit) {
+            (void)sprintf(path, "%s/%s", cache_dir, entry[i].name);
+            if (unlink(path) == 0)
+                total -= entry[i].size;
+        }
+        FREE(entry[i].name);
+    }
+    FREE(entry);
+    FREE(path);
+}
+
+/* cache_put -- save the complement (or the result) of the PLA */
+void cache_put(cache_key_t *key, pPLA PLA) {
+    char *tmp, *path;
+    FILE *fp;
+    int fd;
+    bool ok;
+
+    if (cache_dir == NIL(char))
+        return;
+    tmp = cache_name(NIL(cache_key_t));
+    if ((fd = mkstemp(tmp)) >= 0) {
+        if ((fp = fdopen(fd, "w")) == NULL) {
+            (void)close(fd);
+            (void)unlink(tmp);
+        } else {
+            fprint_binary_pla(fp, PLA);
+            ok = !ferror(fp);
+            path = cache_name(key);
+            if (fclose(fp) != 0 || !ok || rename(tmp, path) != 0)
+                (void)unlink(tmp);
+            FREE(path);
+            cache_evict();
+        }
+    }
+    FREE(tmp);
+}
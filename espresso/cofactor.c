@@ -19,6 +19,9 @@
         T[n-2]
         T[n-1] = NULL pointer (sentinel)
 
+    A cube list and its T[0] come from the stack of arena.c as a single
+    block, which free_cubelist() releases.
+
 
     Cofactoring involves repeated application of "cdist0" to check if a
     cube of the cover intersects the cofactored cube.  This can be
@@ -33,13 +36,16 @@ pcube *cofactor(pcube *T, pcube c) {
     pcube p;
     int listlen;
 
+    if (cube.setc->cofactor != NULL)
+        return (*cube.setc->cofactor)(T, c);
+
     listlen = CUBELISTSIZE(T) + 5;
 
     /* Allocate a new list of cube pointers (max size is previous size) */
-    Tc_save = Tc = ALLOC(pcube, listlen);
+    Tc_save = Tc = new_cubelist(listlen);
 
     /* pass on which variables have been cofactored against */
-    *Tc++ = set_or(new_cube(), T[0], set_diff(temp, cube.fullset, c));
+    (void)set_or(*Tc++, T[0], set_diff(temp, cube.fullset, c));
     Tc++;
 
     /* Loop for each cube in the list, determine suitability, and save */
@@ -51,7 +57,7 @@ pcube *cofactor(pcube *T, pcube c) {
 #else
             {
                 int w, last;
-                unsigned int x;
+                set_word_t x;
                 if ((last = cube.inword) != -1) {
                     x = p[last] & c[last];
                     if (~(x | x >> 1) & cube.inmask)
@@ -104,10 +110,10 @@ pcube *scofactor(pcube *T, pcube c, int var) {
     listlen = CUBELISTSIZE(T) + 5;
 
     /* Allocate a new list of cube pointers (max size is previous size) */
-    Tc_save = Tc = ALLOC(pcube, listlen);
+    Tc_save = Tc = new_cubelist(listlen);
 
     /* pass on which variables have been cofactored against */
-    *Tc++ = set_or(new_cube(), T[0], set_diff(mask, cube.fullset, c));
+    (void)set_or(*Tc++, T[0], set_diff(mask, cube.fullset, c));
     Tc++;
 
     /* Setup for the quick distance check */
@@ -134,97 +140,29 @@ void massive_count(pcube *T) {
     int *count = cdata.part_zeros;
     pcube *T1;
 
-    /* Clear the column counts (count of # zeros in each column) */
+    /*
+     * Count the number of zeros in each column: the zeros of each cube
+     * are added to bit-sliced counters a word at a time, and the counters
+     * are moved into "count" before they can overflow
+     */
     {
-        int i;
+        int i, n, nwords = LOOP(cube.fullset);
+        set_word_t val, *plane = cdata.count_planes;
+        pcube p, cof = T[0], full = cube.fullset;
+
         for (i = cube.size - 1; i >= 0; i--)
             count[i] = 0;
-    }
-
-    /* Count the number of zeros in each column */
-    {
-        int i, *cnt;
-        unsigned int val;
-        pcube p, cof = T[0], full = cube.fullset;
-        for (T1 = T + 2; (p = *T1++) != NULL;)
-            for (i = LOOP(p); i > 0; i--)
-                if ((val = full[i] & ~(p[i] | cof[i]))) {
-                    cnt = count + ((i - 1) << LOGBPI);
-#if BPI == 32
-                    if (val & 0xFF000000) {
-                        if (val & 0x80000000)
-                            cnt[31]++;
-                        if (val & 0x40000000)
-                            cnt[30]++;
-                        if (val & 0x20000000)
-                            cnt[29]++;
-                        if (val & 0x10000000)
-                            cnt[28]++;
-                        if (val & 0x08000000)
-                            cnt[27]++;
-                        if (val & 0x04000000)
-                            cnt[26]++;
-                        if (val & 0x02000000)
-                            cnt[25]++;
-                        if (val & 0x01000000)
-                            cnt[24]++;
-                    }
-                    if (val & 0x00FF0000) {
-                        if (val & 0x00800000)
-                            cnt[23]++;
-                        if (val & 0x00400000)
-                            cnt[22]++;
-                        if (val & 0x00200000)
-                            cnt[21]++;
-                        if (val & 0x00100000)
-                            cnt[20]++;
-                        if (val & 0x00080000)
-                            cnt[19]++;
-                        if (val & 0x00040000)
-                            cnt[18]++;
-                        if (val & 0x00020000)
-                            cnt[17]++;
-                        if (val & 0x00010000)
-                            cnt[16]++;
-                    }
-#endif
-                    if (val & 0xFF00) {
-                        if (val & 0x8000)
-                            cnt[15]++;
-                        if (val & 0x4000)
-                            cnt[14]++;
-                        if (val & 0x2000)
-                            cnt[13]++;
-                        if (val & 0x1000)
-                            cnt[12]++;
-                        if (val & 0x0800)
-                            cnt[11]++;
-                        if (val & 0x0400)
-                            cnt[10]++;
-                        if (val & 0x0200)
-                            cnt[9]++;
-                        if (val & 0x0100)
-                            cnt[8]++;
-                    }
-                    if (val & 0x00FF) {
-                        if (val & 0x0080)
-                            cnt[7]++;
-                        if (val & 0x0040)
-                            cnt[6]++;
-                        if (val & 0x0020)
-                            cnt[5]++;
-                        if (val & 0x0010)
-                            cnt[4]++;
-                        if (val & 0x0008)
-                            cnt[3]++;
-                        if (val & 0x0004)
-                            cnt[2]++;
-                        if (val & 0x0002)
-                            cnt[1]++;
-                        if (val & 0x0001)
-                            cnt[0]++;
-                    }
-                }
+        n = 0;
+        for (T1 = T + 2; (p = *T1++) != NULL;) {
+            for (i = nwords; i > 0; i--)
+                if ((val = full[i] & ~(p[i] | cof[i])))
+                    BITCOUNT_ADD(plane + (i - 1) * COUNT_PLANES, val);
+            if (++n == COUNT_FLUSH) {
+                bitcount_flush(plane, COUNT_PLANES, nwords, count);
+                n = 0;
+            }
+        }
+        bitcount_flush(plane, COUNT_PLANES, nwords, count);
     }
 
     /*
@@ -312,12 +250,21 @@ int binate_split_select(pcube *T, pcube cleft, pcube cright) {
     return best;
 }
 
+/* new_cubelist -- allocate a cube list of "n" pointers with an empty T[0] */
+pcube *new_cubelist(int n) {
+    pcube *T;
+
+    T = (pcube *)arena_alloc(sizeof(pcube) * n +
+                             sizeof(set_word_t) * SET_SIZE(cube.size));
+    T[0] = set_clear((pcube)(T + n), cube.size);
+    return T;
+}
+
 pcube *cube1list(pcover A) {
     pcube last, p, *plist, *list;
 
-    list = plist = ALLOC(pcube, A->count + 3);
-    *plist++ = new_cube();
-    plist++;
+    list = plist = new_cubelist(A->count + 3);
+    plist += 2;
     foreach_set(A, last, p) {
         *plist++ = p;
     }
@@ -329,9 +276,8 @@ pcube *cube1list(pcover A) {
 pcube *cube2list(pcover A, pcover B) {
     pcube last, p, *plist, *list;
 
-    list = plist = ALLOC(pcube, A->count + B->count + 3);
-    *plist++ = new_cube();
-    plist++;
+    list = plist = new_cubelist(A->count + B->count + 3);
+    plist += 2;
     foreach_set(A, last, p) {
         *plist++ = p;
     }
@@ -346,10 +292,8 @@ pcube *cube2list(pcover A, pcover B) {
 pcube *cube3list(pcover A, pcover B, pcover C) {
     pcube last, p, *plist, *list;
 
-    plist = ALLOC(pcube, A->count + B->count + C->count + 3);
-    list = plist;
-    *plist++ = new_cube();
-    plist++;
+    list = plist = new_cubelist(A->count + B->count + C->count + 3);
+    plist += 2;
     foreach_set(A, last, p) {
         *plist++ = p;
     }
@@ -7,15 +7,14 @@
 sm_col *sm_col_alloc() {
     sm_col *pcol;
 
-#ifdef FAST_AND_LOOSE
-    if (sm_col_freelist == NIL(sm_col)) {
-        pcol = ALLOC(sm_col, 1);
-    } else {
-        pcol = sm_col_freelist;
-        sm_col_freelist = pcol->next_col;
-    }
-#else
+#ifdef NO_SM_POOL
     pcol = ALLOC(sm_col, 1);
+#else
+    if (sm_pool.cols == NIL(sm_col))
+        sm_pool_refill(SM_COLS);
+    pcol = sm_pool.cols;
+    sm_pool.cols = pcol->next_col;
+    sm_pool.ncols--;
 #endif
 
     pcol->col_num = 0;
@@ -23,35 +22,28 @@ sm_col *sm_col_alloc() {
     pcol->first_row = pcol->last_row = NIL(sm_element);
     pcol->next_col = pcol->prev_col = NIL(sm_col);
     pcol->flag = 0;
-    pcol->user_word = NIL(char); /* for our user ... */
     return pcol;
 }
 
 /*
- *  free a col vector -- for FAST_AND_LOOSE, this is real cheap for cols;
- *  however, freeing a rowumn must still walk down the rowumn discarding
- *  the elements one-by-one; that is the only use for the extra '-DCOLS'
- *  compile flag ...
+ *  free a col vector -- unlike a row, the elements must be put on the
+ *  free list one-by-one, as they are linked by next_row
  */
 void sm_col_free(sm_col *pcol) {
-#if defined(FAST_AND_LOOSE) && !defined(COLS)
-    if (pcol->first_row != NIL(sm_element)) {
-        /* Add the linked list of col items to the free list */
-        pcol->last_row->next_row = sm_element_freelist;
-        sm_element_freelist = pcol->first_row;
-    }
-
-    /* Add the col to the free list of cols */
-    pcol->next_col = sm_col_freelist;
-    sm_col_freelist = pcol;
-#else
     sm_element *p, *pnext;
 
     for (p = pcol->first_row; p != 0; p = pnext) {
         pnext = p->next_row;
         sm_element_free(p);
     }
+
+#ifdef NO_SM_POOL
     FREE(pcol);
+#else
+    /* Add the col to the free list of cols */
+    pcol->next_col = sm_pool.cols;
+    sm_pool.cols = pcol;
+    sm_pool.ncols++;
 #endif
 }
 
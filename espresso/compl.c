@@ -7,6 +7,12 @@
  *  variable".  These two halves are complemented recursively, and then
  *  the results are merged.
  *
+ *  The two halves are independent until they are merged, so when there
+ *  is a thread pool, the left half of a large enough cover is
+ *  complemented as a task while the right half is done in place.  The
+ *  merge waits for both, and so the result does not depend on the
+ *  number of threads.
+ *
  *  Changes (from Version 2.1 to Version 2.2)
  *      1. Minor bug in compl_lifting -- cubes in the left half were
  *      not marked as active, so that when merging a leaf from the left
@@ -20,6 +26,21 @@
 #define USE_COMPL_LIFT       0
 #define USE_COMPL_LIFT_ONSET 1
 
+/* The left half is complemented as a task only for covers of at least
+ * COMPL_TASK_CUBES cubes, and within COMPL_TASK_DEPTH levels of the top */
+#define COMPL_TASK_CUBES 256
+#define COMPL_TASK_DEPTH 12
+
+static pcover compl_recur(pcube *T, int depth);
+
+typedef struct {
+    pcube *T;    /* cube list to cofactor (left alone) */
+    pcube c;     /* the cofactor is against c ... */
+    int var;     /* ... which is active only in var */
+    int depth;   /* recursion depth of the cofactor */
+    pcover Tbar; /* the complement of the cofactor */
+} compl_task_t;
+
 /* compl_cube -- return the complement of a single cube (De Morgan's law) */
 static pcover compl_cube(pcube p) {
     pcube diff = cube.temp[7], pdest, mask, full = cube.fullset;
@@ -44,8 +65,9 @@ static pcover compl_cube(pcube p) {
 }
 
 static bool compl_special_cases(
-    pcube *T,    /* will be disposed if answer is determined */
-    pcover *Tbar /* returned only if answer determined */
+    pcube *T,     /* will be disposed if answer is determined */
+    pcover *Tbar, /* returned only if answer determined */
+    int depth     /* recursion depth of T */
 ) {
     pcube *T1, p, ceil, cof = T[0];
     pcover A, ceil_compl;
@@ -74,18 +96,18 @@ static bool compl_special_cases(
     }
 
     /* Check for a column of all 0's which can be factored out */
-    ceil = set_save(cof);
+    ceil = set_copy(arena_cube(), cof);
     for (T1 = T + 2; (p = *T1++) != NULL;) {
         INLINEset_or(ceil, ceil, p);
     }
     if (!setp_equal(ceil, cube.fullset)) {
         ceil_compl = compl_cube(ceil);
         (void)set_or(cof, cof, set_diff(ceil, cube.fullset, ceil));
-        set_free(ceil);
-        *Tbar = sf_append(complement(T), ceil_compl);
+        arena_free(ceil);
+        *Tbar = sf_append(compl_recur(T, depth), ceil_compl);
         return TRUE;
     }
-    set_free(ceil);
+    arena_free(ceil);
 
     /* Collect column counts, determine unate variables, etc. */
     massive_count(T);
@@ -273,23 +295,51 @@ static pcover compl_merge(pcube *T1, /* Original ON-set */
     return Tbar;
 }
 
+static void compl_task(void *arg) {
+    compl_task_t *task = (compl_task_t *)arg;
+
+    /* the cofactor is taken here, so that its list belongs to the task */
+    task->Tbar =
+        compl_recur(scofactor(task->T, task->c, task->var), task->depth);
+}
+
 /* complement -- compute the complement of T */
 pcover complement(pcube *T /* T will be disposed of */
 ) {
+    return compl_recur(T, 0);
+}
+
+static pcover compl_recur(pcube *T, /* T will be disposed of */
+                          int depth) {
     pcube cl, cr;
     int best;
     pcover Tbar, Tl, Tr;
     int lifting;
+    task_group_t group = {0};
+    compl_task_t left;
 
-    if (compl_special_cases(T, &Tbar) == MAYBE) {
+    RECUR_NODE(RECUR_COMPL, depth);
+    if (compl_special_cases(T, &Tbar, depth) == MAYBE) {
         /* Allocate space for the partition cubes */
-        cl = new_cube();
-        cr = new_cube();
+        cl = arena_cube();
+        cr = arena_cube();
         best = binate_split_select(T, cl, cr);
 
         /* Complement the left and right halves */
-        Tl = complement(scofactor(T, cl, best));
-        Tr = complement(scofactor(T, cr, best));
+        if (depth < COMPL_TASK_DEPTH && CUBELISTSIZE(T) >= COMPL_TASK_CUBES &&
+            parallel_threads() > 1) {
+            left.T = T;
+            left.c = cl;
+            left.var = best;
+            left.depth = depth + 1;
+            task_spawn(&group, compl_task, &left);
+            Tr = compl_recur(scofactor(T, cr, best), depth + 1);
+            task_wait(&group);
+            Tl = left.Tbar;
+        } else {
+            Tl = compl_recur(scofactor(T, cl, best), depth + 1);
+            Tr = compl_recur(scofactor(T, cr, best), depth + 1);
+        }
 
         if (Tr->count * Tl->count > (Tr->count + Tl->count) * CUBELISTSIZE(T)) {
             lifting = USE_COMPL_LIFT_ONSET;
@@ -298,8 +348,8 @@ pcover complement(pcube *T /* T will be disposed of */
         }
         Tbar = compl_merge(T, Tl, Tr, cl, cr, best, lifting);
 
-        free_cube(cl);
-        free_cube(cr);
+        arena_free(cl);
+        arena_free(cr);
         free_cubelist(T);
     }
 
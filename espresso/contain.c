@@ -11,10 +11,45 @@
     comparing each cube to its neighbor.  Finally, because the cubes
     are sorted by size, we need only check cubes which are larger (or
     smaller) than a given cube for containment.
+
+    Most of the pairs compared there are not in containment.  Each set is
+    therefore summarized by two 64-bit signatures, the words of the set and
+    of its complement folded onto 64 bits (word i rotated by 23*i, so that
+    neighbouring words do not land on the same bits).  Folding keeps
+    inclusion, so a set can be within another only if its first signature
+    is within the other's, and the second signature of the other within
+    its own; the full check is made only for the pairs passing both tests,
+    whose signatures are read from an array rather than from the sets.
 */
 
 #include "espresso.h"
 
+/* a set and its complement, folded onto 64 bits each (see above) */
+typedef struct {
+    unsigned long long ones, zeros;
+} signature_t;
+
+#define ROTATE(w, r) ((w) << (r) | (w) >> ((64 - (r)) & 63))
+
+static void set_signature(pset p, signature_t *sig) {
+    unsigned long long w, ones = 0, zeros = 0;
+    int i, r;
+
+    for (i = LOOP(p); i > 0; i--) {
+        r = (23 * i) & 63;
+        w = (unsigned long long)p[i];
+        ones |= ROTATE(w, r);
+        w = (unsigned long long)(set_word_t)~p[i];
+        zeros |= ROTATE(w, r);
+    }
+    sig->ones = ones;
+    sig->zeros = zeros;
+}
+
+/* sig_implies -- FALSE if the set of "a" cannot be within that of "b" */
+#define sig_implies(a, b) \
+    (((a)->ones & ~(b)->ones) == 0 && ((b)->zeros & ~(a)->zeros) == 0)
+
 /*
     sf_contain -- perform containment on a set family (delete sets which
     are contained by some larger set in the family).  No assumptions are
@@ -25,14 +60,11 @@ pset_family sf_contain(pset_family A /* disposes of A */
 ) {
     int cnt;
     pset *A1;
-    pset_family R;
 
-    A1 = sf_sort(A, descend);           /* sort into descending order */
-    rm_equal(A1, descend);              /* remove duplicates */
-    cnt = rm_contain(A1);               /* remove contained sets */
-    R = sf_unlist(A1, cnt, A->sf_size); /* recreate the set family */
-    sf_free(A);
-    return R;
+    A1 = sf_sort(A, SORT_DESCEND); /* sort into descending order */
+    rm_equal(A1, descend);         /* remove duplicates */
+    cnt = rm_contain(A1);          /* remove contained sets */
+    return sf_keep(A, A1, cnt);    /* keep the others, in order */
 }
 
 /*
@@ -44,14 +76,11 @@ pset_family sf_rev_contain(pset_family A /* disposes of A */
 ) {
     int cnt;
     pset *A1;
-    pset_family R;
 
-    A1 = sf_sort(A, ascend);            /* sort into ascending order */
-    rm_equal(A1, ascend);               /* remove duplicates */
-    cnt = rm_rev_contain(A1);           /* remove containing sets */
-    R = sf_unlist(A1, cnt, A->sf_size); /* recreate the set family */
-    sf_free(A);
-    return R;
+    A1 = sf_sort(A, SORT_ASCEND); /* sort into ascending order */
+    rm_equal(A1, ascend);         /* remove duplicates */
+    cnt = rm_rev_contain(A1);     /* remove containing sets */
+    return sf_keep(A, A1, cnt);   /* keep the others, in order */
 }
 
 /* sf_dupl -- delete duplicate sets in a set family */
@@ -59,13 +88,10 @@ pset_family sf_dupl(pset_family A /* disposes of A */
 ) {
     int cnt;
     pset *A1;
-    pset_family R;
 
-    A1 = sf_sort(A, descend);           /* sort the set family */
-    cnt = rm_equal(A1, descend);        /* remove duplicates */
-    R = sf_unlist(A1, cnt, A->sf_size); /* recreate the set family */
-    sf_free(A);
-    return R;
+    A1 = sf_sort(A, SORT_DESCEND); /* sort the set family */
+    cnt = rm_equal(A1, descend);   /* remove duplicates */
+    return sf_keep(A, A1, cnt);    /* keep the others, in order */
 }
 
 /* rm_equal -- scan a sorted array of set pointers for duplicate sets */
@@ -86,70 +112,94 @@ int rm_equal(pset *A1, /* updated in place */
 /* rm_contain -- perform containment over a sorted array of set pointers */
 int rm_contain(pset *A1 /* updated in place */
 ) {
-    pset *pa, *pb, *pcheck, a, b;
-    pset *pdest = A1;
-    int last_size = -1;
+    pset *pa, a;
+    signature_t *sig, asig;
+    int k, n, ncheck = 0, last_size = -1;
+
+    for (n = 0; A1[n] != NULL; n++)
+        ;
+    sig = ALLOC(signature_t, MAX(n, 1));
 
-    /* Loop for all cubes of A1 */
-    for (pa = A1; (a = *pa++) != NULL;) {
-        /* Update the check pointer if the size has changed */
+    /* Loop for all cubes of A1; the first n are those kept so far */
+    for (n = 0, pa = A1; (a = *pa++) != NULL;) {
+        /* Update the check count if the size has changed */
         if (SIZE(a) != last_size)
-            last_size = SIZE(a), pcheck = pdest;
-        for (pb = A1; pb != pcheck;) {
-            b = *pb++;
-            INLINEsetp_implies(a, b, /* when_false => */ continue);
-            goto lnext1;
-        }
+            last_size = SIZE(a), ncheck = n;
+        set_signature(a, &asig);
+        for (k = 0; k < ncheck; k++)
+            if (sig_implies(&asig, &sig[k]) && setp_implies(a, A1[k]))
+                goto lnext1;
         /* set a was not contained by some larger set, so save it */
-        *pdest++ = a;
+        sig[n] = asig;
+        A1[n++] = a;
     lnext1:;
     }
 
-    *pdest = NULL;
-    return pdest - A1;
+    A1[n] = NULL;
+    FREE(sig);
+    return n;
 }
 
 /* rm_rev_contain -- perform rcontainment over a sorted array of set pointers */
 int rm_rev_contain(pset *A1 /* updated in place */
 ) {
-    pset *pa, *pb, *pcheck, a, b;
-    pset *pdest = A1;
-    int last_size = -1;
+    pset *pa, a;
+    signature_t *sig, asig;
+    int k, n, ncheck = 0, last_size = -1;
 
-    /* Loop for all cubes of A1 */
-    for (pa = A1; (a = *pa++) != NULL;) {
-        /* Update the check pointer if the size has changed */
+    for (n = 0; A1[n] != NULL; n++)
+        ;
+    sig = ALLOC(signature_t, MAX(n, 1));
+
+    /* Loop for all cubes of A1; the first n are those kept so far */
+    for (n = 0, pa = A1; (a = *pa++) != NULL;) {
+        /* Update the check count if the size has changed */
         if (SIZE(a) != last_size)
-            last_size = SIZE(a), pcheck = pdest;
-        for (pb = A1; pb != pcheck;) {
-            b = *pb++;
-            INLINEsetp_implies(b, a, /* when_false => */ continue);
-            goto lnext1;
-        }
+            last_size = SIZE(a), ncheck = n;
+        set_signature(a, &asig);
+        for (k = 0; k < ncheck; k++)
+            if (sig_implies(&sig[k], &asig) && setp_implies(A1[k], a))
+                goto lnext1;
         /* the set a did not contain some smaller set, so save it */
-        *pdest++ = a;
+        sig[n] = asig;
+        A1[n++] = a;
     lnext1:;
     }
 
-    *pdest = NULL;
-    return pdest - A1;
+    A1[n] = NULL;
+    FREE(sig);
+    return n;
 }
 
-/* sf_sort -- sort the sets of A */
-pset *sf_sort(pset_family A, int (*compare)(pset *, pset *)) {
-    pset p, last, *pdest, *A1;
+/* order_list -- a list of the sets of A in "order" (which is freed) */
+static pset *order_list(pset_family A, int *order) {
+    pset *A1 = ALLOC(pset, A->count + 1);
+    int i;
 
-    /* Create a single array pointing to each cube of A */
-    pdest = A1 = ALLOC(pset, A->count + 1);
+    for (i = 0; i < A->count; i++)
+        A1[i] = GETSET(A, order[i]);
+    A1[i] = NULL; /* Sentinel */
+    FREE(order);
+    return A1;
+}
+
+/*
+    sf_sort -- a list of the sets of A by size (SORT_ASCEND or SORT_DESCEND,
+    as ascend() or descend() order them), with their sizes in SIZE
+*/
+pset *sf_sort(pset_family A, int order) {
+    pset p, last, *A1;
+    unsigned int *key;
+    int i;
+
+    key = ALLOC(unsigned int, MAX(A->count, 1));
+    i = 0;
     foreach_set(A, last, p) {
         PUTSIZE(p, set_ord(p)); /* compute the set size */
-        *pdest++ = p;           /* save the pointer */
+        key[i++] = SIZE(p);
     }
-    *pdest = NULL; /* Sentinel -- never seen by sort */
-
-    /* Sort cubes by size */
-    qsort((char *)A1, A->count, sizeof(pset),
-          (int (*)(const void *, const void *))compare);
+    A1 = order_list(A, sf_order(A, key, NIL(set_word_t), order));
+    FREE(key);
     return A1;
 }
 
@@ -208,14 +258,12 @@ pset_family dist_merge(pset_family A, /* disposes of A */
 ) {
     pset *A1;
     int cnt;
-    pset_family R;
 
+    /* sort as d1_order() does, and merge the sets equal under the mask */
     set_copy(cube.temp[0], mask);
-    A1 = sf_sort(A, d1_order);
+    A1 = order_list(A, sf_order(A, NIL(unsigned int), mask, SORT_DESCEND));
     cnt = d1_rm_equal(A1, d1_order);
-    R = sf_unlist(A1, cnt, A->sf_size);
-    sf_free(A);
-    return R;
+    return sf_keep(A, A1, cnt);
 }
 
 /*
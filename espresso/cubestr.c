@@ -1,9 +1,44 @@
 /*
-    Module: cubestr.c -- routines for managing the global cube structure
+    Module: cubestr.c -- routines for managing the cube structure and the
+    minimizer context
 */
 
 #include "espresso.h"
 
+/* scratch_setup -- allocate the temporary cubes and the cdata counters */
+static void scratch_setup() {
+    int i;
+
+    cube.temp = ALLOC(pset, CUBE_TEMP);
+    for (i = 0; i < CUBE_TEMP; i++)
+        cube.temp[i] = new_cube();
+
+    cdata.part_zeros = ALLOC(int, cube.size);
+    cdata.var_zeros = ALLOC(int, cube.num_vars);
+    cdata.parts_active = ALLOC(int, cube.num_vars);
+    cdata.is_unate = ALLOC(int, cube.num_vars);
+    cdata.count_planes = ALLOC(set_word_t, SET_SIZE(cube.size) * COUNT_PLANES);
+    for (i = SET_SIZE(cube.size) * COUNT_PLANES - 1; i >= 0; i--)
+        cdata.count_planes[i] = 0;
+}
+
+/* scratch_setdown -- free what scratch_setup() allocated */
+static void scratch_setdown() {
+    int i;
+
+    for (i = 0; i < CUBE_TEMP; i++)
+        free_cube(cube.temp[i]);
+    FREE(cube.temp);
+
+    FREE(cdata.part_zeros);
+    FREE(cdata.var_zeros);
+    FREE(cdata.parts_active);
+    FREE(cdata.is_unate);
+    FREE(cdata.count_planes);
+    cdata.part_zeros = cdata.var_zeros = cdata.parts_active = (int *)NULL;
+    cdata.is_unate = (bool *)NULL;
+}
+
 /*
     cube_setup -- assume that the fields "num_vars", "num_binary_vars", and
     part_size[num_binary_vars .. num_vars-1] are setup, and initialize the
@@ -55,16 +90,11 @@ void cube_setup() {
         cube.inmask = cube.binary_mask[cube.inword] & DISJOINT;
     }
 
-    cube.temp = ALLOC(pset, CUBE_TEMP);
-    for (i = 0; i < CUBE_TEMP; i++)
-        cube.temp[i] = new_cube();
     cube.fullset = set_fill(new_cube(), cube.size);
     cube.emptyset = new_cube();
+    cube.setc = setc_select();
 
-    cdata.part_zeros = ALLOC(int, cube.size);
-    cdata.var_zeros = ALLOC(int, cube.num_vars);
-    cdata.parts_active = ALLOC(int, cube.num_vars);
-    cdata.is_unate = ALLOC(int, cube.num_vars);
+    scratch_setup();
 }
 
 /*
@@ -75,7 +105,7 @@ void cube_setup() {
     external routine limit on the IBM !)
 */
 void setdown_cube() {
-    int i, var;
+    int var;
 
     FREE(cube.first_part);
     FREE(cube.last_part);
@@ -91,14 +121,8 @@ void setdown_cube() {
         free_cube(cube.var_mask[var]);
     FREE(cube.var_mask);
 
-    for (i = 0; i < CUBE_TEMP; i++)
-        free_cube(cube.temp[i]);
-    FREE(cube.temp);
-
-    FREE(cdata.part_zeros);
-    FREE(cdata.var_zeros);
-    FREE(cdata.parts_active);
-    FREE(cdata.is_unate);
+    scratch_setdown();
+    memo_free(current_context);
 
     cube.first_part = cube.last_part = (int *)NULL;
     cube.first_word = cube.last_word = (int *)NULL;
@@ -106,7 +130,108 @@ void setdown_cube() {
     cube.binary_mask = cube.mv_mask = (pcube)NULL;
     cube.fullset = cube.emptyset = (pcube)NULL;
     cube.var_mask = cube.temp = (pcube *)NULL;
+}
 
-    cdata.part_zeros = cdata.var_zeros = cdata.parts_active = (int *)NULL;
-    cdata.is_unate = (bool *)NULL;
+/*
+    context_new -- create an empty context; the cube structure is set up
+    by the first PLA read while the context is current
+*/
+pcontext context_new() {
+    pcontext ctx;
+
+    ctx = ALLOC(context_t, 1);
+    memset(ctx, 0, sizeof(context_t));
+    ctx->toggle = TRUE;
+    ctx->pla_type = TYPE_FD;
+    ctx->phase = -1;
+    return ctx;
+}
+
+/*
+    context_share -- create a context with the same cube geometry as
+    "parent" but with private temporary cubes and cdata counters.  The
+    parent must outlive the shared context.
+*/
+pcontext context_share(pcontext parent) {
+    pcontext ctx, save;
+
+    ctx = context_new();
+    ctx->cube_st = parent->cube_st;
+    ctx->toggle = parent->toggle;
+    ctx->pla_type = parent->pla_type;
+    ctx->care = parent->care;
+    ctx->start = parent->start;
+    ctx->phase = parent->phase;
+    ctx->parent = parent;
+
+    save = context_set(ctx);
+    scratch_setup();
+    (void)context_set(save);
+    return ctx;
+}
+
+/*
+    context_free -- release everything owned by a context (for a shared
+    context, the geometry belongs to the parent and is left alone)
+*/
+void context_free(pcontext ctx) {
+    pcontext save;
+
+    profile_merge(ctx);
+    save = context_set(ctx);
+    if (ctx->parent != NULL) {
+        scratch_setdown();
+    } else if (cube.fullset != NULL) {
+        FREE(cube.part_size);
+        setdown_cube();
+    }
+    sf_cleanup();
+    arena_release(ctx);
+    (void)context_set(save == ctx ? NULL : save);
+    FREE(ctx);
+}
+
+/*
+    context_reset -- make a context (not a shared one) ready for another
+    PLA, keeping the storage it has gathered: the largest chunk of its
+    stack, the set families released to it, and (with "keep_cube", for a
+    PLA of the same shape) the cube structure and the memo
+*/
+void context_reset(pcontext ctx, bool keep_cube) {
+    pcontext save;
+
+    profile_merge(ctx);
+    save = context_set(ctx);
+    if (!keep_cube) {
+        if (cube.fullset != NULL)
+            setdown_cube();
+        FREE(cube.part_size);
+    }
+    (void)context_set(save);
+    arena_reset(ctx);
+
+    ctx->toggle = TRUE;
+    ctx->pla_type = TYPE_FD;
+    ctx->lineno = 0;
+    ctx->line_length_error = FALSE;
+    ctx->fatal_env = NULL;
+    ctx->truncated = FALSE;
+    ctx->blocking = NULL;
+    ctx->unwrap_flipped = FALSE;
+    ctx->seed = 0;
+    ctx->cancel = NULL;
+    ctx->care = NULL;
+    ctx->start = NULL;
+    ctx->phase = -1;
+}
+
+/*
+    context_set -- make "ctx" the current context of the calling thread
+    and return the previous one (NULL reinstalls the default context)
+*/
+pcontext context_set(pcontext ctx) {
+    pcontext save = current_context;
+
+    current_context = ctx != NULL ? ctx : &default_context;
+    return save;
 }
@@ -0,0 +1,175 @@
+/*
+    module: cvrbin.c
+    purpose: binary cover files
+
+    A binary cover file holds the cube structure and the words of the F,
+    D and R covers as they are in memory, so that a stage of a flow can
+    hand a cover and its OFF-set to the next without printing, parsing
+    or complementing anything.  When the file is mapped, the covers are
+    left in the mapping rather than copied (see sf_mapped()).
+
+    Layout, in the byte order of the machine, each part starting on a
+    multiple of 8 bytes:
+
+        header      magic, version, byte order mark, BPI,
+                    num_binary_vars, num_vars
+        part_size   num_vars sizes
+        F, D, R     count and wsize, then count * wsize set words
+*/
+
+#include <stdint.h>
+
+#include "espresso.h"
+
+#define BINARY_VERSION 2
+#define BINARY_ORDER   0x01020304
+#define BINARY_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+static const char binary_magic[8] = "\211ECOVER\n";
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t order;
+    uint32_t bpi;
+    uint32_t num_binary_vars;
+    uint32_t num_vars;
+    uint32_t unused;
+} binary_header_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t wsize;
+} binary_cover_t;
+
+/* is_binary_pla -- does "buf" start with a binary cover file ? */
+bool is_binary_pla(const char *buf, size_t len) {
+    return len >= sizeof(binary_magic) &&
+           memcmp(buf, binary_magic, sizeof(binary_magic)) == 0;
+}
+
+/* binary_cube -- set up the cube structure, or check it matches the file */
+static void binary_cube(binary_header_t *h, const char *part) {
+    uint32_t i, size;
+    bool same;
+
+    if (h->num_vars < 1 || h->num_binary_vars >= h->num_vars ||
+        h->num_vars > INT_MAX / 2)
+        fatal("silly cube structure in binary cover");
+
+    if (cube.fullset == NULL) {
+        cube.num_binary_vars = (int)h->num_binary_vars;
+        cube.num_vars = (int)h->num_vars;
+        cube.part_size = ALLOC(int, cube.num_vars);
+        for (i = 0; i < h->num_vars; i++) {
+            memcpy(&size, part + i * sizeof(size), sizeof(size));
+            if (size == 0 || size > INT_MAX / 2)
+                fatal("silly part size in binary cover");
+            cube.part_size[i] = (int)size;
+        }
+        cube_setup();
+    } else {
+        same = cube.num_binary_vars == (int)h->num_binary_vars &&
+               cube.num_vars == (int)h->num_vars;
+        for (i = 0; same && i < h->num_vars; i++) {
+            memcpy(&size, part + i * sizeof(size), sizeof(size));
+            same = ABS(cube.part_size[i]) == (int)size;
+        }
+        if (!same)
+            fatal("binary cover does not match the cube structure");
+    }
+}
+
+/*
+    read_binary_pla -- load the covers of the binary cover file at "buf"
+
+    The covers are left in "buf" when "mapped" is set (buf must then be
+    aligned and outlive them), and copied otherwise.  Returns the number
+    of bytes of the file.
+*/
+size_t read_binary_pla(pPLA PLA, char *buf, size_t len, bool mapped) {
+    binary_header_t h;
+    binary_cover_t c;
+    pcover *cover[3];
+    size_t pos, bytes;
+    int i;
+
+    if (len < sizeof(h))
+        fatal("truncated binary cover");
+    memcpy(&h, buf, sizeof(h));
+    if (h.version != BINARY_VERSION)
+        fatal("unknown version of binary cover");
+    if (h.order != BINARY_ORDER)
+        fatal("binary cover written with another byte order");
+    if (h.bpi != BPI)
+        fatal("binary cover written with another word size");
+    pos = sizeof(h);
+    if ((len - pos) / sizeof(c.count) < h.num_vars)
+        fatal("truncated binary cover");
+    binary_cube(&h, buf + pos);
+    pos += BINARY_ALIGN(h.num_vars * sizeof(c.count));
+
+    cover[0] = &PLA->F, cover[1] = &PLA->D, cover[2] = &PLA->R;
+    for (i = 0; i < 3; i++) {
+        if (len < pos || len - pos < sizeof(c))
+            fatal("truncated binary cover");
+        memcpy(&c, buf + pos, sizeof(c));
+        pos += sizeof(c);
+        if (c.wsize != (uint32_t)SET_SIZE(cube.size) || c.count > INT_MAX)
+            fatal("silly cover size in binary cover");
+        if ((len - pos) / (c.wsize * sizeof(set_word_t)) < c.count)
+            fatal("truncated binary cover");
+        bytes = (size_t)c.count * c.wsize * sizeof(set_word_t);
+        if (mapped) {
+            *cover[i] = sf_mapped((pset)(buf + pos), (int)c.count, cube.size);
+        } else {
+            *cover[i] = new_cover((int)c.count);
+            memcpy((*cover[i])->data, buf + pos, bytes);
+            (*cover[i])->count = (int)c.count;
+        }
+        pos += BINARY_ALIGN(bytes);
+    }
+    return MIN(pos, len);
+}
+
+/* binary_write -- write "bytes" bytes, padded to a multiple of 8 */
+static void binary_write(FILE *fp, const void *p, size_t bytes) {
+    static const char zeros[8];
+
+    (void)fwrite(p, 1, bytes, fp);
+    (void)fwrite(zeros, 1, BINARY_ALIGN(bytes) - bytes, fp);
+}
+
+/* fprint_binary_pla -- write the covers of a PLA as a binary cover file */
+void fprint_binary_pla(FILE *fp, pPLA PLA) {
+    binary_header_t h;
+    binary_cover_t c;
+    pcover cover[3];
+    uint32_t *part;
+    int i;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, binary_magic, sizeof(binary_magic));
+    h.version = BINARY_VERSION;
+    h.order = BINARY_ORDER;
+    h.bpi = BPI;
+    h.num_binary_vars = cube.num_binary_vars;
+    h.num_vars = cube.num_vars;
+    binary_write(fp, &h, sizeof(h));
+
+    part = ALLOC(uint32_t, cube.num_vars);
+    for (i = 0; i < cube.num_vars; i++)
+        part[i] = ABS(cube.part_size[i]);
+    binary_write(fp, part, cube.num_vars * sizeof(uint32_t));
+    FREE(part);
+
+    cover[0] = PLA->F, cover[1] = PLA->D, cover[2] = PLA->R;
+    for (i = 0; i < 3; i++) {
+        c.count = cover[i] == NULL ? 0 : cover[i]->count;
+        c.wsize = SET_SIZE(cube.size);
+        (void)fwrite(&c, 1, sizeof(c), fp);
+        if (c.count > 0)
+            binary_write(fp, cover[i]->data,
+                         (size_t)c.count * c.wsize * sizeof(set_word_t));
+    }
+}
@@ -3,86 +3,226 @@
     purpose: cube and cover input routines
 */
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "espresso.h"
 
-static bool line_length_error;
-static int lineno;
+/* the parser state lives in the current context */
+#define line_length_error (current_context->line_length_error)
+#define lineno            (current_context->lineno)
+#define pla_type          (current_context->pla_type)
 
-pla_type_t pla_type = TYPE_FD;
+/*
+    The input is scanned from memory rather than through getc(): a regular
+    file is mapped, anything else (a pipe, a terminal) is read into a
+    buffer in large blocks.  The scanning routines below consume exactly
+    the characters the stdio routines they replace would consume, so the
+    syntax accepted and the line numbers of the warnings are unchanged.
+
+    read_pla() also accepts the binary cover files of cvrbin.c; the
+    mapping of such a file is kept by the PLA, whose covers lie in it.
+*/
+
+#define INPUT_BLOCK (1 << 20) /* bytes read at a time when not mapped */
+
+typedef struct {
+    const char *buf; /* the text */
+    size_t len;      /* bytes in buf */
+    size_t pos;      /* next byte to scan */
+    void *map;       /* the mapping (or NULL) */
+    char *data;      /* the buffer read (or NULL) */
+} pla_input_t;
+
+static int read_input(pla_input_t *in, FILE *fp, pPLA *PLA_return);
+
+#define in_getc(in) \
+    ((in)->pos < (in)->len ? (unsigned char)(in)->buf[(in)->pos++] : EOF)
+
+/* input_open -- make the rest of "fp" available in memory */
+static void input_open(pla_input_t *in, FILE *fp) {
+    struct stat st;
+    long start;
+    size_t n, size;
+
+    in->map = NULL;
+    in->data = NIL(char);
+
+    if ((start = ftell(fp)) >= 0 && fstat(fileno(fp), &st) == 0 &&
+        S_ISREG(st.st_mode) && st.st_size > start) {
+        in->map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fileno(fp), 0);
+        if (in->map == MAP_FAILED) {
+            in->map = NULL;
+        } else {
+            in->buf = (const char *)in->map;
+            in->len = (size_t)st.st_size;
+            in->pos = (size_t)start;
+            return;
+        }
+    }
+
+    size = INPUT_BLOCK;
+    in->data = ALLOC(char, size);
+    in->len = in->pos = 0;
+    while ((n = fread(in->data + in->len, 1, size - in->len, fp)) > 0)
+        if ((in->len += n) == size)
+            in->data = REALLOC(char, in->data, size *= 2);
+    in->buf = in->data;
+}
 
-void skip_line(FILE *fpin) {
+/*
+    input_close -- release the text, leaving "fp" after what was scanned
+    (NULL for a text in memory)
+*/
+static void input_close(pla_input_t *in, FILE *fp) {
+    if (in->map != NULL)
+        (void)munmap(in->map, in->len);
+    if (in->data == NIL(char) && fp != NULL)
+        (void)fseek(fp, (long)in->pos, SEEK_SET);
+    FREE(in->data);
+}
+
+/* input_lines -- number of lines left in the input (a bound on the cubes) */
+static int input_lines(pla_input_t *in) {
+    const char *p = in->buf + in->pos, *end = in->buf + in->len;
+    int n = 1;
+
+    while ((p = memchr(p, '\n', end - p)) != NULL)
+        p++, n++;
+    return n;
+}
+
+static void skip_line(pla_input_t *in) {
     int ch;
-    while ((ch = getc(fpin)) != EOF && ch != '\n')
+    while ((ch = in_getc(in)) != EOF && ch != '\n')
         ;
     lineno++;
 }
 
-char *get_word(FILE *fp, char *word) {
+static char *get_word(pla_input_t *in, char *word, int size) {
     int ch, i = 0;
-    while ((ch = getc(fp)) != EOF && isspace(ch))
+    while ((ch = in_getc(in)) != EOF && isspace(ch))
         ;
     word[i++] = ch;
-    while ((ch = getc(fp)) != EOF && !isspace(ch))
-        word[i++] = ch;
+    while ((ch = in_getc(in)) != EOF && !isspace(ch))
+        if (i < size - 1)
+            word[i++] = ch;
     word[i] = '\0';
     return word;
 }
 
+/* get_int -- read a decimal number as fscanf(fp, "%d", value) does */
+static int get_int(pla_input_t *in, int *value) {
+    int ch, sign = 1, ndigits = 0;
+    long v = 0;
+
+    while ((ch = in_getc(in)) != EOF && isspace(ch))
+        ;
+    if (ch == '-' || ch == '+') {
+        sign = ch == '-' ? -1 : 1;
+        ch = in_getc(in);
+    }
+    for (; ch != EOF && isdigit(ch); ch = in_getc(in), ndigits++)
+        v = v <= INT_MAX / 10 ? v * 10 + (ch - '0') : INT_MAX;
+    if (ch != EOF)
+        in->pos--;
+    if (ndigits == 0)
+        return 0;
+    *value = sign * (int)MIN(v, INT_MAX);
+    return 1;
+}
+
+/* get_count -- the number on the rest of the line (0 if there is none) */
+static int get_count(pla_input_t *in) {
+    size_t i = in->pos;
+    long v = 0;
+
+    while (i < in->len && (in->buf[i] == ' ' || in->buf[i] == '\t'))
+        i++;
+    for (; i < in->len && isdigit((unsigned char)in->buf[i]); i++)
+        v = MIN(v * 10 + (in->buf[i] - '0'), INT_MAX);
+    return (int)v;
+}
+
+/*
+ *  Classes of the characters of a product term.  A binary variable takes
+ *  its two bits from the low bits of its class (BIN_CODE).
+ */
+#define IN_BAD     0 /* not allowed (also EOF) */
+#define IN_SKIP    1 /* separator */
+#define IN_NEWLINE 2 /* the term continues on the next line */
+#define BIN_CODE   4 /* binary value, plus the two bits of the variable */
+#define OUT_NONE   4 /* output value: in none of F, D, R */
+#define OUT_F      5
+#define OUT_R      6
+#define OUT_D      7
+
+static const unsigned char binary_class[256] = {
+    [' '] = IN_SKIP,      ['|'] = IN_SKIP,      ['\t'] = IN_SKIP,
+    ['\n'] = IN_NEWLINE,  ['?'] = BIN_CODE | 0, ['0'] = BIN_CODE | 1,
+    ['1'] = BIN_CODE | 2, ['2'] = BIN_CODE | 3, ['-'] = BIN_CODE | 3,
+};
+
+static const unsigned char output_class[256] = {
+    [' '] = IN_SKIP,     ['|'] = IN_SKIP, ['\t'] = IN_SKIP, ['\n'] = IN_NEWLINE,
+    ['~'] = OUT_NONE,    ['1'] = OUT_F,   ['4'] = OUT_F,    ['0'] = OUT_R,
+    ['3'] = OUT_R,       ['2'] = OUT_D,   ['-'] = OUT_D,
+};
+
+#define CLASS(table, ch) ((ch) == EOF ? IN_BAD : (table)[ch])
+
+static void spans_lines(void) {
+    if (!line_length_error)
+        fprintf(stderr, "product term(s) %s\n",
+                "span more than one line (warning only)");
+    line_length_error = TRUE;
+    lineno++;
+}
+
 /*
  *  Yes, I know this routine is a mess
  */
-void read_cube(FILE *fp, pPLA PLA) {
-    int var, i;
+static void read_cube(pla_input_t *in, pPLA PLA) {
+    int var, i, ch, c, w, shift;
     pcube cf = cube.temp[0], cr = cube.temp[1], cd = cube.temp[2];
     bool savef = FALSE, saved = FALSE, saver = FALSE;
+    set_word_t word, wf, wr, wd;
 
     set_clear(cf, cube.size);
 
-    /* Loop and read binary variables */
-    for (var = 0; var < cube.num_binary_vars; var++)
-        switch (getc(fp)) {
-            case EOF:
+    /* Loop and read binary variables, packing their bits a word at a time */
+    w = 1, shift = 0, word = 0;
+    for (var = 0; var < cube.num_binary_vars;) {
+        ch = in_getc(in);
+        switch (c = CLASS(binary_class, ch)) {
+            case IN_BAD:
                 goto bad_char;
-            case '\n':
-                if (!line_length_error)
-                    fprintf(stderr, "product term(s) %s\n",
-                            "span more than one line (warning only)");
-                line_length_error = TRUE;
-                lineno++;
-                var--;
+            case IN_NEWLINE:
+                spans_lines();
                 break;
-            case ' ':
-            case '|':
-            case '\t':
-                var--;
-                break;
-            case '2':
-            case '-':
-                set_insert(cf, var * 2 + 1);
-            case '0':
-                set_insert(cf, var * 2);
-                break;
-            case '1':
-                set_insert(cf, var * 2 + 1);
-                break;
-            case '?':
+            case IN_SKIP:
                 break;
             default:
-                goto bad_char;
+                word |= (set_word_t)(c & 3) << shift;
+                var++;
+                if ((shift += 2) == BPI) {
+                    cf[w++] = word;
+                    shift = 0, word = 0;
+                }
         }
+    }
+    if (shift != 0)
+        cf[w] = word;
 
     /* Loop for the all but one of the multiple-valued variables */
     for (var = cube.num_binary_vars; var < cube.num_vars - 1; var++)
         for (i = cube.first_part[var]; i <= cube.last_part[var]; i++)
-            switch (getc(fp)) {
+            switch (in_getc(in)) {
                 case EOF:
                     goto bad_char;
                 case '\n':
-                    if (!line_length_error)
-                        fprintf(stderr, "product term(s) %s\n",
-                                "span more than one line (warning only)");
-                    line_length_error = TRUE;
-                    lineno++;
+                    spans_lines();
                     i--;
                     break;
                 case ' ':
@@ -101,41 +241,35 @@ void read_cube(FILE *fp, pPLA PLA) {
     /* Loop for last multiple-valued variable */
     set_copy(cr, cf);
     set_copy(cd, cf);
-    for (i = cube.first_part[var]; i <= cube.last_part[var]; i++)
-        switch (getc(fp)) {
-            case EOF:
+    i = cube.first_part[var];
+    w = WHICH_WORD(i), wf = wr = wd = 0;
+    while (i <= cube.last_part[var]) {
+        ch = in_getc(in);
+        switch (CLASS(output_class, ch)) {
+            case IN_BAD:
                 goto bad_char;
-            case '\n':
-                if (!line_length_error)
-                    fprintf(stderr, "product term(s) %s\n",
-                            "span more than one line (warning only)");
-                line_length_error = TRUE;
-                lineno++;
-                i--;
-                break;
-            case ' ':
-            case '|':
-            case '\t':
-                i--;
+            case IN_NEWLINE:
+                spans_lines();
+                continue;
+            case IN_SKIP:
+                continue;
+            case OUT_F:
+                wf |= BIT(i), savef = TRUE;
                 break;
-            case '4':
-            case '1':
-                set_insert(cf, i), savef = TRUE;
-                break;
-            case '3':
-            case '0':
+            case OUT_R:
                 if (pla_type == TYPE_FR)
-                    set_insert(cr, i), saver = TRUE;
+                    wr |= BIT(i), saver = TRUE;
                 break;
-            case '2':
-            case '-':
+            case OUT_D:
                 if (pla_type == TYPE_FD)
-                    set_insert(cd, i), saved = TRUE;
-            case '~':
+                    wd |= BIT(i), saved = TRUE;
                 break;
-            default:
-                goto bad_char;
         }
+        if (WHICH_BIT(++i) == 0 || i > cube.last_part[var]) {
+            cf[w] |= wf, cr[w] |= wr, cd[w] |= wd;
+            w++, wf = wr = wd = 0;
+        }
+    }
     if (savef)
         PLA->F = sf_addset(PLA->F, cf);
     if (saved)
@@ -146,19 +280,19 @@ void read_cube(FILE *fp, pPLA PLA) {
 
 bad_char:
     fprintf(stderr, "(warning): input line #%d ignored\n", lineno);
-    skip_line(fp);
+    skip_line(in);
     return;
 }
 
-void parse_pla(FILE *fp, pPLA PLA) {
-    int ch;
+static void parse_input(pla_input_t *in, pPLA PLA) {
+    int ch, n, npterms = 0;
     char word[256];
 
     lineno = 1;
     line_length_error = FALSE;
 
 loop:
-    switch (ch = getc(fp)) {
+    switch (ch = in_getc(in)) {
         case EOF:
             return;
 
@@ -173,12 +307,14 @@ loop:
 
         case '.':
             /* .i gives the cube input size (binary-functions only) */
-            if (equal(get_word(fp, word), "i")) {
+            if (equal(get_word(in, word, sizeof(word)), "i")) {
                 if (cube.fullset != NULL) {
-                    fprintf(stderr, "extra .i ignored\n");
-                    skip_line(fp);
+                    /* (a cover of the same function repeats it) */
+                    if (get_int(in, &n) != 1 || n != cube.num_binary_vars)
+                        fprintf(stderr, "extra .i ignored\n");
+                    skip_line(in);
                 } else {
-                    if (fscanf(fp, "%d", &cube.num_binary_vars) != 1)
+                    if (get_int(in, &cube.num_binary_vars) != 1)
                         fatal("error reading .i");
                     if (cube.num_binary_vars <= 0)
                         fatal("silly value in .i");
@@ -189,13 +325,14 @@ loop:
                 /* .o gives the cube output size (binary-functions only) */
             } else if (equal(word, "o")) {
                 if (cube.fullset != NULL) {
-                    fprintf(stderr, "extra .o ignored\n");
-                    skip_line(fp);
+                    if (get_int(in, &n) != 1 ||
+                        n != cube.part_size[cube.num_vars - 1])
+                        fprintf(stderr, "extra .o ignored\n");
+                    skip_line(in);
                 } else {
                     if (cube.part_size == NULL)
                         fatal(".o cannot appear before .i");
-                    if (fscanf(fp, "%d",
-                               &(cube.part_size[cube.num_vars - 1])) != 1)
+                    if (get_int(in, &(cube.part_size[cube.num_vars - 1])) != 1)
                         fatal("error reading .o");
                     if (cube.part_size[cube.num_vars - 1] <= 0)
                         fatal("silly value in .i");
@@ -204,8 +341,9 @@ loop:
 
                 /* .type specifies a logical type for the PLA */
             } else if (equal(word, "type")) {
-                (void)get_word(fp, word);
-                if (equal(word, "fd")) {
+                (void)get_word(in, word, sizeof(word));
+                /* f (the ON-set alone) is what espresso writes */
+                if (equal(word, "fd") || equal(word, "f")) {
                     pla_type = TYPE_FD;
                 } else if (equal(word, "fr")) {
                     pla_type = TYPE_FR;
@@ -216,31 +354,62 @@ loop:
                 /* .e and .end specify the end of the file */
             } else if (equal(word, "e") || equal(word, "end"))
                 return;
-            /* .p is ignored */
-            else if (equal(word, "p"))
-                skip_line(fp);
-            else {
+            /* .p only helps to size the covers */
+            else if (equal(word, "p")) {
+                npterms = get_count(in);
+                skip_line(in);
+            } else {
                 fprintf(stderr, "%c%s unrecognized\n", ch, word);
-                skip_line(fp);
+                skip_line(in);
             }
             break;
         default:
-            (void)ungetc(ch, fp);
+            in->pos--;
             if (cube.fullset == NULL) {
                 /*		fatal("unknown PLA size, need .i/.o or .mv");*/
-                skip_line(fp);
+                skip_line(in);
                 break;
             }
             if (PLA->F == NULL) {
-                PLA->F = new_cover(10);
+                /* no more cubes than lines left, nor (usually) than .p */
+                n = input_lines(in);
+                if (npterms > 0)
+                    n = MIN(n, npterms);
+                PLA->F = new_cover(n);
                 PLA->D = new_cover(10);
-                PLA->R = new_cover(10);
+                PLA->R = new_cover(pla_type == TYPE_FR ? n : 10);
             }
-            read_cube(fp, PLA);
+            read_cube(in, PLA);
     }
     goto loop;
 }
 
+/* parse_pla -- read the cubes and the keywords of a PLA from "fp" */
+void parse_pla(FILE *fp, pPLA PLA) {
+    pla_input_t in;
+
+    input_open(&in, fp);
+    parse_input(&in, PLA);
+    input_close(&in, fp);
+}
+
+/*
+    read_start -- read the cover written by an earlier run for the PLA
+    which has been read (its ON-set; the .type of the PLA is kept)
+*/
+pcover read_start(FILE *fp) {
+    pPLA PLA = new_PLA();
+    pla_type_t type = pla_type;
+    pcover S;
+
+    parse_pla(fp, PLA);
+    pla_type = type;
+    S = PLA->F != NULL ? PLA->F : new_cover(0);
+    PLA->F = NULL;
+    free_PLA(PLA);
+    return S;
+}
+
 /*
     read_pla -- read a PLA from a file
 
@@ -256,14 +425,51 @@ loop:
         > 0	 : Operation successful
 */
 int read_pla(FILE *fp, pPLA *PLA_return) {
+    pla_input_t in;
+
+    input_open(&in, fp);
+    return read_input(&in, fp, PLA_return);
+}
+
+/* read_pla_text -- read_pla() from the "len" bytes at "text" */
+int read_pla_text(const char *text, size_t len, pPLA *PLA_return) {
+    pla_input_t in;
+
+    in.buf = text;
+    in.len = len;
+    in.pos = 0;
+    in.map = NULL;
+    in.data = NIL(char);
+    return read_input(&in, NULL, PLA_return);
+}
+
+/* read_input -- read_pla() from the input opened, closing it */
+static int read_input(pla_input_t *in, FILE *fp, pPLA *PLA_return) {
     pPLA PLA;
+    cache_key_t key;
+    bool mapped;
     int i;
 
     /* Allocate and initialize the PLA structure */
     PLA = *PLA_return = new_PLA();
 
+    /* A binary cover file has all three covers (and stays mapped) */
+    if (is_binary_pla(in->buf + in->pos, in->len - in->pos)) {
+        mapped = in->map != NULL && in->pos % 8 == 0;
+        in->pos += read_binary_pla(PLA, (char *)in->buf + in->pos,
+                                   in->len - in->pos, mapped);
+        if (mapped) {
+            PLA->map = in->map;
+            PLA->map_size = in->len;
+            in->map = NULL;
+        }
+        input_close(in, fp);
+        return 1;
+    }
+
     /* Read the pla */
-    parse_pla(fp, PLA);
+    parse_input(in, PLA);
+    input_close(in, fp);
 
     /* Check for nothing on the file -- implies reached EOF */
     if (PLA->F == NULL) {
@@ -275,17 +481,29 @@ int read_pla(FILE *fp, pPLA *PLA_return) {
         cube.part_size[i] = ABS(cube.part_size[i]);
     }
 
+    /* reduced OFF-sets are used instead of R (see offset.c) */
+    if (pla_type == TYPE_FD && reduced_offsets)
+        return 1;
+
+    /* the complement may be known from an earlier run */
+    cache_key(&key, CACHE_COMPLEMENT, PLA, NIL(char));
+    if (cache_get(&key, PLA))
+        return 1;
+
     if (pla_type == TYPE_FD) {
         free_cover(PLA->R);
-        PLA->R = complement(cube2list(PLA->F, PLA->D));  // R = U - (F u D)
+        /* R = U - (F u D) */
+        PHASE(PHASE_COMPLEMENT, PLA->R,
+              PLA->R = complement(cube2list(PLA->F, PLA->D)));
     } else if (pla_type == TYPE_FR) {
         pcover X;
         free_cover(PLA->D);
         /* hack, why not? */
         X = d1merge(sf_join(PLA->F, PLA->R), cube.num_vars - 1);
-        PLA->D = complement(cube1list(X));
+        PHASE(PHASE_COMPLEMENT, PLA->D, PLA->D = complement(cube1list(X)));
         free_cover(X);
     }
+    cache_put(&key, PLA);
 
     return 1;
 }
@@ -295,6 +513,8 @@ pPLA new_PLA() {
 
     PLA = ALLOC(PLA_t, 1);
     PLA->F = PLA->D = PLA->R = (pcover)NULL;
+    PLA->map = NULL;
+    PLA->map_size = 0;
     return PLA;
 }
 
@@ -304,5 +524,8 @@ void free_PLA(pPLA PLA) {
     if (PLA->R != (pcover)NULL)
         free_cover(PLA->R);
     if (PLA->D != (pcover)NULL)
-        FREE(PLA);
+        free_cover(PLA->D);
+    if (PLA->map != NULL)
+        (void)munmap(PLA->map, PLA->map_size);
+    FREE(PLA);
 }
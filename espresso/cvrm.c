@@ -92,41 +92,42 @@ pcover unravel(pcover B, int start) {
     return unravel_range(B, start, cube.num_vars - 1);
 }
 
-/*  mini_sort -- sort cubes according to the heuristics of mini */
-pcover mini_sort(pcover F, int (*compare)(pset *, pset *)) {
-    int *count, cnt, n = cube.size, i;
-    pcube p, last;
-    pcover F_sorted;
-    pcube *F1;
+/*
+ *  mini_sort -- sort cubes according to the heuristics of mini (in the
+ *  order SORT_ASCEND or SORT_DESCEND); when the context has a seed, the
+ *  cubes of the same weight are ordered by a hash drawn from it rather
+ *  than by their contents (see portfolio.c)
+ */
+pcover mini_sort(pcover F, int order) {
+    int *count, cnt, i, k, base;
+    unsigned int *key;
+    set_word_t val;
+    pcube p;
 
     /* Perform a column sum over the set family */
     count = sf_count(F);
 
     /* weight is "inner product of the cube and the column sums" */
-    foreach_set(F, last, p) {
+    key = ALLOC(unsigned int, MAX(F->count, 1));
+    foreachi_set(F, k, p) {
         cnt = 0;
-        for (i = 0; i < n; i++)
-            if (is_in_set(p, i))
-                cnt += count[i];
-        PUTSIZE(p, cnt);
+        foreach_set_element(p, i, val, base) {
+            cnt += count[base];
+        }
+        key[k] = cnt;
     }
     FREE(count);
 
-    /* use qsort to sort the array */
-    qsort((char *)(F1 = sf_list(F)), F->count, sizeof(pcube),
-          (int (*)(const void *, const void *))compare);
-    F_sorted = sf_unlist(F1, F->count, F->sf_size);
-    free_cover(F);
-
-    return F_sorted;
+    sf_permute(F, sf_order(F, key, NIL(set_word_t), order | SORT_SEEDED));
+    FREE(key);
+    return F;
 }
 
 /* sort_reduce -- Espresso strategy for ordering the cubes before reduction */
 pcover sort_reduce(pcover T) {
     pcube p, last, largest = NULL;
-    int bestsize = -1, size, n = cube.num_vars;
-    pcover T_sorted;
-    pcube *T1;
+    int bestsize = -1, size, n = cube.num_vars, k;
+    unsigned int *key;
 
     if (T->count == 0)
         return T;
@@ -135,15 +136,15 @@ pcover sort_reduce(pcover T) {
     foreach_set(T, last, p) if ((size = set_ord(p)) > bestsize) largest = p,
                                                                 bestsize = size;
 
+    key = ALLOC(unsigned int, T->count);
+    k = 0;
     foreach_set(T, last, p)
-        PUTSIZE(p, ((n - cdist(largest, p)) << 7) + MIN(set_ord(p), 127));
-
-    qsort((char *)(T1 = sf_list(T)), T->count, sizeof(pcube),
-          (int (*)(const void *, const void *))descend);
-    T_sorted = sf_unlist(T1, T->count, T->sf_size);
-    free_cover(T);
+        key[k++] = ((n - cdist(largest, p)) << 7) + MIN(set_ord(p), 127);
 
-    return T_sorted;
+    sf_permute(T,
+               sf_order(T, key, NIL(set_word_t), SORT_DESCEND | SORT_SEEDED));
+    FREE(key);
+    return T;
 }
 
 /*
@@ -151,20 +152,24 @@ pcover sort_reduce(pcover T) {
  *  if so, return cubelist's of the two partitions A and B; the return value
  *  is the size of the partition; if not, A and B
  *  are undefined and the return value is 0
+ *
+ *  The cubes themselves are not written to (the cubes of T may be shared
+ *  with other threads), so the partition is tracked in a separate array.
  */
 int cubelist_partition(pcube *T, /* a list of cubes */
                        pcube **A,
                        pcube **B /* cubelist of partition and remainder */) {
     pcube *T1, p, seed, cof;
     pcube *A1, *B1;
-    bool change;
-    int count, numcube;
+    bool change, *covered;
+    int count, numcube, i;
 
     numcube = CUBELISTSIZE(T);
 
     /* Mark all cubes -- covered cubes belong to the partition */
-    for (T1 = T + 2; (p = *T1++) != NULL;) {
-        RESET(p, COVERED);
+    covered = ALLOC(bool, numcube);
+    for (i = 0; i < numcube; i++) {
+        covered[i] = FALSE;
     }
 
     /*
@@ -174,15 +179,15 @@ int cubelist_partition(pcube *T, /* a list of cubes */
      */
     seed = set_save(T[2]);
     cof = T[0];
-    SET(T[2], COVERED);
+    covered[0] = TRUE;
     count = 1;
 
     do {
         change = FALSE;
-        for (T1 = T + 2; (p = *T1++) != NULL;) {
-            if (!TESTP(p, COVERED) && ccommon(p, seed, cof)) {
+        for (T1 = T + 2, i = 0; (p = *T1++) != NULL; i++) {
+            if (!covered[i] && ccommon(p, seed, cof)) {
                 INLINEset_and(seed, seed, p);
-                SET(p, COVERED);
+                covered[i] = TRUE;
                 change = TRUE;
                 count++;
             }
@@ -193,16 +198,16 @@ int cubelist_partition(pcube *T, /* a list of cubes */
 
     if (count != numcube) {
         /* Allocate and setup the cubelist's for the two partitions */
-        *A = A1 = ALLOC(pcube, numcube + 3);
-        *B = B1 = ALLOC(pcube, numcube + 3);
-        (*A)[0] = set_save(T[0]);
-        (*B)[0] = set_save(T[0]);
+        *A = A1 = new_cubelist(numcube + 3);
+        *B = B1 = new_cubelist(numcube + 3);
+        (void)set_copy((*A)[0], T[0]);
+        (void)set_copy((*B)[0], T[0]);
         A1 = *A + 2;
         B1 = *B + 2;
 
         /* Loop over the cubes in T and distribute to A and B */
-        for (T1 = T + 2; (p = *T1++) != NULL;) {
-            if (TESTP(p, COVERED)) {
+        for (T1 = T + 2, i = 0; (p = *T1++) != NULL; i++) {
+            if (covered[i]) {
                 *A1++ = p;
             } else {
                 *B1++ = p;
@@ -215,6 +220,7 @@ int cubelist_partition(pcube *T, /* a list of cubes */
         *B1++ = NULL;
         (*B)[1] = (pcube)B1;
     }
+    FREE(covered);
 
     return numcube - count;
 }
@@ -1,3 +1,4 @@
+#include <time.h>
 #include "espresso.h"
 
 /* cost -- compute the cost of a cover */
@@ -47,8 +48,21 @@ void copy_cost(pcost s, pcost d) {
     d->primes = s->primes;
 }
 
-/* fatal -- report fatal error message and take a dive */
+/*
+ * fatal -- report fatal error message and take a dive (or return to the
+ * caller which asked for it in the current context)
+ */
 void fatal(char *s) {
     fprintf(stderr, "espresso: %s\n", s);
+    if (current_context->fatal_env != NULL)
+        longjmp(*current_context->fatal_env, 1);
     exit(1);
 }
+
+/* wall_time -- elapsed real time in seconds (from an arbitrary origin) */
+double wall_time() {
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
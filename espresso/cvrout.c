@@ -1,46 +1,110 @@
 /*
     module: cvrout.c
     purpose: cube and cover output routines
+
+    The cubes are formatted into a large buffer which is written with a
+    single fwrite() when it fills.  The binary inputs and the outputs are
+    translated a byte of the cube at a time, through tables giving the
+    characters of four binary variables or of eight outputs.
 */
 
 #include "espresso.h"
 
+#define OUTPUT_BLOCK 65536 /* bytes formatted before each write */
+
+typedef struct {
+    char inputs[256][4];  /* the four binary variables of a byte */
+    char outputs[256][8]; /* the eight outputs of a byte */
+} cube_format_t;
+
+/* format_setup -- build the tables, "out_map" gives the output characters */
+static void format_setup(cube_format_t *f, char *out_map) {
+    int b, j;
+
+    for (b = 0; b < 256; b++) {
+        for (j = 0; j < 4; j++)
+            f->inputs[b][j] = "?01-"[(b >> 2 * j) & 3];
+        for (j = 0; j < 8; j++)
+            f->outputs[b][j] = out_map[(b >> j) & 1];
+    }
+}
+
+/* format_line -- room needed for a cube (format_cube writes past its end) */
+static int format_line() {
+    return cube.size + cube.num_vars + 16;
+}
+
+/* set_byte -- the 8 elements of "c" starting at "i" (garbage past the end) */
+static int set_byte(pcube c, int i, int last) {
+    int w = WHICH_WORD(i), b = WHICH_BIT(i);
+    set_word_t x = c[w] >> b;
+
+    if (b > BPI - 8 && i + (BPI - b) <= last)
+        x |= c[w + 1] << (BPI - b);
+    return (int)(x & 0xff);
+}
+
+/* format_cube -- write cube "c" as a line of a PLA at "q", return its end */
+static char *format_cube(cube_format_t *f, char *q, pcube c) {
+    int i, var, first, last;
+
+    for (i = 0; i < 2 * cube.num_binary_vars; i += 8)
+        memcpy(q + i / 2, f->inputs[set_byte(c, i, cube.size - 1)], 4);
+    q += cube.num_binary_vars;
+
+    for (var = cube.num_binary_vars; var < cube.num_vars - 1; var++) {
+        *q++ = ' ';
+        for (i = cube.first_part[var]; i <= cube.last_part[var]; i++)
+            *q++ = "01"[is_in_set(c, i) != 0];
+    }
+
+    if (cube.output != -1) {
+        first = cube.first_part[cube.output];
+        last = cube.last_part[cube.output];
+        *q++ = ' ';
+        for (i = first; i <= last; i += 8)
+            memcpy(q + (i - first), f->outputs[set_byte(c, i, last)], 8);
+        q += last - first + 1;
+    }
+    *q++ = '\n';
+    return q;
+}
+
 void fprint_pla(FILE *fp, pPLA PLA) {
     pcube last, p;
+    cube_format_t f;
+    char *buf, *q;
+    int line, size;
 
     fprintf(fp, ".i %d\n", cube.num_binary_vars);
     fprintf(fp, ".o %d\n", cube.part_size[cube.output]);
 
     fprintf(fp, ".type f\n");
+    if (print_npterms)
+        fprintf(fp, ".p %d\n", PLA->F->count);
 
+    format_setup(&f, "01");
+    line = format_line();
+    size = MAX(OUTPUT_BLOCK, 4 * line);
+    q = buf = ALLOC(char, size);
     foreach_set(PLA->F, last, p) {
-        print_cube(fp, p, "01");
+        if (size - (q - buf) < line) {
+            (void)fwrite(buf, 1, q - buf, fp);
+            q = buf;
+        }
+        q = format_cube(&f, q, p);
     }
+    (void)fwrite(buf, 1, q - buf, fp);
+    FREE(buf);
     fprintf(fp, ".e\n");
 }
 
 void print_cube(FILE *fp, pcube c, char *out_map) {
-    int i, var, ch;
-    int last;
+    cube_format_t f;
+    char *buf;
 
-    for (var = 0; var < cube.num_binary_vars; var++) {
-        ch = "?01-"[GETINPUT(c, var)];
-        putc(ch, fp);
-    }
-    for (var = cube.num_binary_vars; var < cube.num_vars - 1; var++) {
-        putc(' ', fp);
-        for (i = cube.first_part[var]; i <= cube.last_part[var]; i++) {
-            ch = "01"[is_in_set(c, i) != 0];
-            putc(ch, fp);
-        }
-    }
-    if (cube.output != -1) {
-        last = cube.last_part[cube.output];
-        putc(' ', fp);
-        for (i = cube.first_part[cube.output]; i <= last; i++) {
-            ch = out_map[is_in_set(c, i) != 0];
-            putc(ch, fp);
-        }
-    }
-    putc('\n', fp);
+    format_setup(&f, out_map);
+    buf = ALLOC(char, format_line());
+    (void)fwrite(buf, 1, format_cube(&f, buf, c) - buf, fp);
+    FREE(buf);
 }
@@ -0,0 +1,271 @@
+/*
+    module: decomp.c
+    purpose: minimization of the independent parts of a function apart
+
+    An input which has a literal in no cube of F u D does not matter to
+    the function, nor does an output which no cube of F asserts (its
+    cover is empty).  What is left falls apart into the connected
+    components of the graph joining the inputs and outputs used by a same
+    cube: two outputs of different components depend on disjoint sets of
+    inputs, and no cube of F or D asserts both of them.
+
+    Each component is minimized on its own (and concurrently, when there
+    is a thread pool), in a context of its own whose cube geometry only
+    has the inputs and outputs of the component, so that the cubes can be
+    much shorter than those of the whole function.  The slice of R for a
+    component is made of the cubes of R asserting one of its outputs,
+    with the literals of the other inputs raised: the outputs of the
+    component do not depend on these inputs.  The covers of the
+    components are then put back into the columns of the whole function.
+*/
+
+#include "espresso.h"
+
+typedef struct {
+    pcover F, D, R;  /* of the whole function (shared by the components) */
+    pcover start;    /* cover to start from (or NULL) */
+    int *map;        /* part of the whole cube for each part (or -1) */
+    int ninputs;     /* inputs of the component */
+    int noutputs;    /* outputs of the component */
+    pcover result;   /* the cover found, in the geometry of the whole */
+    bool truncated;  /* the minimization stopped at a limit */
+} decomp_comp_t;
+
+/* decomp_find -- the representative of node i (halving the paths) */
+static int decomp_find(int *up, int i) {
+    while (up[i] != i)
+        i = up[i] = up[up[i]];
+    return i;
+}
+
+/* decomp_join -- put the n nodes on the list into one set */
+static void decomp_join(int *up, int *list, int n) {
+    int i, a, b;
+
+    for (i = 1; i < n; i++) {
+        a = decomp_find(up, list[0]);
+        b = decomp_find(up, list[i]);
+        if (a != b)
+            up[MAX(a, b)] = MIN(a, b);
+    }
+}
+
+/*
+    decomp_slice -- the cubes of A asserting an output of the component,
+    in the geometry of the component (the current one)
+*/
+static pcover decomp_slice(decomp_comp_t *g, pcover A) {
+    pcover B;
+    pset last, p, q;
+    int i, out = 2 * g->ninputs;
+
+    B = new_cover(A->count);
+    foreach_set(A, last, p) {
+        for (i = out; i < cube.size; i++)
+            if (is_in_set(p, g->map[i]))
+                break;
+        if (i == cube.size)
+            continue;
+        q = GETSET(B, B->count++);
+        (void)set_clear(q, cube.size);
+        for (i = 0; i < cube.size; i++)
+            if (g->map[i] < 0 || is_in_set(p, g->map[i]))
+                set_insert(q, i);
+    }
+    return B;
+}
+
+/* decomp_minimize -- minimize a component in a context of its own */
+static void decomp_minimize(void *arg) {
+    decomp_comp_t *g = (decomp_comp_t *)arg;
+    pcontext ctx, save;
+    pcover F, D, R;
+    pset last, p, q;
+    int i, size;
+
+    ctx = context_new();
+    ctx->pla_type = current_context->pla_type;
+    ctx->seed = current_context->seed;
+    ctx->cancel = current_context->cancel;
+    save = context_set(ctx);
+    cube.num_binary_vars = g->ninputs;
+    cube.num_vars = g->ninputs + 1;
+    cube.part_size = ALLOC(int, cube.num_vars);
+    cube.part_size[g->ninputs] = g->noutputs;
+    cube_setup();
+    size = cube.size;
+
+    F = decomp_slice(g, g->F);
+    D = decomp_slice(g, g->D);
+    R = decomp_slice(g, g->R);
+    if (g->start != NULL)
+        ctx->start = decomp_slice(g, g->start);
+    F = espresso_portfolio(F, D, R);
+    g->truncated = ctx->truncated;
+    if (ctx->start != NULL)
+        free_cover(ctx->start);
+    free_cover(D);
+    free_cover(R);
+    (void)context_set(save);
+
+    /* back into the columns of the whole function */
+    g->result = new_cover(F->count);
+    foreach_set(F, last, p) {
+        q = GETSET(g->result, g->result->count++);
+        (void)set_copy(q, cube.fullset);
+        for (i = 0; i < 2 * g->ninputs; i++)
+            if (g->map[i] >= 0 && !is_in_set(p, i))
+                set_remove(q, g->map[i]);
+        (void)set_diff(q, q, cube.var_mask[cube.output]);
+        for (i = 2 * g->ninputs; i < size; i++)
+            if (is_in_set(p, i))
+                set_insert(q, g->map[i]);
+    }
+    free_cover(F);
+    context_free(ctx);
+}
+
+/* decomp_uses -- note the nodes of the inputs and outputs used by p */
+static int decomp_uses(pset p, bool *asserted, int *list) {
+    int i, n = 0, nin = cube.num_binary_vars, first = cube.first_part[nin];
+
+    for (i = 0; i < cube.part_size[nin]; i++)
+        if (is_in_set(p, first + i) && (asserted == NULL || asserted[i]))
+            list[n++] = nin + i;
+    if (n == 0)
+        return 0;
+    for (i = 0; i < nin; i++)
+        if (GETINPUT(p, i) != 3) /* not a "-" */
+            list[n++] = i;
+    return n;
+}
+
+/*
+    espresso_decomposed -- minimize F by the independent parts of the
+    function (see above); what was found is reported on stderr
+*/
+pcover espresso_decomposed(pcover F, pcover D, pcover R) {
+    decomp_comp_t *comps;
+    task_group_t tasks = {0};
+    bool *asserted;
+    int *up, *list, *comp, *map, *next;
+    int i, k, n, nin, nout, first, ncomps, inputs, outputs;
+    pset last, p;
+    pcover Fnew;
+
+    /* a single output variable after the binary ones (as read_pla makes) */
+    nin = cube.num_binary_vars;
+    if (cube.num_vars != nin + 1)
+        return espresso_portfolio(F, D, R);
+    nout = cube.part_size[nin];
+    first = cube.first_part[nin];
+
+    asserted = ALLOC(bool, nout);
+    for (i = 0; i < nout; i++)
+        asserted[i] = FALSE;
+    foreach_set(F, last, p) {
+        for (i = 0; i < nout; i++)
+            if (is_in_set(p, first + i))
+                asserted[i] = TRUE;
+    }
+
+    /* the inputs are nodes 0 .. nin-1 and the outputs nin .. nin+nout-1 */
+    up = ALLOC(int, nin + nout);
+    list = ALLOC(int, nin + nout);
+    for (i = 0; i < nin + nout; i++)
+        up[i] = i;
+    foreach_set(F, last, p) {
+        decomp_join(up, list, decomp_uses(p, NULL, list));
+    }
+    foreach_set(D, last, p) {
+        decomp_join(up, list, decomp_uses(p, asserted, list));
+    }
+
+    /* number the components, in the order of their first output */
+    comp = ALLOC(int, nin + nout);
+    for (i = 0; i < nin + nout; i++)
+        comp[i] = -1;
+    ncomps = outputs = 0;
+    for (i = 0; i < nout; i++)
+        if (asserted[i]) {
+            k = decomp_find(up, nin + i);
+            if (comp[k] < 0)
+                comp[k] = ncomps++;
+            outputs++;
+        }
+    inputs = 0;
+    for (i = 0; i < nin; i++)
+        if (comp[decomp_find(up, i)] >= 0)
+            inputs++;
+
+    if (ncomps == 0 || (ncomps == 1 && inputs == nin && outputs == nout)) {
+        FREE(asserted);
+        FREE(up);
+        FREE(list);
+        FREE(comp);
+        return espresso_portfolio(F, D, R);
+    }
+
+    /* the parts of the whole cube for those of each component */
+    comps = ALLOC(decomp_comp_t, ncomps);
+    for (k = 0; k < ncomps; k++) {
+        comps[k].F = F;
+        comps[k].D = D;
+        comps[k].R = R;
+        comps[k].start = current_context->start;
+        comps[k].ninputs = comps[k].noutputs = 0;
+    }
+    for (i = 0; i < nin; i++)
+        if ((k = comp[decomp_find(up, i)]) >= 0)
+            comps[k].ninputs++;
+    for (i = 0; i < nout; i++)
+        if (asserted[i])
+            comps[comp[decomp_find(up, nin + i)]].noutputs++;
+    next = ALLOC(int, ncomps);
+    for (k = 0; k < ncomps; k++) {
+        /* an input which matters to none of the outputs keeps it a PLA */
+        n = MAX(comps[k].ninputs, 1);
+        comps[k].map = ALLOC(int, 2 * n + comps[k].noutputs);
+        comps[k].map[0] = comps[k].map[1] = -1;
+        comps[k].ninputs = n;
+        next[k] = 0;
+    }
+    for (i = 0; i < nin; i++)
+        if ((k = comp[decomp_find(up, i)]) >= 0) {
+            map = comps[k].map;
+            map[next[k]++] = 2 * i;
+            map[next[k]++] = 2 * i + 1;
+        }
+    for (k = 0; k < ncomps; k++)
+        next[k] = 2 * comps[k].ninputs;
+    for (i = 0; i < nout; i++)
+        if (asserted[i]) {
+            k = comp[decomp_find(up, nin + i)];
+            comps[k].map[next[k]++] = first + i;
+        }
+    FREE(next);
+    FREE(asserted);
+    FREE(up);
+    FREE(list);
+    FREE(comp);
+
+    for (k = 0; k < ncomps; k++)
+        task_spawn(&tasks, decomp_minimize, &comps[k]);
+    task_wait(&tasks);
+
+    Fnew = new_cover(F->count);
+    current_context->truncated = FALSE;
+    for (k = 0; k < ncomps; k++) {
+        current_context->truncated |= comps[k].truncated;
+        Fnew = sf_append(Fnew, comps[k].result);
+        FREE(comps[k].map);
+    }
+    FREE(comps);
+    free_cover(F);
+
+    fprintf(stderr,
+            "# decomposition: %d components, %d of %d inputs, "
+            "%d of %d outputs\n",
+            ncomps, inputs, nin, outputs, nout);
+    return Fnew;
+}
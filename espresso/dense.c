@@ -0,0 +1,805 @@
+#include "mincov_int.h"
+
+/*
+ *  dense.c -- minimum cover on a dense covering table
+ *
+ *  The table is kept as packed bit matrices, one set of columns for each
+ *  row and one set of rows for each column, so that containment between
+ *  rows or columns, the rows intersecting a row (for the independent set)
+ *  and the rows connected to a row (for the block partition) are found a
+ *  word at a time.  The rows and columns are indexed in the order of
+ *  their numbers in the sparse matrix, and every step of sm_mincov() (row
+ *  and column dominance, essentials, Gimpel's reduction, the independent
+ *  set and the choice of the branching column) is carried out in the same
+ *  order as on the sparse matrix, so the cover found is the same.
+ *
+ *  A copy of a table (for a branch or a block) keeps only the rows and
+ *  columns still present, so the tables shrink as the search goes down.
+ */
+
+typedef unsigned long long dm_word;
+
+#define DM_BITS       64
+#define DM_WORDS(n)   (((n) + DM_BITS - 1) / DM_BITS)
+#define DM_BIT(i)     ((dm_word)1 << ((i) % DM_BITS))
+#define DM_IN(set, i) (((set)[(i) / DM_BITS] & DM_BIT(i)) != 0)
+#define DM_ADD(set, i) ((set)[(i) / DM_BITS] |= DM_BIT(i))
+#define DM_DEL(set, i) ((set)[(i) / DM_BITS] &= ~DM_BIT(i))
+
+#ifdef __GNUC__
+#define DM_LOWEST(w) __builtin_ctzll(w)
+#define DM_COUNT(w)  __builtin_popcountll(w)
+#else
+#define DM_LOWEST(w) dm_lowest(w)
+#define DM_COUNT(w)  dm_popcount(w)
+static int dm_lowest(dm_word w) {
+    int i;
+    for (i = 0; (w & 1) == 0; i++, w >>= 1)
+        ;
+    return i;
+}
+static int dm_popcount(dm_word w) {
+    int n;
+    for (n = 0; w != 0; w &= w - 1)
+        n++;
+    return n;
+}
+#endif
+
+/* a table is dense enough if there is an element for every DENSE_RATIO
+ * entries, and small enough if it has at most DENSE_MAX_CELLS entries */
+#define DENSE_RATIO     128
+#define DENSE_MAX_CELLS (1 << 26)
+
+typedef struct dm_matrix_struct {
+    int nrows, ncols;   /* number of rows and columns left */
+    int rsize, csize;   /* number of rows and columns it was made with */
+    int rwords, cwords; /* words in a set of rows, a set of columns */
+    dm_word *rows;      /* for each row, the set of its columns */
+    dm_word *cols;      /* for each column, the set of its rows */
+    dm_word *row_alive; /* the rows left */
+    dm_word *col_alive; /* the columns left */
+    int *row_len;       /* number of columns of each row */
+    int *col_len;       /* number of rows of each column */
+    int *row_num;       /* row number in the sparse matrix */
+    int *col_num;       /* column number in the sparse matrix */
+} dm_matrix;
+
+#define ROW(A, i) ((A)->rows + (size_t)(i) * (A)->cwords)
+#define COL(A, i) ((A)->cols + (size_t)(i) * (A)->rwords)
+
+static solution_t *dm_mincov(dm_matrix *A, solution_t *select, int *weight,
+                             int lb, int bound, int depth, stats_t *stats);
+
+/* dm_set_new -- an empty set of "n" words */
+static dm_word *dm_set_new(int n) {
+    dm_word *set = ALLOC(dm_word, MAX(n, 1));
+    memset(set, 0, sizeof(dm_word) * MAX(n, 1));
+    return set;
+}
+
+/* dm_next -- the first element of a set which is at least "i" (or -1) */
+static int dm_next(dm_word *set, int nwords, int i) {
+    int k = i / DM_BITS;
+    dm_word w;
+
+    if (k >= nwords)
+        return -1;
+    for (w = set[k] & ((dm_word)~0 << (i % DM_BITS)); w == 0; w = set[k])
+        if (++k == nwords)
+            return -1;
+    return k * DM_BITS + DM_LOWEST(w);
+}
+
+#define dm_foreach(set, nwords, i) \
+    for (i = dm_next(set, nwords, 0); i >= 0; i = dm_next(set, nwords, i + 1))
+
+/* dm_count -- the number of elements of a set */
+static int dm_count(dm_word *set, int nwords) {
+    int k, n = 0;
+    for (k = 0; k < nwords; k++)
+        n += DM_COUNT(set[k]);
+    return n;
+}
+
+/* dm_subset -- is a a subset of b ? */
+static int dm_subset(dm_word *a, dm_word *b, int nwords) {
+    int k;
+    for (k = 0; k < nwords; k++)
+        if (a[k] & ~b[k])
+            return 0;
+    return 1;
+}
+
+static dm_matrix *dm_alloc(int nrows, int ncols) {
+    dm_matrix *A;
+
+    A = ALLOC(dm_matrix, 1);
+    A->nrows = A->ncols = 0;
+    A->rsize = nrows;
+    A->csize = ncols;
+    A->rwords = DM_WORDS(nrows);
+    A->cwords = DM_WORDS(ncols);
+    A->rows = dm_set_new(nrows * A->cwords);
+    A->cols = dm_set_new(ncols * A->rwords);
+    A->row_alive = dm_set_new(A->rwords);
+    A->col_alive = dm_set_new(A->cwords);
+    A->row_len = ALLOC(int, MAX(nrows, 1));
+    A->col_len = ALLOC(int, MAX(ncols, 1));
+    A->row_num = ALLOC(int, MAX(nrows, 1));
+    A->col_num = ALLOC(int, MAX(ncols, 1));
+    memset(A->row_len, 0, sizeof(int) * MAX(nrows, 1));
+    memset(A->col_len, 0, sizeof(int) * MAX(ncols, 1));
+    return A;
+}
+
+static void dm_free(dm_matrix *A) {
+    FREE(A->rows);
+    FREE(A->cols);
+    FREE(A->row_alive);
+    FREE(A->col_alive);
+    FREE(A->row_len);
+    FREE(A->col_len);
+    FREE(A->row_num);
+    FREE(A->col_num);
+    FREE(A);
+}
+
+/* dm_insert -- add the element (i, j) */
+static void dm_insert(dm_matrix *A, int i, int j) {
+    if (!DM_IN(ROW(A, i), j)) {
+        DM_ADD(ROW(A, i), j);
+        DM_ADD(COL(A, j), i);
+        if (A->row_len[i]++ == 0) {
+            DM_ADD(A->row_alive, i);
+            A->nrows++;
+        }
+        if (A->col_len[j]++ == 0) {
+            DM_ADD(A->col_alive, j);
+            A->ncols++;
+        }
+    }
+}
+
+/* dm_delrow -- delete a row, and the columns it leaves empty */
+static void dm_delrow(dm_matrix *A, int i) {
+    dm_word *row = ROW(A, i);
+    int j;
+
+    if (DM_IN(A->row_alive, i)) {
+        dm_foreach(row, A->cwords, j) {
+            DM_DEL(COL(A, j), i);
+            if (--A->col_len[j] == 0) {
+                DM_DEL(A->col_alive, j);
+                A->ncols--;
+            }
+        }
+        memset(row, 0, sizeof(dm_word) * A->cwords);
+        A->row_len[i] = 0;
+        DM_DEL(A->row_alive, i);
+        A->nrows--;
+    }
+}
+
+/* dm_delcol -- delete a column, and the rows it leaves empty */
+static void dm_delcol(dm_matrix *A, int j) {
+    dm_word *col = COL(A, j);
+    int i;
+
+    if (DM_IN(A->col_alive, j)) {
+        dm_foreach(col, A->rwords, i) {
+            DM_DEL(ROW(A, i), j);
+            if (--A->row_len[i] == 0) {
+                DM_DEL(A->row_alive, i);
+                A->nrows--;
+            }
+        }
+        memset(col, 0, sizeof(dm_word) * A->rwords);
+        A->col_len[j] = 0;
+        DM_DEL(A->col_alive, j);
+        A->ncols--;
+    }
+}
+
+/* dm_col_index -- the index of the column numbered "col" (or -1) */
+static int dm_col_index(dm_matrix *A, int col) {
+    int lo = 0, hi = A->csize - 1, mid;
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (A->col_num[mid] < col) {
+            lo = mid + 1;
+        } else if (A->col_num[mid] > col) {
+            hi = mid - 1;
+        } else {
+            return mid;
+        }
+    }
+    return -1;
+}
+
+/* dm_extract -- a copy of the rows "rowset" of A (and of their columns) */
+static dm_matrix *dm_extract(dm_matrix *A, dm_word *rowset) {
+    dm_matrix *B;
+    dm_word *cols;
+    int *col_index, i, j, k, n;
+
+    /* the columns used by these rows, in order */
+    cols = dm_set_new(A->cwords);
+    dm_foreach(rowset, A->rwords, i) {
+        for (k = 0; k < A->cwords; k++)
+            cols[k] |= ROW(A, i)[k];
+    }
+    B = dm_alloc(dm_count(rowset, A->rwords), dm_count(cols, A->cwords));
+    col_index = ALLOC(int, MAX(A->csize, 1));
+    n = 0;
+    dm_foreach(cols, A->cwords, j) {
+        B->col_num[n] = A->col_num[j];
+        col_index[j] = n++;
+    }
+
+    n = 0;
+    dm_foreach(rowset, A->rwords, i) {
+        B->row_num[n] = A->row_num[i];
+        dm_foreach(ROW(A, i), A->cwords, j) {
+            dm_insert(B, n, col_index[j]);
+        }
+        n++;
+    }
+    FREE(cols);
+    FREE(col_index);
+    return B;
+}
+
+static dm_matrix *dm_dup(dm_matrix *A) {
+    return dm_extract(A, A->row_alive);
+}
+
+/* dm_from_sparse -- a dense copy of the sparse matrix A */
+static dm_matrix *dm_from_sparse(sm_matrix *A) {
+    dm_matrix *B;
+    sm_row *prow;
+    sm_col *pcol;
+    sm_element *p;
+    int *col_index, i, j;
+
+    B = dm_alloc(A->nrows, A->ncols);
+    col_index = ALLOC(int, A->last_col->col_num + 1);
+    j = 0;
+    sm_foreach_col(A, pcol) {
+        B->col_num[j] = pcol->col_num;
+        col_index[pcol->col_num] = j++;
+    }
+    i = 0;
+    sm_foreach_row(A, prow) {
+        B->row_num[i] = prow->row_num;
+        sm_foreach_row_element(prow, p) {
+            dm_insert(B, i, col_index[p->col_num]);
+        }
+        i++;
+    }
+    FREE(col_index);
+    return B;
+}
+
+/* see sm_row_dominance() */
+static int dm_row_dominance(dm_matrix *A) {
+    dm_word *row;
+    int i, j, least, rowcnt;
+
+    rowcnt = A->nrows;
+    dm_foreach(A->row_alive, A->rwords, i) {
+        /* Among all columns with a 1 in this row, choose smallest */
+        row = ROW(A, i);
+        least = -1;
+        dm_foreach(row, A->cwords, j) {
+            if (least < 0 || A->col_len[j] < A->col_len[least]) {
+                least = j;
+            }
+        }
+
+        /* Only check for containment against rows in this column */
+        dm_foreach(COL(A, least), A->rwords, j) {
+            if (A->row_len[j] > A->row_len[i] ||
+                (A->row_len[j] == A->row_len[i] && j > i)) {
+                if (dm_subset(row, ROW(A, j), A->cwords)) {
+                    dm_delrow(A, j);
+                }
+            }
+        }
+    }
+    return rowcnt - A->nrows;
+}
+
+/* see sm_col_dominance() */
+static int dm_col_dominance(dm_matrix *A, int *weight) {
+    dm_word *col;
+    int i, j, k, least, colcnt;
+
+    colcnt = A->ncols;
+    dm_foreach(A->col_alive, A->cwords, j) {
+        /* Among all rows with a 1 in this column, choose smallest */
+        col = COL(A, j);
+        least = -1;
+        dm_foreach(col, A->rwords, i) {
+            if (least < 0 || A->row_len[i] < A->row_len[least]) {
+                least = i;
+            }
+        }
+
+        /* Only check for containment against columns in this row */
+        dm_foreach(ROW(A, least), A->cwords, k) {
+            if (weight != 0 && weight[A->col_num[k]] > weight[A->col_num[j]])
+                continue;
+            if (A->col_len[k] > A->col_len[j] ||
+                (A->col_len[k] == A->col_len[j] && k > j)) {
+                if (dm_subset(col, COL(A, k), A->rwords)) {
+                    dm_delcol(A, j);
+                    break;
+                }
+            }
+        }
+    }
+    return colcnt - A->ncols;
+}
+
+/* dm_accept -- add column j to the solution, and delete the rows it covers */
+static void dm_accept(solution_t *sol, dm_matrix *A, int *weight, int j) {
+    int i;
+
+    solution_add(sol, weight, A->col_num[j]);
+    dm_foreach(COL(A, j), A->rwords, i) {
+        dm_delrow(A, i);
+    }
+}
+
+/* see select_essential() in mincov.c */
+static void dm_select_essential(dm_matrix *A, solution_t *select, int *weight,
+                                int bound) {
+    dm_word *essen;
+    int i, j, delcols, delrows, essen_count;
+
+    do {
+        /*  Check for dominated columns  */
+        delcols = dm_col_dominance(A, weight);
+
+        /*  Find the rows with only 1 element (the essentials) */
+        essen = dm_set_new(A->cwords);
+        dm_foreach(A->row_alive, A->rwords, i) {
+            if (A->row_len[i] == 1) {
+                DM_ADD(essen, dm_next(ROW(A, i), A->cwords, 0));
+            }
+        }
+
+        /* Select all of the elements */
+        dm_foreach(essen, A->cwords, j) {
+            dm_accept(select, A, weight, j);
+            /* Make sure solution still looks good */
+            if (select->cost >= bound) {
+                FREE(essen);
+                return;
+            }
+        }
+        essen_count = dm_count(essen, A->cwords);
+        FREE(essen);
+
+        /*  Check for dominated rows  */
+        delrows = dm_row_dominance(A);
+
+    } while (delcols > 0 || delrows > 0 || essen_count > 0);
+}
+
+/* see gimpel_reduce() */
+static int dm_gimpel_reduce(dm_matrix *A, solution_t *select, int *weight,
+                            int lb, int bound, int depth, stats_t *stats,
+                            solution_t **best) {
+    dm_word *save_sec;
+    sm_row *sec_cols;
+    int i, j, c1, c2, primary, secondary;
+
+    c1 = c2 = primary = -1;
+    dm_foreach(A->row_alive, A->rwords, i) {
+        if (A->row_len[i] == 2) {
+            c1 = dm_next(ROW(A, i), A->cwords, 0);
+            c2 = dm_next(ROW(A, i), A->cwords, c1 + 1);
+            if (A->col_len[c1] == 2) {
+                primary = i;
+            } else if (A->col_len[c2] == 2) {
+                j = c1;
+                c1 = c2;
+                c2 = j;
+                primary = i;
+            }
+            if (primary >= 0) {
+                break;
+            }
+        }
+    }
+    if (primary < 0) {
+        return 0;
+    }
+
+    secondary = dm_next(COL(A, c1), A->rwords, 0);
+    if (secondary == primary) {
+        secondary = dm_next(COL(A, c1), A->rwords, secondary + 1);
+    }
+    save_sec = dm_set_new(A->cwords);
+    memcpy(save_sec, ROW(A, secondary), sizeof(dm_word) * A->cwords);
+    DM_DEL(save_sec, c1);
+    sec_cols = sm_row_alloc();
+    dm_foreach(save_sec, A->cwords, j) {
+        (void)sm_row_insert(sec_cols, A->col_num[j]);
+    }
+
+    /* merge rows S1 and T */
+    dm_foreach(COL(A, c2), A->rwords, i) {
+        if (i != primary) {
+            dm_foreach(save_sec, A->cwords, j) {
+                dm_insert(A, i, j);
+            }
+        }
+    }
+
+    dm_delcol(A, c1);
+    dm_delcol(A, c2);
+    dm_delrow(A, primary);
+    dm_delrow(A, secondary);
+
+    stats->gimpel_count++;
+    stats->gimpel++;
+    stats->offset++; /* for the column added below */
+    *best = dm_mincov(A, select, weight, lb - 1, bound - 1, depth, stats);
+    stats->offset--;
+    stats->gimpel--;
+
+    if (*best != NIL(solution_t)) {
+        /* is secondary row covered ? */
+        if (sm_row_intersects(sec_cols, (*best)->row)) {
+            /* yes, actually select c2 */
+            solution_add(*best, weight, A->col_num[c2]);
+        } else {
+            solution_add(*best, weight, A->col_num[c1]);
+        }
+    }
+
+    FREE(save_sec);
+    sm_row_free(sec_cols);
+    return 1;
+}
+
+/*
+ *  dm_independent_set -- see sm_maximal_independent_set(); the rows are
+ *  returned in "indep" and the cost of the set is returned
+ */
+static int dm_independent_set(dm_matrix *A, int *weight, dm_word *indep) {
+    dm_word *adj, *alive, *meet, *row;
+    int *len, i, j, k, best, least_weight, cost;
+
+    /* Rows which intersect each row (the row-intersection matrix) */
+    adj = dm_set_new(A->rsize * A->rwords);
+    len = ALLOC(int, MAX(A->rsize, 1));
+    dm_foreach(A->row_alive, A->rwords, i) {
+        row = adj + (size_t)i * A->rwords;
+        dm_foreach(ROW(A, i), A->cwords, j) {
+            for (k = 0; k < A->rwords; k++)
+                row[k] |= COL(A, j)[k];
+        }
+        len[i] = dm_count(row, A->rwords);
+    }
+    alive = dm_set_new(A->rwords);
+    memcpy(alive, A->row_alive, sizeof(dm_word) * A->rwords);
+    meet = dm_set_new(A->rwords);
+
+    cost = 0;
+    while ((best = dm_next(alive, A->rwords, 0)) >= 0) {
+        /*  Find the row which is disjoint from a maximum number of rows */
+        dm_foreach(alive, A->rwords, i) {
+            if (len[i] < len[best]) {
+                best = i;
+            }
+        }
+
+        /* Find which element in this row has least weight */
+        if (weight == NIL(int)) {
+            least_weight = 1;
+        } else {
+            least_weight = -1;
+            dm_foreach(ROW(A, best), A->cwords, j) {
+                if (least_weight < 0 || weight[A->col_num[j]] < least_weight) {
+                    least_weight = weight[A->col_num[j]];
+                }
+            }
+        }
+        cost += least_weight;
+        DM_ADD(indep, best);
+
+        /*  Discard the rows which intersect this row */
+        row = adj + (size_t)best * A->rwords;
+        for (k = 0; k < A->rwords; k++) {
+            meet[k] = row[k] & alive[k];
+            alive[k] &= ~row[k];
+        }
+        dm_foreach(meet, A->rwords, j) {
+            row = adj + (size_t)j * A->rwords;
+            for (k = 0; k < A->rwords; k++) {
+                dm_word w;
+                for (w = row[k] & alive[k]; w != 0; w &= w - 1)
+                    len[k * DM_BITS + DM_LOWEST(w)]--;
+            }
+        }
+    }
+
+    FREE(adj);
+    FREE(len);
+    FREE(alive);
+    FREE(meet);
+    return cost;
+}
+
+/* see select_column() in mincov.c */
+static int dm_select_column(dm_matrix *A, int *weight, dm_word *indep) {
+    dm_word *indep_cols;
+    double w, best;
+    int i, j, k, best_col;
+
+    /* Find which columns are in the independent sets */
+    indep_cols = dm_set_new(A->cwords);
+    dm_foreach(indep, A->rwords, i) {
+        for (k = 0; k < A->cwords; k++)
+            indep_cols[k] |= ROW(A, i)[k];
+    }
+
+    /* Find the best column */
+    best_col = -1;
+    best = -1;
+
+    /* Consider only columns which are in some independent row */
+    dm_foreach(indep_cols, A->cwords, j) {
+        /* Compute the total 'value' of all things covered by the column */
+        w = 0.0;
+        dm_foreach(COL(A, j), A->rwords, i) {
+            w += 1.0 / ((double)A->row_len[i] - 1.0);
+        }
+
+        /* divide this by the relative cost of choosing this column */
+        w = w / (double)WEIGHT(weight, A->col_num[j]);
+
+        /* maximize this ratio */
+        if (w > best) {
+            best_col = j;
+            best = w;
+        }
+    }
+
+    FREE(indep_cols);
+    return best_col;
+}
+
+/* see sm_block_partition() */
+static int dm_block_partition(dm_matrix *A, dm_matrix **L, dm_matrix **R) {
+    dm_word *rows, *cols, *new_rows, *new_cols;
+    int i, j, k, found;
+
+    /* Avoid the trivial case */
+    if (A->nrows == 0) {
+        return 0;
+    }
+
+    /* Grow the block of the first row until no new rows are reached */
+    rows = dm_set_new(A->rwords);
+    cols = dm_set_new(A->cwords);
+    new_rows = dm_set_new(A->rwords);
+    new_cols = dm_set_new(A->cwords);
+    DM_ADD(new_rows, dm_next(A->row_alive, A->rwords, 0));
+    do {
+        for (k = 0; k < A->rwords; k++)
+            rows[k] |= new_rows[k];
+        memset(new_cols, 0, sizeof(dm_word) * A->cwords);
+        dm_foreach(new_rows, A->rwords, i) {
+            for (k = 0; k < A->cwords; k++)
+                new_cols[k] |= ROW(A, i)[k] & ~cols[k];
+        }
+        for (k = 0; k < A->cwords; k++)
+            cols[k] |= new_cols[k];
+        memset(new_rows, 0, sizeof(dm_word) * A->rwords);
+        found = 0;
+        dm_foreach(new_cols, A->cwords, j) {
+            for (k = 0; k < A->rwords; k++)
+                new_rows[k] |= COL(A, j)[k] & ~rows[k];
+            found = 1;
+        }
+    } while (found && dm_next(new_rows, A->rwords, 0) >= 0);
+
+    found = dm_count(rows, A->rwords) < A->nrows;
+    if (found) {
+        *L = dm_extract(A, rows);
+        for (k = 0; k < A->rwords; k++)
+            rows[k] = A->row_alive[k] & ~rows[k];
+        *R = dm_extract(A, rows);
+    }
+    FREE(rows);
+    FREE(cols);
+    FREE(new_rows);
+    FREE(new_cols);
+    return found;
+}
+
+static solution_t *dm_solve(void *A, solution_t *select, int *weight, int lb,
+                            int bound, int depth, stats_t *stats) {
+    return dm_mincov((dm_matrix *)A, select, weight, lb, bound, depth, stats);
+}
+
+/* see sm_mincov() */
+static solution_t *dm_mincov(dm_matrix *A, solution_t *select, int *weight,
+                             int lb, int bound, int depth, stats_t *stats) {
+    dm_matrix *A1, *A2, *L = NIL(dm_matrix), *R = NIL(dm_matrix);
+    dm_word *indep;
+    sm_element *p;
+    solution_t *select1, *select2, *best, *best1, *best2;
+    int pick, lb_new;
+
+    /* Start out with some debugging information (and check the limits) */
+    if (!mincov_enter(stats, depth)) {
+        return NIL(solution_t);
+    }
+    bound = mincov_bound(stats, bound);
+
+    /* Apply row dominance, column dominance, and select essentials */
+    dm_select_essential(A, select, weight, bound);
+    if (select->cost >= bound) {
+        return NIL(solution_t);
+    }
+
+    /* See if gimpel's reduction technique applies ... */
+    if (weight == NIL(int)) { /* hack until we fix it */
+        if (dm_gimpel_reduce(A, select, weight, lb, bound, depth, stats,
+                             &best)) {
+            return best;
+        }
+    }
+
+    /* Determine bound from here to final solution using independent-set */
+    indep = dm_set_new(A->rwords);
+    lb_new = MAX(select->cost + dm_independent_set(A, weight, indep), lb);
+    pick = dm_select_column(A, weight, indep);
+    FREE(indep);
+
+    /* Check for bounding based on no better solution possible */
+    if (lb_new >= bound) {
+        best = NIL(solution_t);
+
+        /* Check for new best solution */
+    } else if (A->nrows == 0) {
+        best = solution_dup(select);
+        mincov_found(stats, best);
+
+        /* Check for a partition of the problem */
+    } else if (dm_block_partition(A, &L, &R)) {
+        /* Make L the smaller problem */
+        if (L->ncols > R->ncols) {
+            A1 = L;
+            L = R;
+            R = A1;
+        }
+        stats->comp_count++;
+
+        /* Solve the problems for L and R at the same time ? */
+        if (mincov_parallel(stats, depth, A->nrows)) {
+            best = mincov_blocks(dm_solve, L, R, select, weight, bound,
+                                 depth + 1, stats);
+            dm_free(L);
+            dm_free(R);
+            return best;
+        }
+
+        /* Solve problem for L */
+        select1 = solution_alloc();
+        stats->component++;
+        stats->offset += select->cost;
+        best1 = dm_mincov(L, select1, weight, 0, bound - select->cost,
+                          depth + 1, stats);
+        stats->offset -= select->cost;
+        stats->component--;
+        solution_free(select1);
+        dm_free(L);
+
+        /* Add best solution to the selected set */
+        if (best1 == NIL(solution_t)) {
+            best = NIL(solution_t);
+        } else {
+            for (p = best1->row->first_col; p != 0; p = p->next_col) {
+                solution_add(select, weight, p->col_num);
+            }
+            solution_free(best1);
+
+            /* recur for the remaining block */
+            best =
+                dm_mincov(R, select, weight, lb_new, bound, depth + 1, stats);
+        }
+        dm_free(R);
+
+        /* We've tried as hard as possible, but now we must split and recur */
+    } else {
+        pick = A->col_num[pick];
+
+        /* Assume we choose this column to be in the covering set */
+        A1 = dm_dup(A);
+        select1 = solution_dup(select);
+        dm_accept(select1, A1, weight, dm_col_index(A1, pick));
+
+        /* ... and, at the same time, that we cannot have it ? */
+        if (mincov_parallel(stats, depth, A->nrows)) {
+            A2 = dm_dup(A);
+            select2 = solution_dup(select);
+            dm_delcol(A2, dm_col_index(A2, pick));
+            best = mincov_branches(dm_solve, A1, select1, A2, select2, weight,
+                                   lb_new, bound, depth + 1, stats);
+            solution_free(select1);
+            dm_free(A1);
+            solution_free(select2);
+            dm_free(A2);
+            return best;
+        }
+
+        best1 = dm_mincov(A1, select1, weight, lb_new, bound, depth + 1, stats);
+        solution_free(select1);
+        dm_free(A1);
+
+        /* Update the upper bound if we found a better solution */
+        if (best1 != NIL(solution_t) && bound > best1->cost) {
+            bound = best1->cost;
+        }
+
+        /* See if this is a heuristic covering (no branching) */
+        if (stats->no_branching) {
+            return best1;
+        }
+
+        /* Check for reaching lower bound -- if so, don't actually branch */
+        if (best1 != NIL(solution_t) && best1->cost == lb_new) {
+            return best1;
+        }
+
+        /* Now assume we cannot have that column */
+        A2 = dm_dup(A);
+        select2 = solution_dup(select);
+        dm_delcol(A2, dm_col_index(A2, pick));
+        best2 = dm_mincov(A2, select2, weight, lb_new, bound, depth + 1, stats);
+        solution_free(select2);
+        dm_free(A2);
+
+        best = solution_choose_best(best1, best2);
+    }
+
+    return best;
+}
+
+/*
+ *  sm_dense_wanted -- should the minimum cover of A (with "nelem" elements)
+ *  be found on a dense table ?  The environment variable ESPRESSO_MINCOV
+ *  may be set to "dense" or "sparse" to choose regardless of the density.
+ */
+int sm_dense_wanted(sm_matrix *A, int nelem) {
+    char *mode = getenv("ESPRESSO_MINCOV");
+    double cells = (double)A->nrows * A->ncols;
+
+    if (mode != NIL(char) && strcmp(mode, "dense") == 0)
+        return 1;
+    if (mode != NIL(char) && strcmp(mode, "sparse") == 0)
+        return 0;
+    return cells <= DENSE_MAX_CELLS && (double)nelem * DENSE_RATIO >= cells;
+}
+
+/* sm_dense_mincov -- sm_mincov() for the whole of A, on a dense table */
+solution_t *sm_dense_mincov(sm_matrix *A, int *weight, int bound,
+                            stats_t *stats) {
+    dm_matrix *D;
+    solution_t *select, *best;
+
+    D = dm_from_sparse(A);
+    select = solution_alloc();
+    best = dm_mincov(D, select, weight, 0, bound, 0, stats);
+    solution_free(select);
+    dm_free(D);
+    return best;
+}
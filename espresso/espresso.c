@@ -7,11 +7,12 @@
  *  The following global variables affect the operation of Espresso:
  *
  *  MISCELLANEOUS:
- *      trace
- *          print trace information as the minimization progresses
+ *      profiling
+ *          time the phases, and trace the size of the cover after each
+ *          (see profile.c)
  *
  *      remove_essential
- *          remove essential primes
+ *          remove essential primes (default)
  *
  *      single_expand
  *          if true, stop after first expand/irredundant
@@ -20,12 +21,36 @@
  *      use_super_gasp
  *          uses the super_gasp strategy rather than last_gasp
  *
+ *      skip_last_gasp
+ *          stop when reduce/expand/irredundant no longer improve
+ *
+ *  EXPAND strategy:
+ *      batch_expand
+ *          expand the cubes in batches, concurrently with a thread pool
+ *          (see expand.c)
+ *
+ *  OFF-SET strategy:
+ *      reduced_offsets
+ *          check the expansions against reduced OFF-sets computed from
+ *          F u D, rather than against R, which is left empty when reading
+ *          (see offset.c)
+ *
+ *  IRREDUNDANT strategy:
+ *      exact_irredundant
+ *          find minimum covers rather than heuristic ones, within the
+ *          limits of the search (see mincov.c)
+ *
  *  SETUP strategy:
+ *      current_context->start
+ *          start from this cover (of an earlier run) rather than from F:
+ *          its cubes which are still implicants are kept as primes, and
+ *          the cubes of F they do not cover are added
+ *
  *      recompute_onset
  *          recompute onset using the complement before starting
  *
  *      unwrap_onset
- *          unwrap the function output part before first expand
+ *          unwrap the function output part before first expand (default)
  *
  *  MAKE_SPARSE strategy:
  *      force_irredundant
@@ -33,55 +58,188 @@
  *          indirectly by make_sparse)
  *
  *      skip_make_sparse
- *          skip the make_sparse step (used by opo only)
+ *          skip the make_sparse step
+ *
+ *  LIMITS:
+ *      time_limit, pass_limit
+ *          stop improving the cover after time_limit seconds, or after
+ *          pass_limit passes of reduce/expand/irredundant or last_gasp.
+ *          The limits are checked between passes; once one is reached,
+ *          the best cover seen is completed with the essential primes
+ *          and made sparse, and current_context->truncated is set.
+ *          The same happens when current_context->cancel is set (see
+ *          portfolio.c).
  */
 
 #include "espresso.h"
 
+/* espresso_strategy -- the strategy flags which differ from the default */
+int espresso_strategy() {
+    return single_expand | !remove_essential << 1 | use_super_gasp << 2 |
+           skip_last_gasp << 3 | recompute_onset << 4 | !unwrap_onset << 5 |
+           skip_make_sparse << 6 | batch_expand << 7 |
+           exact_irredundant << 8 | reduced_offsets << 9 |
+           decompose_function << 10;
+}
+
+/* espresso_stop -- has one of the limits been reached ? */
+static bool espresso_stop(double deadline, int *passes) {
+    int *cancel = current_context->cancel;
+
+    if ((pass_limit >= 0 && (*passes)++ >= pass_limit) ||
+        (time_limit > 0 && wall_time() >= deadline) ||
+        (cancel != NULL && __atomic_load_n(cancel, __ATOMIC_RELAXED))) {
+        current_context->truncated = TRUE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* espresso_best -- keep a copy of F in *Fbest if F costs less */
+static void espresso_best(pcover F, pcover *Fbest, pcost best) {
+    cost_t cost;
+
+    cover_cost(F, &cost);
+    if (*Fbest == NULL || cost.cubes < best->cubes ||
+        (cost.cubes == best->cubes && cost.total < best->total)) {
+        if (*Fbest != NULL)
+            free_cover(*Fbest);
+        *Fbest = sf_save(F);
+        copy_cost(&cost, best);
+    }
+}
+
+/*
+    espresso_warm -- the cover to start from: the cubes of S within F u D,
+    and the cubes of F they do not cover together with D; none is marked
+    PRIME, so that expand() makes primes of them all (a cube of S which is
+    prime already is kept as it is); F is disposed of
+*/
+static pcover espresso_warm(pcover F, pcover D, pcover S) {
+    pcover F1;
+    pcube p, last, *T;
+    int kept;
+
+    F1 = new_cover(S->count + F->count);
+    T = cube2list(F, D);
+    foreach_set(S, last, p) {
+        if (cube_is_covered(T, p)) {
+            F1 = sf_addset(F1, p);
+            RESET(GETSET(F1, F1->count - 1), PRIME);
+        }
+    }
+    free_cubelist(T);
+    kept = F1->count;
+
+    T = cube2list(F1, D);
+    foreach_set(F, last, p) {
+        if (!cube_is_covered(T, p)) {
+            F1 = sf_addset(F1, p);
+            RESET(GETSET(F1, F1->count - 1), PRIME);
+        }
+    }
+    free_cubelist(T);
+
+    fprintf(stderr, "# warm start: %d of %d cubes kept, %d added\n", kept,
+            S->count, F1->count - kept);
+    free_cover(F);
+    return F1;
+}
+
 pcover espresso(pcover F, pcover D1, pcover R) {
-    pcover E, D, Fsave;
+    pcover E, D, Fsave, Fbest, care;
     pset last, p;
-    cost_t cost, best_cost;
-    bool unwrap_onset = TRUE;
+    cost_t cost, best_cost, cost_Fbest;
+    bool unwrap = unwrap_onset != current_context->unwrap_flipped, limited;
+    double deadline;
+    int passes;
+
+    limited = time_limit > 0 || pass_limit >= 0 ||
+              current_context->cancel != NULL;
+    deadline = wall_time() + time_limit;
+    current_context->truncated = FALSE;
+    care = reduced_offset_begin(F, D1);
 
 begin:
     Fsave = sf_save(F); /* save original function */
     D = sf_save(D1);    /* make a scratch copy of D */
 
-    /* Setup has always been a problem */
+    /* Setup has always been a problem (and needs R) */
+    if (recompute_onset && !reduced_offsets) {
+        free_cover(F);
+        PHASE(PHASE_COMPLEMENT, F, F = complement(cube2list(D, R)));
+    }
     cover_cost(F, &cost);
-    if (unwrap_onset && (cube.part_size[cube.num_vars - 1] > 1) &&
-        (cost.out != cost.cubes * cube.part_size[cube.num_vars - 1]) &&
-        (cost.out < 5000))
-        F = sf_contain(unravel(F, cube.num_vars - 1));
+    if (current_context->start != NULL) {
+        F = espresso_warm(F, D, current_context->start);
+        unwrap = FALSE;
+    } else {
+        if (unwrap && (cube.part_size[cube.num_vars - 1] > 1) &&
+            (cost.out != cost.cubes * cube.part_size[cube.num_vars - 1]) &&
+            (cost.out < 5000))
+            F = sf_contain(unravel(F, cube.num_vars - 1));
+        foreach_set(F, last, p) {
+            RESET(p, PRIME);
+        }
+    }
 
     /* Initial expand and irredundant */
-    foreach_set(F, last, p) {
-        RESET(p, PRIME);
+    PHASE(PHASE_EXPAND, F, F = expand(F, R, FALSE));
+    PHASE(PHASE_IRRED, F, F = irredundant(F, D));
+
+    if (remove_essential) {
+        PHASE(PHASE_ESSEN, F, E = essential(&F, &D));
+    } else {
+        E = new_cover(0);
     }
-    F = expand(F, R, FALSE);
-    F = irredundant(F, D);
 
-    E = essential(&F, &D);
+    /* With limits, the best cover seen is kept in case one is reached */
+    Fbest = NULL;
+    passes = 0;
+    if (limited)
+        espresso_best(F, &Fbest, &cost_Fbest);
 
     cover_cost(F, &cost);
+    if (single_expand)
+        goto stop;
     do {
         /* Repeat inner loop until solution becomes "stable" */
         do {
             copy_cost(&cost, &best_cost);
-            F = reduce(F, D);
-            F = expand(F, R, FALSE);
-            F = irredundant(F, D);
+            if (limited && espresso_stop(deadline, &passes))
+                goto stop;
+            PHASE(PHASE_REDUCE, F, F = reduce(F, D));
+            PHASE(PHASE_EXPAND, F, F = expand(F, R, FALSE));
+            PHASE(PHASE_IRRED, F, F = irredundant(F, D));
+            if (limited)
+                espresso_best(F, &Fbest, &cost_Fbest);
         } while (cost.cubes < best_cost.cubes);
 
         /* Perturb solution to see if we can continue to iterate */
         copy_cost(&cost, &best_cost);
 
-        F = last_gasp(F, D, R);
+        if (skip_last_gasp)
+            break;
+        if (limited && espresso_stop(deadline, &passes))
+            goto stop;
+        PHASE(PHASE_GASP, F,
+              F = use_super_gasp ? super_gasp(F, D, R) : last_gasp(F, D, R));
+        if (limited)
+            espresso_best(F, &Fbest, &cost_Fbest);
 
     } while (cost.cubes < best_cost.cubes ||
              (cost.cubes == best_cost.cubes && cost.total < best_cost.total));
 
+stop:
+    if (Fbest != NULL) {
+        if (current_context->truncated) {
+            free_cover(F);
+            F = Fbest;
+        } else {
+            free_cover(Fbest);
+        }
+    }
+
     /* Append the essential cubes to F */
     F = sf_append(F, E); /* disposes of E */
 
@@ -89,21 +247,28 @@ begin:
     free_cover(D);
 
     /* Attempt to make the PLA matrix sparse */
-    F = make_sparse(F, D1, R);
+    if (!skip_make_sparse)
+        PHASE(PHASE_SPARSE, F, F = make_sparse(F, D1, R));
 
     /*
      *  Check to make sure function is actually smaller !!
-     *  This can only happen because of the initial unravel.  If we fail,
-     *  then run the whole thing again without the unravel.
+     *  This can only happen because of the initial unravel (or of a
+     *  recomputed ON-set).  If we fail, then run the whole thing again
+     *  without the unravel (or, once that has been tried or a limit has
+     *  been reached, settle for the original function).
      */
-    if (Fsave->count < F->count) {
+    if (Fsave->count < F->count && unwrap && !current_context->truncated) {
         free_cover(F);
         F = Fsave;
-        unwrap_onset = FALSE;
+        unwrap = FALSE;
         goto begin;
+    } else if (Fsave->count < F->count) {
+        free_cover(F);
+        F = Fsave;
     } else {
         free_cover(Fsave);
     }
 
+    reduced_offset_end(care);
     return F;
 }
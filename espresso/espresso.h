@@ -18,34 +18,46 @@
  *   (otherwise known as sets, cf. Pascal).
  *
  *   A set is a vector of bits and is implemented here as an array of
- *   unsigned integers.  The low order bits of set[0] give the index of
- *   the last word of set data.  The higher order bits of set[0] are
- *   used to store data associated with the set.  The set data is
- *   contained in elements set[1] ... set[LOOP(set)] as a packed bit
- *   array.
+ *   unsigned words.  The low order bits of set[0] hold the flags of the
+ *   set, and the higher order bits give the index of the last word of
+ *   set data.  The set data is contained in elements set[1] ...
+ *   set[LOOP(set)] as a packed bit array, and the word after it is used
+ *   to store data associated with the set (SIZE).
  *
  *   A family of sets is a two-dimensional matrix of bits and is
  *   implemented with the data type "set_family".
  *
- *   BPI == 32 and BPI == 16 have been tested and work.
+ *   The word size is chosen when building: BPI == 32 (the default) and
+ *   BPI == 64 are supported.
  */
 
-/* Define host machine characteristics of "unsigned int" */
-#define BPI 32 /* # bits per integer */
+/* Define the width of a set word ("cmake -DESPRESSO_BPI=64") */
+#ifndef BPI
+#define BPI 32 /* # bits per word */
+#endif
 
+#if BPI == 64
+#define LOGBPI 6 /* log(BPI)/log(2) */
+typedef unsigned long long set_word_t;
+#elif BPI == 32
 #define LOGBPI 5 /* log(BPI)/log(2) */
+typedef unsigned int set_word_t;
+#else
+#error "BPI must be 32 or 64"
+#endif
 
 /* Define the set type */
-typedef unsigned int *pset;
+typedef set_word_t *pset;
 
 /* Define the set family type -- an array of sets */
 typedef struct set_family {
-    int wsize;               /* Size of each set in 'ints' */
+    int wsize;               /* Size of each set in words */
     int sf_size;             /* User declared set size */
     int capacity;            /* Number of sets allocated */
     int count;               /* The number of sets in the family */
     int active_count;        /* Number of "active" sets */
     pset data;               /* Pointer to the set data */
+    int mapped;              /* data lies in a mapped file (not freed) */
     struct set_family *next; /* For garbage collection */
 } set_family_t, *pset_family;
 
@@ -53,21 +65,25 @@ typedef struct set_family {
 #define WHICH_WORD(element) (((element) >> LOGBPI) + 1)
 #define WHICH_BIT(element)  ((element) & (BPI - 1))
 
-/* # of ints needed to allocate a set with "size" elements */
-#define SET_SIZE(size) ((size) <= BPI ? 2 : (WHICH_WORD((size)-1) + 1))
+/* # of words needed to allocate a set with "size" elements */
+#define SET_SIZE(size) ((size) <= BPI ? 3 : (WHICH_WORD((size)-1) + 2))
 
 /*
- *  Three fields are maintained in the first word of the set
+ *  Three fields are maintained in the set, besides its flags
  *      LOOP is the index of the last word used for set data
- *      LOOPCOPY is the index of the last word in the set
- *      SIZE is available for general use (e.g., recording # elements in set)
+ *      LOOPCOPY is the index of the last word in the set (that of SIZE)
+ *      SIZE is available for general use (e.g., recording # elements in set,
+ *          or the number of a cube in its cover); it is a whole word
  *      NELEM retrieves the number of elements in the set
  */
-#define LOOP(set)          ((set)[0] & 0x03ff)
-#define PUTLOOP(set, i)    ((set)[0] &= ~0x03ff, (set)[0] |= (i))
-#define LOOPCOPY(set)      LOOP(set)
-#define SIZE(set)          ((set)[0] >> 16)
-#define PUTSIZE(set, size) ((set)[0] &= 0xffff, (set)[0] |= ((size) << 16))
+#define LOOPSHIFT          6 /* bits of set[0] below LOOP (the flags) */
+#define LOOP(set)          ((int)((set)[0] >> LOOPSHIFT))
+#define PUTLOOP(set, i)                            \
+    ((set)[0] &= ((set_word_t)1 << LOOPSHIFT) - 1, \
+     (set)[0] |= (set_word_t)(i) << LOOPSHIFT)
+#define LOOPCOPY(set)      (LOOP(set) + 1)
+#define SIZE(set)          ((set)[LOOP(set) + 1])
+#define PUTSIZE(set, size) ((set)[LOOP(set) + 1] = (set_word_t)(size))
 
 #define NELEM(set)     (BPI * LOOP(set))
 #define LOOPINIT(size) (((size) <= BPI) ? 1 : WHICH_WORD((size)-1))
@@ -80,12 +96,12 @@ typedef struct set_family {
 #define TESTP(set, flag) ((set)[0] & (flag))
 
 /* Flag definitions are ... */
-#define PRIME    0x8000 /* cube is prime */
-#define NONESSEN 0x4000 /* cube cannot be essential prime */
-#define ACTIVE   0x2000 /* cube is still active */
-#define REDUND   0x1000 /* cube is redundant(at this point) */
-#define COVERED  0x0800 /* cube has been covered */
-#define RELESSEN 0x0400 /* cube is relatively essential */
+#define PRIME    0x20 /* cube is prime */
+#define NONESSEN 0x10 /* cube cannot be essential prime */
+#define ACTIVE   0x08 /* cube is still active */
+#define REDUND   0x04 /* cube is redundant(at this point) */
+#define COVERED  0x02 /* cube has been covered */
+#define RELESSEN 0x01 /* cube is relatively essential */
 
 /* Most efficient way to look at all members of a set family */
 #define foreach_set(R, last, p)                                   \
@@ -103,7 +119,7 @@ typedef struct set_family {
     for ((p) = (R)->data, (i) = 0; (i) < (R)->count; (p) += (R)->wsize, (i)++)
 
 /* Looping over all elements in a set:
- *      foreach_set_element(pset p, int i, unsigned val, int base) {
+ *      foreach_set_element(pset p, int i, set_word_t val, int base) {
  *		.
  *		.
  *		.
@@ -119,14 +135,15 @@ typedef struct set_family {
 #define GETSET(family, index) ((family)->data + (family)->wsize * (index))
 
 /* Allocate and deallocate sets */
-#define set_new(size) set_clear(ALLOC(unsigned int, SET_SIZE(size)), size)
-#define set_save(r)   set_copy(ALLOC(unsigned int, SET_SIZE(NELEM(r))), r)
+#define set_new(size) set_clear(ALLOC(set_word_t, SET_SIZE(size)), size)
+#define set_save(r)   set_copy(ALLOC(set_word_t, SET_SIZE(NELEM(r))), r)
 #define set_free(r)   FREE(r)
 
 /* Check for set membership, remove set element and insert set element */
-#define is_in_set(set, e)  ((set)[WHICH_WORD(e)] & (1 << WHICH_BIT(e)))
-#define set_remove(set, e) ((set)[WHICH_WORD(e)] &= ~(1 << WHICH_BIT(e)))
-#define set_insert(set, e) ((set)[WHICH_WORD(e)] |= 1 << WHICH_BIT(e))
+#define BIT(e)             ((set_word_t)1 << WHICH_BIT(e))
+#define is_in_set(set, e)  ((set)[WHICH_WORD(e)] & BIT(e))
+#define set_remove(set, e) ((set)[WHICH_WORD(e)] &= ~BIT(e))
+#define set_insert(set, e) ((set)[WHICH_WORD(e)] |= BIT(e))
 
 #define INLINEset_copy(r, a)   \
     {                          \
@@ -135,21 +152,23 @@ typedef struct set_family {
             (r)[i_] = (a)[i_]; \
         while (--i_ >= 0);     \
     }
-#define INLINEset_clear(r, size) \
-    {                            \
-        int i_ = LOOPINIT(size); \
-        *(r) = i_;               \
-        do                       \
-            (r)[i_] = 0;         \
-        while (--i_ > 0);        \
+#define INLINEset_clear(r, size)            \
+    {                                       \
+        int i_ = LOOPINIT(size);            \
+        *(r) = (set_word_t)i_ << LOOPSHIFT; \
+        (r)[i_ + 1] = 0;                    \
+        do                                  \
+            (r)[i_] = 0;                    \
+        while (--i_ > 0);                   \
     }
 #define INLINEset_fill(r, size)                                \
     {                                                          \
         int i_ = LOOPINIT(size);                               \
-        *(r) = i_;                                             \
-        (r)[i_] = ((unsigned int)(~0)) >> (i_ * BPI - (size)); \
+        *(r) = (set_word_t)i_ << LOOPSHIFT;                    \
+        (r)[i_ + 1] = 0;                                       \
+        (r)[i_] = ((set_word_t)(~0)) >> (i_ * BPI - (size));   \
         while (--i_ > 0)                                       \
-            (r)[i_] = ~0;                                      \
+            (r)[i_] = ~(set_word_t)0;                          \
     }
 #define INLINEset_and(r, a, b)           \
     {                                    \
@@ -193,21 +212,50 @@ typedef struct set_family {
     }
 #define INLINEsetp_implies(a, b, when_false) \
     {                                        \
-        int i_ = LOOP(a);                    \
-        do                                   \
-            if ((a)[i_] & ~(b)[i_])          \
-                break;                       \
-        while (--i_ > 0);                    \
-        if (i_ != 0)                         \
+        if (!setp_implies(a, b))             \
             when_false;                      \
     }
 
-#define count_ones(v)                                   \
+#define count_ones32(v)                                 \
     (bit_count[(v)&255] + bit_count[((v) >> 8) & 255] + \
      bit_count[((v) >> 16) & 255] + bit_count[((v) >> 24) & 255])
+#if BPI == 64
+#define count_ones(v) (count_ones32(v) + count_ones32((v) >> 32))
+#else
+#define count_ones(v) count_ones32(v)
+#endif
 
 /* Table for efficient bit counting */
 extern int bit_count[256];
+
+/* Index of the lowest bit set in a (nonzero) word */
+#ifdef __GNUC__
+#define LOWEST_BIT(v) __builtin_ctzll((unsigned long long)(v))
+#else
+#define LOWEST_BIT(v) bit_index(v)
+#endif
+
+/*
+ *  Column counts are accumulated bit-sliced: for each word of a set there
+ *  are "nplanes" words, and word j holds bit j of the count of each of the
+ *  word's elements.  BITCOUNT_ADD adds a word (times 2^j, when given the
+ *  planes from j on) by a ripple of half-adders across the planes, and
+ *  bitcount_flush() moves the planes into an array of integer counts.
+ *  With COUNT_PLANES planes, they must be flushed every COUNT_FLUSH sets.
+ */
+#define COUNT_PLANES 8
+#define COUNT_FLUSH  ((1 << COUNT_PLANES) - 1)
+
+#define BITCOUNT_ADD(plane, v)       \
+    {                                \
+        set_word_t c_ = (v), t_;     \
+        set_word_t *p_ = (plane);    \
+        while (c_ != 0) {            \
+            t_ = *p_ & c_;           \
+            *p_++ ^= c_;             \
+            c_ = t_;                 \
+        }                            \
+    }
 /*----- END OF set.h ----- */
 
 /* Define a boolean type */
@@ -223,9 +271,7 @@ extern int bit_count[256];
 #define pcover        pset_family
 #define new_cover(i)  sf_new(i, cube.size)
 #define free_cover(r) sf_free(r)
-#define free_cubelist(T) \
-    FREE((T)[0]);        \
-    FREE(T);
+#define free_cubelist(T) arena_free(T)
 
 /* cost_t describes the cost of a cover */
 typedef struct cost_struct {
@@ -240,6 +286,8 @@ typedef struct cost_struct {
 /* PLA_t stores the logical representation of a PLA */
 typedef struct {
     pcover F, D, R; /* on-set, off-set and dc-set */
+    void *map;      /* mapped file the covers may lie in (or NULL) */
+    size_t map_size;
 } PLA_t, *pPLA;
 
 typedef enum {
@@ -247,6 +295,30 @@ typedef enum {
     TYPE_FR,
 } pla_type_t;
 
+/* cache_key_t names an entry of the cache of cache.c */
+#define CACHE_COMPLEMENT 0 /* the complement computed by read_pla() */
+#define CACHE_RESULT     1 /* the cover computed by espresso() */
+typedef struct {
+    int kind;
+    unsigned long long h[2];
+} cache_key_t;
+
+/* the orders of sf_order() (see sort.c) */
+#define SORT_ASCEND  0 /* by increasing key */
+#define SORT_DESCEND 1 /* by decreasing key */
+#define SORT_SEEDED  2 /* ties of the key by the seed of the context */
+
+/* blocking_t is an index of the OFF-set for expand() (see blocking.c) */
+typedef struct blocking_struct blocking_t;
+
+/* memo_key_t holds a cube list looked up in the memo of memo.c */
+typedef struct memo_struct memo_t;
+typedef struct {
+    unsigned long long hash;
+    int n;             /* cubes of the list */
+    set_word_t *cubes; /* their words (NULL if not to be kept) */
+} memo_key_t;
+
 #define equal(a, b) (strcmp(a, b) == 0)
 
 /* This is a hack which I wish I hadn't done, but too painful to change */
@@ -264,6 +336,21 @@ typedef enum {
  */
 #define CUBE_TEMP 10
 
+/* the cube primitives of setc.c for one instruction set (see setc_simd.c) */
+typedef struct {
+    char *name;
+    int width; /* number of words handled at a time */
+    bool (*full_row)(pset p, pset cof);
+    bool (*setp_implies)(pset a, pset b);
+    bool (*cdist0)(pset a, pset b);
+    int (*cdist01)(pset a, pset b);
+    int (*cdist)(pset a, pset b);
+    pset (*force_lower)(pset xlower, pset a, pset b);
+    void (*consensus)(pset r, pset a, pset b);
+    bool (*ccommon)(pset a, pset b, pset cof);
+    pset *(*cofactor)(pset *T, pset c); /* NULL for that of cofactor.c */
+} setc_kernels_t;
+
 struct cube_struct {
     int size;            /* set size of a cube */
     int num_vars;        /* number of variables in a cube */
@@ -279,10 +366,11 @@ struct cube_struct {
     pset *temp;          /* an array of temporary sets */
     pset fullset;        /* a full cube */
     pset emptyset;       /* an empty cube */
-    unsigned int inmask; /* mask to get odd word of binary part */
+    set_word_t inmask;   /* mask to get odd word of binary part */
     int inword;          /* which word number for above */
     int *sparse;         /* should this variable be sparse? */
     int output;          /* which variable is "output" (-1 if none) */
+    const setc_kernels_t *setc; /* the cube primitives to use */
 };
 
 struct cdata_struct {
@@ -293,19 +381,171 @@ struct cdata_struct {
     int vars_active;   /* number of "active" variables */
     int vars_unate;    /* number of unate variables */
     int best;          /* best "binate" variable */
+    set_word_t *count_planes; /* bit-sliced counters for massive_count */
 };
 
-extern struct cube_struct cube;
-extern struct cdata_struct cdata;
+/*
+ *  The context structure holds all of the state of a single minimization:
+ *  the cube geometry, the cdata counters, the temporary cubes, the set
+ *  family free list, and the few flags which the input routines and
+ *  reduce() carry from one call to the next.
+ *
+ *  Each thread has a "current" context, and "cube" and "cdata" refer to
+ *  the fields of that context.  Independent PLAs can be minimized in
+ *  separate threads provided each thread installs its own context with
+ *  context_set().  A context created by context_share() borrows the cube
+ *  geometry of its parent, but has its own temporary cubes and cdata, so
+ *  that helper threads can work on the same PLA as the parent while the
+ *  parent context remains alive.
+ */
+/* a stack of storage for the recursions (see arena.c) */
+typedef struct arena_struct arena_t;
+
+/* the phases of espresso() and the recursions timed or counted by -P */
+#define PHASE_COMPLEMENT 0
+#define PHASE_EXPAND     1
+#define PHASE_IRRED      2
+#define PHASE_ESSEN      3
+#define PHASE_REDUCE     4
+#define PHASE_GASP       5
+#define PHASE_SPARSE     6
+#define PHASES           7
+
+#define RECUR_COMPL 0
+#define RECUR_TAUT  1
+#define RECUR_SCCC  2
+#define RECURSIONS  3
+
+/* the calls of the recursions of a context (see profile.c) */
+typedef struct {
+    long long nodes[RECURSIONS]; /* calls */
+    int depth[RECURSIONS];       /* current depth (tautology and sccc) */
+    int max_depth[RECURSIONS];   /* deepest */
+} profile_counts_t;
+
+typedef struct context_struct {
+    struct cube_struct cube_st;     /* what "cube" refers to */
+    struct cdata_struct cdata_st;   /* what "cdata" refers to */
+    pset_family set_family_garbage; /* set families released by sf_free */
+    bool toggle;                    /* alternates the ordering in reduce */
+    pla_type_t pla_type;            /* logical type of the PLA being read */
+    int lineno;                     /* current input line (for warnings) */
+    bool line_length_error;         /* warned about cubes spanning lines */
+    struct context_struct *parent;  /* owner of the cube geometry (or NULL) */
+    jmp_buf *fatal_env;             /* where fatal() returns to (or NULL) */
+    arena_t *arena;                 /* cube lists of the recursions */
+    bool truncated;                 /* espresso() stopped at a limit */
+    profile_counts_t prof;          /* calls of the recursions */
+    memo_t *memo;                   /* answers of tautology() (memo.c) */
+    blocking_t *blocking;           /* index of R during expand() */
+    bool unwrap_flipped;            /* espresso() inverts unwrap_onset */
+    unsigned long long seed;        /* orders the cubes tied in sorts (or 0) */
+    int *cancel;                    /* espresso() stops once it is set */
+    pset_family care;               /* F u D for reduced OFF-sets (or NULL) */
+    pset_family start;              /* cover espresso() starts from (or NULL) */
+    int phase;                      /* of espresso() running (or -1) */
+} context_t, *pcontext;
+
+extern context_t default_context;
+extern THREAD_LOCAL pcontext current_context;
+extern bool print_npterms;
+extern bool print_binary;
+extern bool verify_result;
+extern bool single_expand;
+extern bool remove_essential;
+extern bool use_super_gasp;
+extern bool skip_last_gasp;
+extern bool recompute_onset;
+extern bool unwrap_onset;
+extern bool skip_make_sparse;
+extern bool batch_expand;
+extern bool exact_irredundant;
+extern bool reduced_offsets;
+extern bool decompose_function;
+extern double time_limit;
+extern int pass_limit;
+extern int portfolio_starts;
+extern int portfolio_target;
+extern bool profiling;
+
+#define cube  (current_context->cube_st)
+#define cdata (current_context->cdata_st)
+
+/* count a call of recursion "r" at "depth", or entering and leaving it */
+#define RECUR_NODE(r, depth)                              \
+    {                                                     \
+        profile_counts_t *prof_ = &current_context->prof; \
+        prof_->nodes[r]++;                                \
+        if ((depth) > prof_->max_depth[r])                \
+            prof_->max_depth[r] = (depth);                \
+    }
+#define RECUR_ENTER(r)                                    \
+    {                                                     \
+        profile_counts_t *prof_ = &current_context->prof; \
+        prof_->nodes[r]++;                                \
+        if (++prof_->depth[r] > prof_->max_depth[r])      \
+            prof_->max_depth[r] = prof_->depth[r];        \
+    }
+#define RECUR_LEAVE(r) (current_context->prof.depth[r]--)
+
+/*
+ *  run "stmt", a phase of espresso() leaving the cover F, timing it (the
+ *  phase is noted in the context for the allocation profile, alloc.c)
+ */
+#define PHASE(which, F, stmt)                     \
+    {                                             \
+        int phase_save_ = current_context->phase; \
+        double phase_start_ = profile_start();    \
+        current_context->phase = which;           \
+        stmt;                                     \
+        current_context->phase = phase_save_;     \
+        profile_phase(which, phase_start_, F);    \
+    }
+
+/* a word with the low bit of each binary variable (0x5555...) */
+#define DISJOINT ((set_word_t)~0 / 3)
 
-#define DISJOINT 0x55555555
+/* a set of tasks spawned together (see parallel.c) */
+typedef struct task_group_struct {
+    int pending; /* number of tasks not yet finished */
+} task_group_t;
 
 /* function declarations */
+/* alloc.c */
+void alloc_profile_setup();
+void alloc_family(pset_family A);
+void alloc_profile_write(FILE *fp, char **phase_name);
+/* arena.c */
+void *arena_alloc(size_t bytes);
+void arena_free(void *p);
+void arena_release(pcontext ctx);
+void arena_reset(pcontext ctx);
+pset arena_cube();
+/* batch.c */
+int batch_read_manifest(char *manifest, char ***files, int *nfiles);
+int batch_minimize(char **files, int nfiles, char *outdir, int nthreads,
+                   FILE *fpsummary);
+/* blocking.c */
+blocking_t *blocking_new(pset_family R);
+blocking_t *blocking_share(blocking_t *bi, pset_family R);
+void blocking_free(blocking_t *bi);
+void blocking_reset(pset_family BB);
+bool blocking_essen(pset_family BB, pset r, pset xlower);
+int blocking_feasible(pset_family BB, pset r, pset new_lower);
+bool blocking_elim(pset_family BB, pset r);
+bool blocking_union(pset_family BB, pset parts, pset xunion);
+/* cache.c */
+bool cache_open(char *dir);
+void cache_report(FILE *fp);
+void cache_key(cache_key_t *key, int kind, pPLA PLA, char *mode);
+bool cache_get(cache_key_t *key, pPLA PLA);
+void cache_put(cache_key_t *key, pPLA PLA);
 /* cofactor.c */
 pset *cofactor(pset *T, pset c);
 pset *scofactor(pset *T, pset c, int var);
 void massive_count(pset *T);
 int binate_split_select(pset *T, pset cleft, pset cright);
+pset *new_cubelist(int n);
 pset *cube1list(pset_family A);
 pset *cube2list(pset_family A, pset_family B);
 pset *cube3list(pset_family A, pset_family B, pset_family C);
@@ -319,36 +559,48 @@ pset_family sf_dupl(pset_family A);
 int rm_equal(pset *A1, int (*compare)(pset *, pset *));
 int rm_contain(pset *A1);
 int rm_rev_contain(pset *A1);
-pset *sf_sort(pset_family A, int (*compare)(pset *, pset *));
+pset *sf_sort(pset_family A, int order);
 pset *sf_list(pset_family A);
 pset_family sf_unlist(pset *A1, int totcnt, int size);
 pset_family d1merge(pset_family A, int var);
 /* cubestr.c */
 void cube_setup();
 void setdown_cube();
+pcontext context_new();
+pcontext context_share(pcontext parent);
+void context_free(pcontext ctx);
+void context_reset(pcontext ctx, bool keep_cube);
+pcontext context_set(pcontext ctx);
+/* cvrbin.c */
+bool is_binary_pla(const char *buf, size_t len);
+size_t read_binary_pla(pPLA PLA, char *buf, size_t len, bool mapped);
+void fprint_binary_pla(FILE *fp, pPLA PLA);
 /* cvrin.c */
-void skip_line(FILE *fpin);
-char *get_word(FILE *fp, char *word);
-void read_cube(FILE *fp, pPLA PLA);
 void parse_pla(FILE *fp, pPLA PLA);
 int read_pla(FILE *fp, pPLA *PLA_return);
+int read_pla_text(const char *text, size_t len, pPLA *PLA_return);
+pcover read_start(FILE *fp);
 pPLA new_PLA();
 void free_PLA(pPLA PLA);
 /* cvrm.c */
 pset_family unravel_range(pset_family B, int start, int end);
 pset_family unravel(pset_family B, int start);
-pset_family mini_sort(pset_family F, int (*compare)(pset *, pset *));
+pset_family mini_sort(pset_family F, int order);
 pset_family sort_reduce(pset_family T);
 int cubelist_partition(pset *T, pset **A, pset **B);
 /* cvrmisc.c */
 void cover_cost(pset_family F, pcost cost);
 void copy_cost(pcost s, pcost d);
 void fatal(char *s);
+double wall_time();
 /* cvrout.c */
 void fprint_pla(FILE *fp, pPLA PLA);
 void print_cube(FILE *fp, pset c, char *out_map);
+/* decomp.c */
+pset_family espresso_decomposed(pset_family F, pset_family D, pset_family R);
 /* espresso.c */
 pset_family espresso(pset_family F, pset_family D1, pset_family R);
+int espresso_strategy();
 /* essen.c */
 pset_family essential(pset_family *Fp, pset_family *Dp);
 int essen_cube(pset_family F, pset_family D, pset c);
@@ -375,6 +627,7 @@ void expand1_gasp(pset_family F, pset_family D, pset_family R,
                   pset_family Foriginal, int c1index, pset_family *G);
 pset_family irred_gasp(pset_family F, pset_family D, pset_family G);
 pset_family last_gasp(pset_family F, pset_family D, pset_family R);
+pset_family super_gasp(pset_family F, pset_family D, pset_family R);
 /* irred.c */
 pset_family irredundant(pset_family F, pset_family D);
 void mark_irredundant(pset_family F, pset_family D);
@@ -384,6 +637,35 @@ sm_matrix *irred_derive_table(pset_family D, pset_family E, pset_family Rp);
 int cube_is_covered(pset *T, pset c);
 int tautology(pset *T);
 int taut_special_cases(pset *T);
+/* memo.c */
+int memo_lookup(pset *T, memo_key_t *key);
+void memo_store(memo_key_t *key, int result);
+void memo_free(pcontext ctx);
+void memo_counts(long long counts[4]);
+void memo_report(FILE *fp);
+/* offset.c */
+pset_family reduced_offset_begin(pset_family F, pset_family D);
+void reduced_offset_end(pset_family save);
+pset_family reduced_offset(pset c);
+void reduced_offset_report(FILE *fp);
+/* opart.c */
+pset_family espresso_partitioned(pset_family F, pset_family D, pset_family R,
+                                 int ngroups);
+/* parallel.c */
+void parallel_setup(int nthreads);
+void parallel_setdown();
+int parallel_threads();
+void task_spawn(task_group_t *group, void (*func)(void *), void *arg);
+void task_wait(task_group_t *group);
+void parallel_for(int n, void (*func)(void *, int), void *arg);
+/* portfolio.c */
+pset_family espresso_portfolio(pset_family F, pset_family D, pset_family R);
+/* profile.c */
+void profile_open();
+double profile_start();
+void profile_phase(int phase, double start, pset_family F);
+void profile_merge(pcontext ctx);
+void profile_write(FILE *fp);
 /* reduce.c */
 pset_family reduce(pset_family F, pset_family D);
 pset reduce_cube(pset *FD, pset p);
@@ -391,8 +673,10 @@ pset sccc(pset *T);
 pset sccc_merge(pset left, pset right, pset cl, pset cr);
 pset sccc_cube(pset result, pset p);
 int sccc_special_cases(pset *T, pset *result);
+/* server.c */
+int server_run(char *path, int nthreads);
 /* set.c */
-int bit_index(unsigned int a);
+int bit_index(set_word_t a);
 int set_ord(pset a);
 int set_dist(pset a, pset b);
 pset set_clear(pset r, int size);
@@ -405,13 +689,13 @@ pset set_merge(pset r, pset a, pset b, pset mask);
 int setp_empty(pset a);
 int setp_equal(pset a, pset b);
 int setp_disjoint(pset a, pset b);
-int setp_implies(pset a, pset b);
 pset_family sf_active(pset_family A);
 pset_family sf_inactive(pset_family A);
 pset_family sf_copy(pset_family R, pset_family A);
 pset_family sf_join(pset_family A, pset_family B);
 pset_family sf_append(pset_family A, pset_family B);
 pset_family sf_new(int num, int size);
+pset_family sf_mapped(pset data, int num, int size);
 pset_family sf_save(pset_family A);
 void sf_free(pset_family A);
 void sf_cleanup();
@@ -419,20 +703,31 @@ pset_family sf_addset(pset_family A, pset s);
 void set_adjcnt(pset a, int *count, int weight);
 int *sf_count(pset_family A);
 int *sf_count_restricted(pset_family A, pset r);
+void bitcount_flush(set_word_t *plane, int nplanes, int nwords, int *count);
 /* setc.c */
-int full_row(pset p, pset cof);
-int cdist0(pset a, pset b);
-int cdist01(pset a, pset b);
-int cdist(pset a, pset b);
-pset force_lower(pset xlower, pset a, pset b);
-void consensus(pset r, pset a, pset b);
+extern const setc_kernels_t setc_scalar;
+#define full_row(p, cof)         (*cube.setc->full_row)(p, cof)
+#define setp_implies(a, b)       (*cube.setc->setp_implies)(a, b)
+#define cdist0(a, b)             (*cube.setc->cdist0)(a, b)
+#define cdist01(a, b)            (*cube.setc->cdist01)(a, b)
+#define cdist(a, b)              (*cube.setc->cdist)(a, b)
+#define force_lower(xl, a, b)    (*cube.setc->force_lower)(xl, a, b)
+#define consensus(r, a, b)       (*cube.setc->consensus)(r, a, b)
+#define ccommon(a, b, cof)       (*cube.setc->ccommon)(a, b, cof)
 int cactive(pset a);
-int ccommon(pset a, pset b, pset cof);
 int descend(pset *a, pset *b);
 int ascend(pset *a, pset *b);
 int d1_order(pset *a, pset *b);
+/* setc_fixed.c */
+const setc_kernels_t *setc_fixed(int words);
+/* setc_simd.c */
+const setc_kernels_t *setc_select();
 /* sminterf.c */
 pset do_sm_minimum_cover(pset_family A);
+/* sort.c */
+int *sf_order(pset_family A, unsigned int *key, pset mask, int flags);
+void sf_permute(pset_family A, int *order);
+pset_family sf_keep(pset_family A, pset *A1, int cnt);
 /* sparse.c */
 pset_family make_sparse(pset_family F, pset_family D, pset_family R);
 pset_family mv_reduce(pset_family F, pset_family D);
@@ -441,3 +736,5 @@ pset_family map_cover_to_unate(pset *T);
 pset_family map_unate_to_cover(pset_family A);
 pset_family unate_compl(pset_family A);
 pset_family unate_complement(pset_family A);
+/* verify.c */
+bool espresso_verify(pset_family F, pset_family F0, pset_family D);
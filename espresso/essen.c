@@ -24,9 +24,23 @@
     on these primes for essentiality.
 */
 
+typedef struct {
+    pcover F, D;  /* the function */
+    pcube *cand;  /* the primes to check */
+    bool *essen;  /* the results for each of them */
+} essen_check_t;
+
+static void essen_check(void *arg, int i) {
+    essen_check_t *check = (essen_check_t *)arg;
+
+    check->essen[i] = essen_cube(check->F, check->D, check->cand[i]);
+}
+
 pcover essential(pcover *Fp, pcover *Dp) {
     pcube last, p;
     pcover E, F = *Fp, D = *Dp;
+    essen_check_t check;
+    int i, ncand;
 
     /* set all cubes in F active */
     (void)sf_active(F);
@@ -34,21 +48,36 @@ pcover essential(pcover *Fp, pcover *Dp) {
     /* Might as well start out with some cubes in E */
     E = new_cover(10);
 
+    /* collect the primes worth testing */
+    check.F = F;
+    check.D = D;
+    check.cand = ALLOC(pcube, F->count);
+    check.essen = ALLOC(bool, F->count);
+    ncand = 0;
     foreach_set(F, last, p) {
         /* don't test a prime which EXPAND says is nonessential */
         if (!TESTP(p, NONESSEN)) {
             /* only test a prime which was relatively essential */
             if (TESTP(p, RELESSEN)) {
-                /* Check essentiality */
-                if (essen_cube(F, D, p)) {
-                    E = sf_addset(E, p);
-                    RESET(p, ACTIVE);
-                    F->active_count--;
-                }
+                check.cand[ncand++] = p;
             }
         }
     }
 
+    /* Check essentiality (the tests only read F and D) */
+    parallel_for(ncand, essen_check, &check);
+
+    for (i = 0; i < ncand; i++) {
+        if (check.essen[i]) {
+            p = check.cand[i];
+            E = sf_addset(E, p);
+            RESET(p, ACTIVE);
+            F->active_count--;
+        }
+    }
+    FREE(check.cand);
+    FREE(check.essen);
+
     *Fp = sf_inactive(F); /* delete the inactive cubes from F */
     *Dp = sf_join(D, E);  /* add the essentials to D */
     sf_free(D);
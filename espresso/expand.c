@@ -29,8 +29,60 @@
         starting the expansion
 */
 
+#include <pthread.h>
+
 #include "espresso.h"
 
+/* Number of cubes expanded at a time by expand_batched() */
+#define EXPAND_BATCH 16
+
+/* the copies of F and R on which a thread expands the cubes of a batch */
+typedef struct {
+    pcover F, R;
+    blocking_t *blocking; /* the index of R (if F was given one) */
+    pcube RAISE, FREESET, SUPER_CUBE, OVEREXPANDED_CUBE;
+    int marked; /* the cubes of the batch before this one are marked PRIME */
+} expand_slot_t;
+
+/* the expansion of a cube of the batch, until it is committed */
+typedef struct {
+    pcube raise;   /* the prime found */
+    bool nonessen; /* known not to be essential */
+    int *covered;  /* the cubes of F it covers */
+    int ncovered;
+} expand_result_t;
+
+typedef struct {
+    pcover F;               /* F as it was at the start of the batch */
+    pcube INIT_LOWER;
+    int *cand, ncand;       /* the cubes of the batch (indices into F) */
+    int next;               /* the next one to be expanded */
+    int *dirty, ndirty;     /* the cubes of F changed by the last batch */
+    int dirty_size;
+    expand_slot_t *slots;
+    expand_result_t *result;
+    pthread_mutex_t lock;
+} expand_batch_t;
+
+static void expand_batched(pcover F, pcover R, pcube INIT_LOWER);
+
+/* expand_cube -- expand1() against R, or against the reduced OFF-set of c */
+static void expand_cube(pcover R, pcover F, pcube RAISE, pcube FREESET,
+                        pcube OVEREXPANDED_CUBE, pcube SUPER_CUBE,
+                        pcube INIT_LOWER, int *num_covered, pcube c) {
+    pcover Rc;
+
+    if (current_context->care == NULL) {
+        expand1(R, F, RAISE, FREESET, OVEREXPANDED_CUBE, SUPER_CUBE,
+                INIT_LOWER, num_covered, c);
+    } else {
+        Rc = reduced_offset(c);
+        expand1(Rc, F, RAISE, FREESET, OVEREXPANDED_CUBE, SUPER_CUBE,
+                INIT_LOWER, num_covered, c);
+        free_cover(Rc);
+    }
+}
+
 /*
     expand -- expand each nonprime cube of F into a prime implicant
 
@@ -45,9 +97,10 @@ pcover expand(pcover F, pcover R,
     pcube RAISE, FREESET, INIT_LOWER, SUPER_CUBE, OVEREXPANDED_CUBE;
     int var, num_covered;
     bool change;
+    blocking_t *save = current_context->blocking;
 
     /* Order the cubes according to "chewing-away from the edges" of mini */
-    F = mini_sort(F, ascend);
+    F = mini_sort(F, SORT_ASCEND);
 
     /* Allocate memory for variables needed by expand1() */
     RAISE = new_cube();
@@ -62,6 +115,9 @@ pcover expand(pcover F, pcover R,
             if (cube.sparse[var])
                 (void)set_or(INIT_LOWER, INIT_LOWER, cube.var_mask[var]);
 
+    /* Index the OFF-set for the checks of expand1() (if large enough) */
+    current_context->blocking = blocking_new(R);
+
     /* Mark all cubes as not covered, and maybe essential */
     foreach_set(F, last, p) {
         RESET(p, COVERED);
@@ -69,19 +125,23 @@ pcover expand(pcover F, pcover R,
     }
 
     /* Try to expand each nonprime and noncovered cube */
-    foreach_set(F, last, p) {
-        /* do not expand if PRIME or if covered by previous expansion */
-        if (!TESTP(p, PRIME) && !TESTP(p, COVERED)) {
-            /* expand the cube p, result is RAISE */
-            expand1(R, F, RAISE, FREESET, OVEREXPANDED_CUBE, SUPER_CUBE,
-                    INIT_LOWER, &num_covered, p);
-            (void)set_copy(p, RAISE);
-            SET(p, PRIME);
-            RESET(p, COVERED); /* not really necessary */
-
-            /* See if we generated an inessential prime */
-            if (num_covered == 0 && !setp_equal(p, OVEREXPANDED_CUBE)) {
-                SET(p, NONESSEN);
+    if (batch_expand) {
+        expand_batched(F, R, INIT_LOWER);
+    } else {
+        foreach_set(F, last, p) {
+            /* do not expand if PRIME or if covered by previous expansion */
+            if (!TESTP(p, PRIME) && !TESTP(p, COVERED)) {
+                /* expand the cube p, result is RAISE */
+                expand_cube(R, F, RAISE, FREESET, OVEREXPANDED_CUBE,
+                            SUPER_CUBE, INIT_LOWER, &num_covered, p);
+                (void)set_copy(p, RAISE);
+                SET(p, PRIME);
+                RESET(p, COVERED); /* not really necessary */
+
+                /* See if we generated an inessential prime */
+                if (num_covered == 0 && !setp_equal(p, OVEREXPANDED_CUBE)) {
+                    SET(p, NONESSEN);
+                }
             }
         }
     }
@@ -106,9 +166,160 @@ pcover expand(pcover F, pcover R,
     free_cube(INIT_LOWER);
     free_cube(SUPER_CUBE);
     free_cube(OVEREXPANDED_CUBE);
+    blocking_free(current_context->blocking);
+    current_context->blocking = save;
     return F;
 }
 
+/* expand_slot -- expand the cubes of the batch taken by slot "i" */
+static void expand_slot(void *arg, int i) {
+    expand_batch_t *batch = (expand_batch_t *)arg;
+    expand_slot_t *slot = &batch->slots[i];
+    blocking_t *save = current_context->blocking; /* of expand(), if inline */
+    expand_result_t *res;
+    pcube c, p;
+    int j, k, num_covered;
+
+    /* bring the copy of F up to date with the last commit */
+    for (j = 0; j < batch->ndirty; j++)
+        (void)set_copy(GETSET(slot->F, batch->dirty[j]),
+                       GETSET(batch->F, batch->dirty[j]));
+    slot->marked = 0;
+    current_context->blocking = slot->blocking;
+
+    for (;;) {
+        (void)pthread_mutex_lock(&batch->lock);
+        k = batch->next++;
+        (void)pthread_mutex_unlock(&batch->lock);
+        if (k >= batch->ncand)
+            break;
+
+        /* F as the serial expand would see it, the cubes before c prime */
+        for (; slot->marked < k; slot->marked++)
+            SET(GETSET(slot->F, batch->cand[slot->marked]), PRIME);
+
+        c = GETSET(slot->F, batch->cand[k]);
+        expand_cube(slot->R, slot->F, slot->RAISE, slot->FREESET,
+                    slot->OVEREXPANDED_CUBE, slot->SUPER_CUBE,
+                    batch->INIT_LOWER, &num_covered, c);
+
+        res = &batch->result[k];
+        (void)set_copy(res->raise, slot->RAISE);
+        res->nonessen = num_covered == 0 &&
+                        !setp_equal(slot->RAISE, slot->OVEREXPANDED_CUBE);
+        res->covered = ALLOC(int, MAX(num_covered, 1));
+        res->ncovered = 0;
+        foreachi_set(slot->F, j, p) {
+            if (TESTP(p, COVERED) && !TESTP(GETSET(batch->F, j), COVERED)) {
+                res->covered[res->ncovered++] = j;
+                RESET(p, COVERED);
+            }
+        }
+        slot->marked = k + 1; /* c was marked PRIME by expand1() */
+    }
+    current_context->blocking = save;
+}
+
+/*
+    expand_batched -- the loop of expand() over F, a batch of EXPAND_BATCH
+    cubes at a time (concurrently when there is a thread pool)
+
+    The cubes of a batch are expanded against F as it was at the start of
+    the batch, each on a copy of F and R of its thread (expand1() marks
+    their cubes), as if the cubes of the batch before it were already
+    prime.  The expansions are then committed in the order of F, the
+    same way as expand() does; a cube covered by a prime committed before
+    it is dropped.  The result does not depend on the number of threads.
+*/
+static void expand_batched(pcover F, pcover R, pcube INIT_LOWER) {
+    expand_batch_t batch;
+    expand_slot_t *slot;
+    expand_result_t *res;
+    pcube p;
+    int i, j, k, nslots = parallel_threads(), pos = 0;
+
+    batch.F = F;
+    batch.INIT_LOWER = INIT_LOWER;
+    batch.cand = ALLOC(int, EXPAND_BATCH);
+    batch.dirty_size = 2 * EXPAND_BATCH;
+    batch.dirty = ALLOC(int, batch.dirty_size);
+    batch.ndirty = 0;
+    batch.result = ALLOC(expand_result_t, EXPAND_BATCH);
+    for (k = 0; k < EXPAND_BATCH; k++)
+        batch.result[k].raise = new_cube();
+    batch.slots = ALLOC(expand_slot_t, nslots);
+    for (i = 0; i < nslots; i++) {
+        slot = &batch.slots[i];
+        slot->F = sf_save(F);
+        slot->R = sf_save(R);
+        slot->blocking = blocking_share(current_context->blocking, slot->R);
+        slot->RAISE = new_cube();
+        slot->FREESET = new_cube();
+        slot->SUPER_CUBE = new_cube();
+        slot->OVEREXPANDED_CUBE = new_cube();
+    }
+    (void)pthread_mutex_init(&batch.lock, NULL);
+
+    for (;;) {
+        /* the next nonprime and noncovered cubes */
+        for (batch.ncand = 0; pos < F->count && batch.ncand < EXPAND_BATCH;
+             pos++) {
+            p = GETSET(F, pos);
+            if (!TESTP(p, PRIME) && !TESTP(p, COVERED))
+                batch.cand[batch.ncand++] = pos;
+        }
+        if (batch.ncand == 0)
+            break;
+        batch.next = 0;
+        parallel_for(nslots, expand_slot, &batch);
+
+        /* commit them in order (and note what the copies of F miss) */
+        batch.ndirty = 0;
+        for (k = 0; k < batch.ncand; k++) {
+            res = &batch.result[k];
+            p = GETSET(F, batch.cand[k]);
+            if (batch.ndirty + res->ncovered + 1 > batch.dirty_size) {
+                batch.dirty_size = 2 * (batch.ndirty + res->ncovered + 1);
+                batch.dirty = REALLOC(int, batch.dirty, batch.dirty_size);
+            }
+            batch.dirty[batch.ndirty++] = batch.cand[k];
+            if (!TESTP(p, COVERED)) {
+                (void)set_copy(p, res->raise);
+                SET(p, PRIME);
+                RESET(p, COVERED);
+                if (res->nonessen)
+                    SET(p, NONESSEN);
+                for (j = 0; j < res->ncovered; j++) {
+                    p = GETSET(F, res->covered[j]);
+                    if (!TESTP(p, PRIME) && !TESTP(p, COVERED)) {
+                        SET(p, COVERED);
+                        batch.dirty[batch.ndirty++] = res->covered[j];
+                    }
+                }
+            }
+            FREE(res->covered);
+        }
+    }
+
+    (void)pthread_mutex_destroy(&batch.lock);
+    for (i = 0; i < nslots; i++) {
+        slot = &batch.slots[i];
+        free_cover(slot->F);
+        free_cover(slot->R);
+        blocking_free(slot->blocking);
+        free_cube(slot->RAISE);
+        free_cube(slot->FREESET);
+        free_cube(slot->SUPER_CUBE);
+        free_cube(slot->OVEREXPANDED_CUBE);
+    }
+    for (k = 0; k < EXPAND_BATCH; k++)
+        free_cube(batch.result[k].raise);
+    FREE(batch.slots);
+    FREE(batch.result);
+    FREE(batch.cand);
+    FREE(batch.dirty);
+}
+
 /*
     expand1 -- Expand a single cube against the OFF-set
 */
@@ -189,51 +400,53 @@ void essen_parts(pcover BB, pcover CC, pcube RAISE, pcube FREESET) {
 
     (void)set_copy(xlower, cube.emptyset);
 
-    foreach_active_set(BB, lastp, p) {
+    if (!blocking_essen(BB, r, xlower)) {
+        foreach_active_set(BB, lastp, p) {
 #ifdef NO_INLINE
-        if ((dist = cdist01(p, r)) > 1)
-            goto exit_if;
+            if ((dist = cdist01(p, r)) > 1)
+                goto exit_if;
 #else
-        {
-            int w, last;
-            unsigned int x;
-            dist = 0;
-            if ((last = cube.inword) != -1) {
-                x = p[last] & r[last];
-                if ((x = ~(x | x >> 1) & cube.inmask))
-                    if ((dist = count_ones(x)) > 1)
-                        goto exit_if;
-                for (w = 1; w < last; w++) {
-                    x = p[w] & r[w];
-                    if ((x = ~(x | x >> 1) & DISJOINT))
-                        if (dist == 1 || (dist += count_ones(x)) > 1)
+            {
+                int w, last;
+                set_word_t x;
+                dist = 0;
+                if ((last = cube.inword) != -1) {
+                    x = p[last] & r[last];
+                    if ((x = ~(x | x >> 1) & cube.inmask))
+                        if ((dist = count_ones(x)) > 1)
                             goto exit_if;
+                    for (w = 1; w < last; w++) {
+                        x = p[w] & r[w];
+                        if ((x = ~(x | x >> 1) & DISJOINT))
+                            if (dist == 1 || (dist += count_ones(x)) > 1)
+                                goto exit_if;
+                    }
                 }
             }
-        }
-        {
-            int w, var, last;
-            pcube mask;
-            for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
-                mask = cube.var_mask[var];
-                last = cube.last_word[var];
-                for (w = cube.first_word[var]; w <= last; w++)
-                    if (p[w] & r[w] & mask[w])
-                        goto nextvar;
-                if (++dist > 1)
-                    goto exit_if;
-            nextvar:;
+            {
+                int w, var, last;
+                pcube mask;
+                for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+                    mask = cube.var_mask[var];
+                    last = cube.last_word[var];
+                    for (w = cube.first_word[var]; w <= last; w++)
+                        if (p[w] & r[w] & mask[w])
+                            goto nextvar;
+                    if (++dist > 1)
+                        goto exit_if;
+                nextvar:;
+                }
             }
-        }
 #endif
-        if (dist == 0) {
-            fatal("ON-set and OFF-set are not orthogonal");
-        } else {
-            (void)force_lower(xlower, p, r);
-            BB->active_count--;
-            RESET(p, ACTIVE);
+            if (dist == 0) {
+                fatal("ON-set and OFF-set are not orthogonal");
+            } else {
+                (void)force_lower(xlower, p, r);
+                BB->active_count--;
+                RESET(p, ACTIVE);
+            }
+        exit_if:;
         }
-    exit_if:;
     }
 
     if (!setp_empty(xlower)) {
@@ -255,7 +468,8 @@ void essen_raising(pcover BB, pcube RAISE, pcube FREESET) {
 
     /* Form union of all cubes of BB, and then take complement wrt FREESET */
     (void)set_copy(xraise, cube.emptyset);
-    foreach_active_set(BB, last, p) INLINEset_or(xraise, xraise, p);
+    if (!blocking_union(BB, FREESET, xraise))
+        foreach_active_set(BB, last, p) INLINEset_or(xraise, xraise, p);
     (void)set_diff(xraise, FREESET, xraise);
 
     (void)set_or(RAISE, RAISE, xraise);       /* add to raising set */
@@ -278,41 +492,43 @@ void elim_lowering(pcover BB, pcover CC, pcube RAISE, pcube FREESET) {
     /*
      *  Remove sets of BB which are orthogonal to future expansions
      */
-    foreach_active_set(BB, last, p) {
+    if (!blocking_elim(BB, r)) {
+        foreach_active_set(BB, last, p) {
 #ifdef NO_INLINE
-        if (!cdist0(p, r))
+            if (!cdist0(p, r))
 #else
-        {
-            int w, lastw;
-            unsigned int x;
-            if ((lastw = cube.inword) != -1) {
-                x = p[lastw] & r[lastw];
-                if (~(x | x >> 1) & cube.inmask)
-                    goto false;
-                for (w = 1; w < lastw; w++) {
-                    x = p[w] & r[w];
-                    if (~(x | x >> 1) & DISJOINT)
+            {
+                int w, lastw;
+                set_word_t x;
+                if ((lastw = cube.inword) != -1) {
+                    x = p[lastw] & r[lastw];
+                    if (~(x | x >> 1) & cube.inmask)
                         goto false;
+                    for (w = 1; w < lastw; w++) {
+                        x = p[w] & r[w];
+                        if (~(x | x >> 1) & DISJOINT)
+                            goto false;
+                    }
                 }
             }
-        }
-        {
-            int w, var, lastw;
-            pcube mask;
-            for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
-                mask = cube.var_mask[var];
-                lastw = cube.last_word[var];
-                for (w = cube.first_word[var]; w <= lastw; w++)
-                    if (p[w] & r[w] & mask[w])
-                        goto nextvar;
-                goto false;
-            nextvar:;
+            {
+                int w, var, lastw;
+                pcube mask;
+                for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+                    mask = cube.var_mask[var];
+                    lastw = cube.last_word[var];
+                    for (w = cube.first_word[var]; w <= lastw; w++)
+                        if (p[w] & r[w] & mask[w])
+                            goto nextvar;
+                    goto false;
+                nextvar:;
+                }
             }
-        }
-        continue;
-        false:
+            continue;
+            false:
 #endif
-            BB->active_count--, RESET(p, ACTIVE);
+                BB->active_count--, RESET(p, ACTIVE);
+        }
     }
 
     /*
@@ -377,6 +593,7 @@ void setup_BB_CC(pcover BB, pcover CC) {
     /* Create the block and cover set families */
     BB->active_count = BB->count;
     foreach_set(BB, last, p) SET(p, ACTIVE);
+    blocking_reset(BB);
 
     if (CC != (pcover)NULL) {
         CC->active_count = CC->count;
@@ -502,10 +719,12 @@ loop:
 
 bool feasibly_covered(pcover BB, pcube c, pcube RAISE, pcube new_lower) {
     pcube p, r = set_or(cube.temp[0], RAISE, c);
-    int dist;
+    int dist, feasible;
     pcube lastp;
 
     set_copy(new_lower, cube.emptyset);
+    if ((feasible = blocking_feasible(BB, r, new_lower)) != MAYBE)
+        return feasible;
     foreach_active_set(BB, lastp, p) {
 #ifdef NO_INLINE
         if ((dist = cdist01(p, r)) > 1)
@@ -513,7 +732,7 @@ bool feasibly_covered(pcover BB, pcube c, pcube RAISE, pcube new_lower) {
 #else
         {
             int w, last;
-            unsigned int x;
+            set_word_t x;
             dist = 0;
             if ((last = cube.inword) != -1) {
                 x = p[last] & r[last];
@@ -13,10 +13,65 @@
     super_gasp is a variation on this strategy which extracts a minimal
     subset from the set of all prime implicants which cover all
     maximally reduced cubes.
+
+    Both the reductions and the expansions of the cubes are independent
+    of each other; with a thread pool, they are computed concurrently
+    and gathered in the order of F, so that the result is the same as
+    when they are computed one after the other.
 */
 
+#include <pthread.h>
+
 #include "espresso.h"
 
+#define SUPER_GASP_PRIMES 256 /* primes enumerated at most for a cube */
+
+/* the maximal reductions of the cubes of F (one task each) */
+typedef struct {
+    pcover F;
+    pcube *FD;
+    pcube *cunder; /* the reduction of each cube of F */
+} gasp_reduce_t;
+
+/* the expansions of the cubes of F (one task per thread) */
+typedef struct {
+    pcover F, D, R, Foriginal;
+    pcover *G;            /* the primes found from each cube of F */
+    int next;             /* the next cube of F to expand */
+    pthread_mutex_t lock; /* guards next */
+} gasp_expand_t;
+
+static void reduce_gasp_task(void *arg, int i) {
+    gasp_reduce_t *red = (gasp_reduce_t *)arg;
+
+    red->cunder[i] = reduce_cube(red->FD, GETSET(red->F, i));
+}
+
+/*
+ *  expand_gasp_slot -- expand the cubes of F taken by one thread, on
+ *  copies of F and R (expand1_gasp() marks their cubes)
+ */
+static void expand_gasp_slot(void *arg, int i) {
+    gasp_expand_t *exp = (gasp_expand_t *)arg;
+    pcover F, R;
+    int c1index;
+
+    (void)i;
+    F = sf_save(exp->F);
+    R = sf_save(exp->R);
+    for (;;) {
+        (void)pthread_mutex_lock(&exp->lock);
+        c1index = exp->next++;
+        (void)pthread_mutex_unlock(&exp->lock);
+        if (c1index >= F->count)
+            break;
+        exp->G[c1index] = new_cover(4);
+        expand1_gasp(F, exp->D, R, exp->Foriginal, c1index, &exp->G[c1index]);
+    }
+    free_cover(F);
+    free_cover(R);
+}
+
 /*
  *  reduce_gasp -- compute the maximal reduction of each cube of F
  *
@@ -29,15 +84,22 @@
  *  The cubes are in the same order as in F.
  */
 static pcover reduce_gasp(pcover F, pcover D) {
-    pcube p, last, cunder, *FD;
+    pcube p, cunder, *FD;
     pcover G;
+    gasp_reduce_t red;
+    int i;
 
     G = new_cover(F->count);
     FD = cube2list(F, D);
 
-    /* Reduce cubes of F without replacement */
-    foreach_set(F, last, p) {
-        cunder = reduce_cube(FD, p);
+    /* Reduce cubes of F without replacement (the reductions only read FD) */
+    red.F = F;
+    red.FD = FD;
+    red.cunder = ALLOC(pcube, MAX(F->count, 1));
+    parallel_for(F->count, reduce_gasp_task, &red);
+
+    foreachi_set(F, i, p) {
+        cunder = red.cunder[i];
         if (setp_empty(cunder)) {
             fatal("empty reduction in reduce_gasp, shouldn't happen");
         } else if (setp_equal(cunder, p)) {
@@ -50,6 +112,7 @@ static pcover reduce_gasp(pcover F, pcover D) {
         free_cube(cunder);
     }
 
+    FREE(red.cunder);
     free_cubelist(FD);
     return G;
 }
@@ -63,13 +126,31 @@ static pcover reduce_gasp(pcover F, pcover D) {
  */
 
 pcover expand_gasp(pcover F, pcover D, pcover R, pcover Foriginal) {
-    int c1index;
+    int c1index, nslots = parallel_threads();
     pcover G;
+    gasp_expand_t exp;
 
     /* Try to expand each nonprime and noncovered cube */
     G = new_cover(10);
-    for (c1index = 0; c1index < F->count; c1index++) {
-        expand1_gasp(F, D, R, Foriginal, c1index, &G);
+    if (nslots == 1 || F->count < 2) {
+        for (c1index = 0; c1index < F->count; c1index++) {
+            expand1_gasp(F, D, R, Foriginal, c1index, &G);
+        }
+    } else {
+        exp.F = F;
+        exp.D = D;
+        exp.R = R;
+        exp.Foriginal = Foriginal;
+        exp.G = ALLOC(pcover, F->count);
+        exp.next = 0;
+        (void)pthread_mutex_init(&exp.lock, NULL);
+        parallel_for(MIN(nslots, F->count), expand_gasp_slot, &exp);
+        (void)pthread_mutex_destroy(&exp.lock);
+
+        /* the primes in the order the serial loop finds them */
+        for (c1index = 0; c1index < F->count; c1index++)
+            G = sf_append(G, exp.G[c1index]);
+        FREE(exp.G);
     }
     G = sf_dupl(G);
     G = expand(G, R, /*nonsparse*/ FALSE); /* Make them prime ! */
@@ -89,7 +170,11 @@ void expand1_gasp(
     int c2index;
     pcube p, last, c2under;
     pcube RAISE, FREESET, temp, *FD, c2essential;
-    pcover F1;
+    pcover F1, Rc = NULL;
+
+    /* without R, the reduced OFF-set of the cube (see offset.c) */
+    if (current_context->care != NULL)
+        R = Rc = reduced_offset(GETSET(F, c1index));
 
     RAISE = new_cube();
     FREESET = new_cube();
@@ -155,6 +240,8 @@ void expand1_gasp(
     free_cube(RAISE);
     free_cube(FREESET);
     free_cube(temp);
+    if (Rc != NULL)
+        free_cover(Rc);
 }
 
 /* irred_gasp -- Add new primes to F and find an irredundant subset */
@@ -177,3 +264,98 @@ pcover last_gasp(pcover F, pcover D, pcover R) {
     F = irred_gasp(F, D, G1);
     return F;
 }
+
+/*
+ *  cube_primes -- the primes which contain the cube p (or NULL if there
+ *  are more than SUPER_GASP_PRIMES candidates at some point)
+ *
+ *  These are the maximal cubes containing p which do not intersect R.
+ *  Starting from the full cube, each candidate which intersects a cube r
+ *  of R is replaced by the ways of lowering it to miss r, that is of
+ *  removing the parts of r from a variable in which p and r are
+ *  disjoint, and only the maximal candidates are kept.  The cubes of R
+ *  which leave a single way are taken first.
+ */
+static pcover cube_primes(pcube p, pcover R) {
+    pcover P, P1;
+    pcube r, last, c, clast, temp;
+    int *conflict, n, i, var, pass;
+
+    P = sf_addset(new_cover(16), cube.fullset);
+    conflict = ALLOC(int, cube.num_vars);
+    temp = new_cube();
+
+    for (pass = 0; pass < 2 && P != NULL; pass++) {
+        foreach_set(R, last, r) {
+            /* the variables in which p and r are disjoint */
+            (void)set_and(temp, p, r);
+            for (n = 0, var = 0; var < cube.num_vars; var++)
+                if (setp_disjoint(temp, cube.var_mask[var]))
+                    conflict[n++] = var;
+            if ((n == 1) != (pass == 0))
+                continue;
+
+            P1 = NULL;
+            foreach_set(P, clast, c) {
+                if (cdist0(c, r)) {
+                    if (P1 == NULL) {
+                        /* copy the candidates which have been passed */
+                        P1 = new_cover(P->count + n);
+                        for (i = 0; GETSET(P, i) != c; i++)
+                            P1 = sf_addset(P1, GETSET(P, i));
+                    }
+                    for (i = 0; i < n; i++) {
+                        (void)set_and(temp, r, cube.var_mask[conflict[i]]);
+                        P1 = sf_addset(P1, set_diff(temp, c, temp));
+                    }
+                } else if (P1 != NULL) {
+                    P1 = sf_addset(P1, c);
+                }
+            }
+            if (P1 != NULL) {
+                free_cover(P);
+                P = sf_contain(P1);
+                if (P->count > SUPER_GASP_PRIMES) {
+                    free_cover(P);
+                    P = NULL;
+                    break;
+                }
+            }
+        }
+    }
+
+    FREE(conflict);
+    free_cube(temp);
+    return P;
+}
+
+/* super_gasp */
+pcover super_gasp(pcover F, pcover D, pcover R) {
+    pcover G, G1, P, Rc;
+    pcube p, last, c, clast;
+
+    G = reduce_gasp(F, D);
+
+    /* All of the primes containing the cubes which reduced */
+    G1 = new_cover(F->count);
+    foreach_set(G, last, p) {
+        if (TESTP(p, PRIME))
+            continue;
+        if (current_context->care != NULL) {
+            Rc = reduced_offset(p);
+            P = cube_primes(p, Rc);
+            free_cover(Rc);
+        } else {
+            P = cube_primes(p, R);
+        }
+        if (P != NULL) {
+            foreach_set(P, clast, c) {
+                SET(c, PRIME);
+            }
+            G1 = sf_append(G1, P);
+        }
+    }
+    free_cover(G);
+
+    return irredundant(sf_dupl(sf_append(F, G1)), D);
+}
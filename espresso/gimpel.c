@@ -66,7 +66,9 @@ int gimpel_reduce(sm_matrix *A, solution_t *select, int *weight, int lb,
 
         stats->gimpel_count++;
         stats->gimpel++;
+        stats->offset++; /* for the column added below */
         *best = sm_mincov(A, select, weight, lb - 1, bound - 1, depth, stats);
+        stats->offset--;
         stats->gimpel--;
 
         if (*best != NIL(solution_t)) {
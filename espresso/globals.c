@@ -4,8 +4,36 @@
  *    Global Variable Declarations
  */
 
-struct cube_struct cube;
-struct cdata_struct cdata;
+/* the context used by a thread until it installs one of its own */
+context_t default_context = {.toggle = TRUE, .pla_type = TYPE_FD, .phase = -1};
+
+THREAD_LOCAL pcontext current_context = &default_context;
+
+/* output options */
+bool print_npterms = FALSE; /* write a .p line with the number of cubes */
+bool print_binary = FALSE;  /* write a binary cover file (cvrbin.c) */
+bool verify_result = FALSE; /* check the result (verify.c) */
+
+/* strategies of espresso() (see espresso.c) */
+bool single_expand = FALSE;
+bool remove_essential = TRUE;
+bool use_super_gasp = FALSE;
+bool skip_last_gasp = FALSE;
+bool recompute_onset = FALSE;
+bool unwrap_onset = TRUE;
+bool skip_make_sparse = FALSE;
+bool batch_expand = FALSE;
+bool exact_irredundant = FALSE;
+bool reduced_offsets = FALSE;
+bool decompose_function = FALSE;
+
+/* limits of espresso() (see espresso.c) */
+double time_limit = 0; /* seconds for a minimization (0: no limit) */
+int pass_limit = -1;   /* passes after the first expand (-1: no limit) */
+
+/* minimization from several starts (see portfolio.c) */
+int portfolio_starts = 1; /* number of starts */
+int portfolio_target = 0; /* cubes which stop the other starts (0: none) */
 
 int bit_count[256] = {
     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4,
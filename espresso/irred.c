@@ -1,6 +1,19 @@
 #include "espresso.h"
 
-static int Rp_current;
+/*
+ *  When covering the cube numbered "cur" of Rp, a cube of Rp still counts
+ *  as partially redundant only if it does not come before "cur" in Rp
+ */
+#define IS_REDUND(p, cur) (TESTP(p, REDUND) && (int)SIZE(p) >= (cur))
+
+/* Number of cubes of Rp covered in parallel before merging their rows */
+#define IRRED_TASK_BLOCK 64
+
+typedef struct {
+    pcube *list;       /* cube list of D, E and Rp */
+    pcube *cubes;      /* cubes of Rp in this block */
+    sm_matrix **rows;  /* the rows found for each of these cubes */
+} irred_block_t;
 
 /*
  *   irredundant -- Return a minimal subset of F
@@ -23,7 +36,7 @@ void mark_irredundant(pcover F, pcover D) {
     /* extract a minimum cover */
     irred_split_cover(F, D, &E, &Rt, &Rp);
     table = irred_derive_table(D, E, Rp);
-    cover = sm_minimum_cover(table, NIL(int), /* heuristic */ 1);
+    cover = sm_minimum_cover(table, NIL(int), !exact_irredundant);
 
     /* mark the cubes for the result */
     foreach_set(F, last, p) {
@@ -100,13 +113,13 @@ void irred_split_cover(pcover F, pcover D, pcover *E, pcover *Rt, pcover *Rp) {
 
 static bool ftaut_special_cases(
     pcube *T, /* will be disposed if answer is determined */
-    sm_matrix *table) {
+    sm_matrix *table, int Rp_current) {
     pcube *T1, *Tsave, p, temp = cube.temp[0], ceil = cube.temp[1];
     int var, rownum;
 
     /* Check for a row of all 1's in the essential cubes */
     for (T1 = T + 2; (p = *T1++) != 0;) {
-        if (!TESTP(p, REDUND)) {
+        if (!IS_REDUND(p, Rp_current)) {
             if (full_row(p, T[0])) {
                 /* subspace is covered by essentials -- no new rows for table */
                 free_cubelist(T);
@@ -125,7 +138,7 @@ start:
         rownum = table->last_row ? table->last_row->row_num + 1 : 0;
         (void)sm_insert(table, rownum, Rp_current);
         for (T1 = T + 2; (p = *T1++) != 0;) {
-            if (TESTP(p, REDUND)) {
+            if (IS_REDUND(p, Rp_current)) {
                 /* See if a redundant cube covers this leaf */
                 if (full_row(p, T[0])) {
                     (void)sm_insert(table, rownum, (int)SIZE(p));
@@ -162,38 +175,69 @@ start:
 
 /* ftautology -- find ways to make a tautology */
 static void ftautology(pcube *T, /* T will be disposed of */
-                       sm_matrix *table) {
+                       sm_matrix *table,
+                       int Rp_current /* index of the cube being covered */
+) {
     pcube cl, cr;
     int best;
 
-    if (ftaut_special_cases(T, table) == MAYBE) {
-        cl = new_cube();
-        cr = new_cube();
+    if (ftaut_special_cases(T, table, Rp_current) == MAYBE) {
+        cl = arena_cube();
+        cr = arena_cube();
         best = binate_split_select(T, cl, cr);
 
-        ftautology(scofactor(T, cl, best), table);
-        ftautology(scofactor(T, cr, best), table);
+        ftautology(scofactor(T, cl, best), table, Rp_current);
+        ftautology(scofactor(T, cr, best), table, Rp_current);
 
         free_cubelist(T);
-        free_cube(cl);
-        free_cube(cr);
+        arena_free(cl);
+        arena_free(cr);
     }
 }
 
 /* fcube_is_covered -- determine exactly how a cubelist "covers" a cube */
 static void fcube_is_covered(pcube *T, pcube c, sm_matrix *table) {
-    ftautology(cofactor(T, c), table);
+    ftautology(cofactor(T, c), table, SIZE(c));
+}
+
+static void irred_cover_task(void *arg, int i) {
+    irred_block_t *block = (irred_block_t *)arg;
+
+    block->rows[i] = sm_alloc();
+    fcube_is_covered(block->list, block->cubes[i], block->rows[i]);
+}
+
+/* irred_merge_rows -- append the rows of "rows" to the table (and free it) */
+static void irred_merge_rows(sm_matrix *table, sm_matrix *rows) {
+    sm_row *prow;
+    sm_element *pe;
+    int rownum;
+
+    sm_foreach_row(rows, prow) {
+        rownum = table->last_row ? table->last_row->row_num + 1 : 0;
+        sm_foreach_row_element(prow, pe) {
+            (void)sm_insert(table, rownum, pe->col_num);
+        }
+    }
+    sm_free(rows);
 }
 
 /*
  *  irred_derive_table -- given the covers D, E and the set of
  *  partially redundant primes Rp, build a covering table showing
  *  possible selections of primes to cover Rp.
+ *
+ *  The cubes of Rp must be numbered in increasing order (as done by
+ *  irred_split_cover).  With a thread pool, blocks of cubes of Rp are
+ *  covered concurrently into tables of their own, which are merged in
+ *  order, so that the table is the same as when built serially.
  */
 sm_matrix *irred_derive_table(pcover D, pcover E, pcover Rp) {
     pcube last, p, *list;
     sm_matrix *table;
-    int size_last_dominance, i;
+    irred_block_t block;
+    int size_last_dominance, i, j, n;
+    bool parallel;
 
     /* Mark each cube in DE as not part of the redundant set */
     foreach_set(D, last, p) {
@@ -211,12 +255,26 @@ sm_matrix *irred_derive_table(pcover D, pcover E, pcover Rp) {
     /* For each cube in Rp, find ways to cover its minterms */
     list = cube3list(D, E, Rp);
     table = sm_alloc();
+    parallel = parallel_threads() > 1 && Rp->count > 1;
+    if (parallel) {
+        block.list = list;
+        block.cubes = ALLOC(pcube, IRRED_TASK_BLOCK);
+        block.rows = ALLOC(sm_matrix *, IRRED_TASK_BLOCK);
+    }
     size_last_dominance = 0;
     i = 0;
     foreach_set(Rp, last, p) {
-        Rp_current = SIZE(p);
-        fcube_is_covered(list, p, table);
-        RESET(p, REDUND); /* can now consider this cube redundant */
+        if (!parallel) {
+            fcube_is_covered(list, p, table);
+        } else {
+            if (i % IRRED_TASK_BLOCK == 0) {
+                n = MIN(IRRED_TASK_BLOCK, Rp->count - i);
+                for (j = 0; j < n; j++)
+                    block.cubes[j] = GETSET(Rp, i + j);
+                parallel_for(n, irred_cover_task, &block);
+            }
+            irred_merge_rows(table, block.rows[i % IRRED_TASK_BLOCK]);
+        }
 
         /* try to keep memory limits down by reducing table as we go along */
         if (table->nrows - size_last_dominance > 1000) {
@@ -226,6 +284,15 @@ sm_matrix *irred_derive_table(pcover D, pcover E, pcover Rp) {
         i++;
     }
     free_cubelist(list);
+    if (parallel) {
+        FREE(block.cubes);
+        FREE(block.rows);
+    }
+
+    /* every cube can now be considered redundant */
+    foreach_set(Rp, last, p) {
+        RESET(p, REDUND);
+    }
 
     return table;
 }
@@ -240,17 +307,24 @@ bool tautology(pcube *T /* T will be disposed of */
 ) {
     pcube cl, cr;
     int best, result;
+    memo_key_t key;
 
+    RECUR_ENTER(RECUR_TAUT);
     if ((result = taut_special_cases(T)) == MAYBE) {
-        cl = new_cube();
-        cr = new_cube();
-        best = binate_split_select(T, cl, cr);
-        result = tautology(scofactor(T, cl, best)) &&
-                 tautology(scofactor(T, cr, best));
+        /* the list left by the special cases may have been answered before */
+        if ((result = memo_lookup(T, &key)) == MAYBE) {
+            cl = arena_cube();
+            cr = arena_cube();
+            best = binate_split_select(T, cl, cr);
+            result = tautology(scofactor(T, cl, best)) &&
+                     tautology(scofactor(T, cr, best));
+            arena_free(cl);
+            arena_free(cr);
+            memo_store(&key, result);
+        }
         free_cubelist(T);
-        free_cube(cl);
-        free_cube(cr);
     }
+    RECUR_LEAVE(RECUR_TAUT);
 
     return result;
 }
@@ -1,29 +1,288 @@
+#include <unistd.h>
 #include "espresso.h"
 
-int main() {
+/* the strategies of espresso() which can be chosen with -e */
+static struct {
+    char *name;
+    bool *flag;
+    bool value;
+} strategies[] = {
+    {"decomp", &decompose_function, TRUE}, /* independent parts apart */
+    {"exact", &exact_irredundant, TRUE},   /* minimum irredundant covers */
+    {"fast", &single_expand, TRUE},        /* one expand and irredundant */
+    {"ngasp", &skip_last_gasp, TRUE},      /* no last_gasp */
+    {"nsparse", &skip_make_sparse, TRUE},  /* no make_sparse */
+    {"ness", &remove_essential, FALSE},    /* keep the essential primes */
+    {"noffset", &reduced_offsets, TRUE},   /* reduced OFF-sets, no R */
+    {"nunwrap", &unwrap_onset, FALSE},     /* do not unwrap the outputs */
+    {"onset", &recompute_onset, TRUE},     /* recompute the ON-set */
+    {"pexpand", &batch_expand, TRUE},      /* expand batches in parallel */
+    {"strong", &use_super_gasp, TRUE},     /* super_gasp for last_gasp */
+    {NIL(char), NULL, FALSE},
+};
+
+static void usage(char *prog) {
+    fprintf(stderr, "usage: %s [options] [file]\n", prog);
+    fprintf(stderr, "       %s [options] -o dir [-m manifest] [file ...]\n",
+            prog);
+    fprintf(stderr, "       %s [options] -l socket|-\n", prog);
+    fprintf(stderr, "  -b        write a binary cover file\n");
+    fprintf(stderr, "  -c dir    keep complements and results in a cache\n");
+    fprintf(stderr, "  -e name   use a strategy: decomp, exact, fast,\n");
+    fprintf(stderr, "            ngasp, nsparse, ness, noffset, nunwrap,\n");
+    fprintf(stderr, "            onset, pexpand or strong\n");
+    fprintf(stderr, "  -g n      minimize the outputs in n separate groups\n");
+    fprintf(stderr, "  -j n      use n worker threads\n");
+    fprintf(stderr, "  -k n[,c]  best of n starts (stop at c cubes)\n");
+    fprintf(stderr, "  -l sock   serve requests on a socket (- for stdin)\n");
+    fprintf(stderr, "  -m file   read the input file names from a manifest\n");
+    fprintf(stderr, "  -n n      stop after n passes of improvement\n");
+    fprintf(stderr, "  -o dir    batch mode: write each result into dir\n");
+    fprintf(stderr, "  -p        write a .p line giving the number of cubes\n");
+    fprintf(stderr, "  -P file   write a profile of the run to file (JSON)\n");
+    fprintf(stderr, "  -s file   start from the cover of an earlier run\n");
+    fprintf(stderr, "  -t sec    stop improving the cover after sec seconds\n");
+    fprintf(stderr, "  -v        verify that the result covers the function\n");
+    exit(2);
+}
+
+/* write_profile -- write the profile (if one was asked for) to "file" */
+static void write_profile(char *prog, char *file) {
+    FILE *fp;
+
+    if (file == NIL(char))
+        return;
+    if ((fp = fopen(file, "w")) == NULL) {
+        fprintf(stderr, "%s: unable to write %s\n", prog, file);
+        return;
+    }
+    profile_write(fp);
+    (void)fclose(fp);
+}
+
+int main(int argc, char **argv) {
     pPLA PLA;
+    pcover F0;
+    bool solved, verified;
+    FILE *fp;
+    char **files, *outdir, *profile, *start, *server, mode[64];
+    int c, i, n, nfiles, nthreads, ngroups;
+    cache_key_t key;
+
+    alloc_profile_setup(); /* before anything is allocated */
+    files = NIL(char *);
+    nfiles = 0;
+    outdir = NIL(char);
+    profile = NIL(char);
+    start = NIL(char);
+    server = NIL(char);
+    nthreads = 1;
+    ngroups = 1;
+    while ((c = getopt(argc, argv, "bc:e:g:j:k:l:m:n:o:pP:s:t:v")) != EOF) {
+        switch (c) {
+            case 'b':
+                print_binary = TRUE;
+                break;
+            case 'c':
+                if (!cache_open(optarg)) {
+                    fprintf(stderr, "%s: unable to use cache %s\n", argv[0],
+                            optarg);
+                    exit(1);
+                }
+                break;
+            case 'e':
+                for (n = 0; strategies[n].name != NIL(char); n++)
+                    if (equal(optarg, strategies[n].name))
+                        break;
+                if (strategies[n].name == NIL(char))
+                    usage(argv[0]);
+                *strategies[n].flag = strategies[n].value;
+                break;
+            case 'g':
+                if ((ngroups = atoi(optarg)) <= 0)
+                    usage(argv[0]);
+                break;
+            case 'j':
+                if ((nthreads = atoi(optarg)) <= 0)
+                    usage(argv[0]);
+                break;
+            case 'k':
+                if (sscanf(optarg, "%d,%d", &portfolio_starts,
+                           &portfolio_target) < 1 ||
+                    portfolio_starts <= 0 || portfolio_target < 0)
+                    usage(argv[0]);
+                break;
+            case 'l':
+                server = optarg;
+                break;
+            case 'm':
+                if (!batch_read_manifest(optarg, &files, &nfiles)) {
+                    fprintf(stderr, "%s: unable to read manifest %s\n",
+                            argv[0], optarg);
+                    exit(1);
+                }
+                break;
+            case 'n':
+                if ((pass_limit = atoi(optarg)) < 0)
+                    usage(argv[0]);
+                break;
+            case 'o':
+                outdir = optarg;
+                break;
+            case 'p':
+                print_npterms = TRUE;
+                break;
+            case 'P':
+                profile = optarg;
+                profile_open();
+                break;
+            case 's':
+                start = optarg;
+                break;
+            case 't':
+                if ((time_limit = atof(optarg)) <= 0)
+                    usage(argv[0]);
+                break;
+            case 'v':
+                verify_result = TRUE;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    /* a binary cover file holds R, which is not computed then */
+    if (print_binary && reduced_offsets) {
+        fprintf(stderr, "%s: -b cannot be used with -e noffset\n", argv[0]);
+        exit(2);
+    }
+    if (ngroups > 1 && decompose_function) {
+        fprintf(stderr, "%s: -g cannot be used with -e decomp\n", argv[0]);
+        exit(2);
+    }
+    if (start != NIL(char) && outdir != NIL(char)) {
+        fprintf(stderr, "%s: -s cannot be used with -o\n", argv[0]);
+        exit(2);
+    }
+
+    /* the answers of the server are PLAs read from a stream */
+    if (server != NIL(char) &&
+        (outdir != NIL(char) || start != NIL(char) || print_binary ||
+         ngroups > 1 || nfiles > 0 || optind < argc)) {
+        fprintf(stderr, "%s: -l takes no input files, nor -b, -g, -o or -s\n",
+                argv[0]);
+        exit(2);
+    }
 
     /* the remaining arguments are argv[optind ... argc-1] */
+    for (i = optind; i < argc; i++) {
+        files = REALLOC(char *, files, nfiles + 1);
+        files[nfiles++] = strcpy(ALLOC(char, strlen(argv[i]) + 1), argv[i]);
+    }
+
+    /* Server mode: each request is minimized and answered in turn */
+    if (server != NIL(char)) {
+        c = server_run(server, nthreads);
+        cache_report(stderr);
+        memo_report(stderr);
+        reduced_offset_report(stderr);
+        write_profile(argv[0], profile);
+        exit(c);
+    }
+
+    /* Batch mode: each file is minimized into a file of its own */
+    if (outdir != NIL(char)) {
+        c = batch_minimize(files, nfiles, outdir, nthreads, stdout);
+        cache_report(stderr);
+        memo_report(stderr);
+        reduced_offset_report(stderr);
+        write_profile(argv[0], profile);
+        for (i = 0; i < nfiles; i++)
+            FREE(files[i]);
+        FREE(files);
+        exit(c == 0 ? 0 : 1);
+    }
+    if (nfiles > 1) {
+        fprintf(stderr, "%s: more than one input file requires -o\n",
+                argv[0]);
+        exit(2);
+    }
+
+    fp = stdin;
+    if (nfiles == 1 && (fp = fopen(files[0], "r")) == NULL) {
+        fprintf(stderr, "%s: unable to open %s\n", argv[0], files[0]);
+        exit(1);
+    }
+    parallel_setup(nthreads);
     PLA = NIL(PLA_t);
-    if (read_pla(stdin, &PLA) == EOF) {
-        fprintf(stderr, "Unable to find PLA on stdin\n");
+    if (read_pla(fp, &PLA) == EOF) {
+        fprintf(stderr, "Unable to find PLA on %s\n",
+                nfiles == 1 ? files[0] : "stdin");
         exit(1);
     }
+    if (fp != stdin)
+        (void)fclose(fp);
+    if (start != NIL(char)) {
+        if ((fp = fopen(start, "r")) == NULL) {
+            fprintf(stderr, "%s: unable to open %s\n", argv[0], start);
+            exit(1);
+        }
+        current_context->start = read_start(fp);
+        (void)fclose(fp);
+    }
 
     /*
-     *  Now run espresso
+     *  Now run espresso (unless the result is in the cache; the result of a
+     *  warm start depends on the cover it started from, so it is not kept)
      */
-    PLA->F = espresso(PLA->F, PLA->D, PLA->R);
+    (void)sprintf(mode, "groups %d passes %d strategy %d starts %d", ngroups,
+                  pass_limit, espresso_strategy(), portfolio_starts);
+    cache_key(&key, CACHE_RESULT, PLA, mode);
+    F0 = verify_result ? sf_save(PLA->F) : (pcover)NULL;
+    solved = current_context->start != NULL || !cache_get(&key, PLA);
+    if (solved) {
+        if (ngroups > 1)
+            PLA->F = espresso_partitioned(PLA->F, PLA->D, PLA->R, ngroups);
+        else if (decompose_function)
+            PLA->F = espresso_decomposed(PLA->F, PLA->D, PLA->R);
+        else
+            PLA->F = espresso_portfolio(PLA->F, PLA->D, PLA->R);
+        if (current_context->truncated)
+            fprintf(stderr, "# minimization stopped at a limit\n");
+    }
+
+    /* the result is neither cached nor written out unless it is verified */
+    verified = F0 == (pcover)NULL || espresso_verify(PLA->F, F0, PLA->D);
+    if (verified && solved && !current_context->truncated &&
+        current_context->start == NULL)
+        cache_put(&key, PLA);
+    cache_report(stderr);
+    memo_report(stderr);
+    reduced_offset_report(stderr);
+    write_profile(argv[0], profile);
+    if (!verified)
+        exit(1);
+    if (F0 != (pcover)NULL)
+        free_cover(F0);
 
     /* Output the solution */
-    fprint_pla(stdout, PLA);
+    if (print_binary)
+        fprint_binary_pla(stdout, PLA);
+    else
+        fprint_pla(stdout, PLA);
 
     /* cleanup all used memory */
+    parallel_setdown();
+    if (current_context->start != NULL)
+        free_cover(current_context->start);
     free_PLA(PLA);
     FREE(cube.part_size);
     setdown_cube(); /* free the cube/cdata structure data */
     sf_cleanup();   /* free unused set structures */
     sm_cleanup();   /* sparse matrix cleanup */
+    for (i = 0; i < nfiles; i++)
+        FREE(files[i]);
+    FREE(files);
 
     exit(0);
 }
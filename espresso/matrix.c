@@ -1,17 +1,103 @@
+#include <pthread.h>
+
 #include "port.h"
 #include "sparse_int.h"
 
 /*
- *  free-lists are only used if 'FAST_AND_LOOSE' is set; this is because
- *  we lose the debugging capability of libmm_t which trashes objects when
- *  they are free'd.  However, FAST_AND_LOOSE is much faster if matrices
- *  are created and freed frequently.
+ *  The elements, rows and columns are carved out of chunks of storage,
+ *  and a node which is freed goes on the free lists of the thread freeing
+ *  it (sm_pool), those of a whole matrix or row at once.  Nodes move from
+ *  the thread which allocates them to the one which frees them, so the
+ *  chunks are shared by all of the threads: sm_cleanup() hands the free
+ *  lists of a thread over to the shared ones, and the chunks are released
+ *  once every node carved out of them is back there.
+ *
+ *  With NO_SM_POOL defined, each node is allocated and freed on its own
+ *  (a matrix is then freed node by node), and sm_cleanup() does nothing.
  */
 
-#ifdef FAST_AND_LOOSE
-sm_element *sm_element_freelist;
-sm_row *sm_row_freelist;
-sm_col *sm_col_freelist;
+#ifndef NO_SM_POOL
+#define SM_CHUNK 32768 /* bytes carved into nodes at once */
+
+THREAD_LOCAL sm_pool_t sm_pool;
+
+static struct {
+    pthread_mutex_t lock;
+    sm_pool_t free; /* handed over by sm_cleanup() */
+    long nelements; /* carved out of the chunks */
+    long nrows;
+    long ncols;
+    char **chunks;
+    int nchunks, chunks_size;
+} sm_shared = {PTHREAD_MUTEX_INITIALIZER};
+
+/* sm_chunk -- a new chunk, for "n" nodes of "size" bytes */
+static char *sm_chunk(size_t size, long *n) {
+    if (sm_shared.nchunks == sm_shared.chunks_size) {
+        sm_shared.chunks_size = MAX(2 * sm_shared.chunks_size, 16);
+        sm_shared.chunks =
+            REALLOC(char *, sm_shared.chunks, sm_shared.chunks_size);
+    }
+    *n = SM_CHUNK / size;
+    return sm_shared.chunks[sm_shared.nchunks++] = ALLOC(char, SM_CHUNK);
+}
+
+/*
+ *  sm_pool_refill -- give the (empty) free list of a kind of node of the
+ *  thread the shared nodes, carving a new chunk when there are none
+ */
+void sm_pool_refill(int kind) {
+    sm_element *e;
+    sm_row *prow;
+    sm_col *pcol;
+    long i, n;
+
+    pthread_mutex_lock(&sm_shared.lock);
+    if (kind == SM_ELEMENTS) {
+        if (sm_shared.free.elements == NIL(sm_element)) {
+            e = (sm_element *)sm_chunk(sizeof(sm_element), &n);
+            for (i = 0; i < n - 1; i++)
+                e[i].next_col = &e[i + 1];
+            e[n - 1].next_col = NIL(sm_element);
+            sm_shared.free.elements = e;
+            sm_shared.free.nelements = n;
+            sm_shared.nelements += n;
+        }
+        sm_pool.elements = sm_shared.free.elements;
+        sm_pool.nelements = sm_shared.free.nelements;
+        sm_shared.free.elements = NIL(sm_element);
+        sm_shared.free.nelements = 0;
+    } else if (kind == SM_ROWS) {
+        if (sm_shared.free.rows == NIL(sm_row)) {
+            prow = (sm_row *)sm_chunk(sizeof(sm_row), &n);
+            for (i = 0; i < n - 1; i++)
+                prow[i].next_row = &prow[i + 1];
+            prow[n - 1].next_row = NIL(sm_row);
+            sm_shared.free.rows = prow;
+            sm_shared.free.nrows = n;
+            sm_shared.nrows += n;
+        }
+        sm_pool.rows = sm_shared.free.rows;
+        sm_pool.nrows = sm_shared.free.nrows;
+        sm_shared.free.rows = NIL(sm_row);
+        sm_shared.free.nrows = 0;
+    } else {
+        if (sm_shared.free.cols == NIL(sm_col)) {
+            pcol = (sm_col *)sm_chunk(sizeof(sm_col), &n);
+            for (i = 0; i < n - 1; i++)
+                pcol[i].next_col = &pcol[i + 1];
+            pcol[n - 1].next_col = NIL(sm_col);
+            sm_shared.free.cols = pcol;
+            sm_shared.free.ncols = n;
+            sm_shared.ncols += n;
+        }
+        sm_pool.cols = sm_shared.free.cols;
+        sm_pool.ncols = sm_shared.free.ncols;
+        sm_shared.free.cols = NIL(sm_col);
+        sm_shared.free.ncols = 0;
+    }
+    pthread_mutex_unlock(&sm_shared.lock);
+}
 #endif
 
 sm_matrix *sm_alloc() {
@@ -29,25 +115,7 @@ sm_matrix *sm_alloc() {
 }
 
 void sm_free(sm_matrix *A) {
-#ifdef FAST_AND_LOOSE
-    sm_row *prow;
-
-    if (A->first_row != 0) {
-        for (prow = A->first_row; prow != 0; prow = prow->next_row) {
-            /* add the elements to the free list of elements */
-            prow->last_col->next_col = sm_element_freelist;
-            sm_element_freelist = prow->first_col;
-        }
-
-        /* Add the linked list of rows to the row-free-list */
-        A->last_row->next_row = sm_row_freelist;
-        sm_row_freelist = A->first_row;
-
-        /* Add the linked list of cols to the col-free-list */
-        A->last_col->next_col = sm_col_freelist;
-        sm_col_freelist = A->first_col;
-    }
-#else
+#ifdef NO_SM_POOL
     sm_row *prow, *pnext_row;
     sm_col *pcol, *pnext_col;
 
@@ -60,6 +128,29 @@ void sm_free(sm_matrix *A) {
         pcol->first_row = pcol->last_row = NIL(sm_element);
         sm_col_free(pcol);
     }
+#else
+    sm_row *prow;
+
+    /* the elements of each row go to the free list at once */
+    for (prow = A->first_row; prow != 0; prow = prow->next_row) {
+        if (prow->first_col != NIL(sm_element)) {
+            prow->last_col->next_col = sm_pool.elements;
+            sm_pool.elements = prow->first_col;
+            sm_pool.nelements += prow->length;
+        }
+    }
+
+    /* and so do the rows and the columns */
+    if (A->first_row != NIL(sm_row)) {
+        A->last_row->next_row = sm_pool.rows;
+        sm_pool.rows = A->first_row;
+        sm_pool.nrows += A->nrows;
+    }
+    if (A->first_col != NIL(sm_col)) {
+        A->last_col->next_col = sm_pool.cols;
+        sm_pool.cols = A->first_col;
+        sm_pool.ncols += A->ncols;
+    }
 #endif
 
     /* Free the arrays to map row/col numbers into pointers */
@@ -215,28 +306,58 @@ void sm_delcol(sm_matrix *A, int i) {
     }
 }
 
+/*
+ *  sm_cleanup -- hand the free lists of the thread over to the shared
+ *  ones, releasing the chunks if no node is in use any more
+ */
 void sm_cleanup() {
-#ifdef FAST_AND_LOOSE
-    sm_element *p, *pnext;
-    sm_row *prow, *pnextrow;
-    sm_col *pcol, *pnextcol;
-
-    for (p = sm_element_freelist; p != 0; p = pnext) {
-        pnext = p->next_col;
-        FREE(p);
+#ifndef NO_SM_POOL
+    sm_element *e;
+    sm_row *prow;
+    sm_col *pcol;
+    int i;
+
+    pthread_mutex_lock(&sm_shared.lock);
+    if ((e = sm_pool.elements) != NIL(sm_element)) {
+        while (e->next_col != NIL(sm_element))
+            e = e->next_col;
+        e->next_col = sm_shared.free.elements;
+        sm_shared.free.elements = sm_pool.elements;
+        sm_shared.free.nelements += sm_pool.nelements;
     }
-    sm_element_freelist = 0;
-
-    for (prow = sm_row_freelist; prow != 0; prow = pnextrow) {
-        pnextrow = prow->next_row;
-        FREE(prow);
+    if ((prow = sm_pool.rows) != NIL(sm_row)) {
+        while (prow->next_row != NIL(sm_row))
+            prow = prow->next_row;
+        prow->next_row = sm_shared.free.rows;
+        sm_shared.free.rows = sm_pool.rows;
+        sm_shared.free.nrows += sm_pool.nrows;
     }
-    sm_row_freelist = 0;
-
-    for (pcol = sm_col_freelist; pcol != 0; pcol = pnextcol) {
-        pnextcol = pcol->next_col;
-        FREE(pcol);
+    if ((pcol = sm_pool.cols) != NIL(sm_col)) {
+        while (pcol->next_col != NIL(sm_col))
+            pcol = pcol->next_col;
+        pcol->next_col = sm_shared.free.cols;
+        sm_shared.free.cols = sm_pool.cols;
+        sm_shared.free.ncols += sm_pool.ncols;
+    }
+    sm_pool.elements = NIL(sm_element);
+    sm_pool.rows = NIL(sm_row);
+    sm_pool.cols = NIL(sm_col);
+    sm_pool.nelements = sm_pool.nrows = sm_pool.ncols = 0;
+
+    if (sm_shared.free.nelements == sm_shared.nelements &&
+        sm_shared.free.nrows == sm_shared.nrows &&
+        sm_shared.free.ncols == sm_shared.ncols) {
+        for (i = 0; i < sm_shared.nchunks; i++)
+            FREE(sm_shared.chunks[i]);
+        FREE(sm_shared.chunks);
+        sm_shared.nchunks = sm_shared.chunks_size = 0;
+        sm_shared.free.elements = NIL(sm_element);
+        sm_shared.free.rows = NIL(sm_row);
+        sm_shared.free.cols = NIL(sm_col);
+        sm_shared.free.nelements = sm_shared.nelements = 0;
+        sm_shared.free.nrows = sm_shared.nrows = 0;
+        sm_shared.free.ncols = sm_shared.ncols = 0;
     }
-    sm_col_freelist = 0;
+    pthread_mutex_unlock(&sm_shared.lock);
 #endif
 }
@@ -0,0 +1,226 @@
+/*
+    module: memo.c
+    purpose: a memo of the answers of tautology()
+
+    The tautology of a cofactor list depends only on its cubes, each taken
+    together with the cofactor cube T[0].  The same lists come up again
+    and again: the cubes of Rp share most of their cofactors, and
+    essential() and irredundant() look at the same regions of the cover
+    on every pass of espresso().  With ESPRESSO_MEMO set to a number of
+    megabytes, tautology() keeps the answers for lists of at least
+    MEMO_MIN_CUBES cubes in a hash table, keyed by those cubes, and
+    answers a list it has seen before without recursing.
+
+    Keys hold the cubes themselves, not pointers to them, so that answers
+    remain good when the covers they came from are freed.  A memo belongs
+    to the context owning the cube geometry, is shared (under a lock) by
+    the contexts of its tasks, and is cleared when the geometry goes away.
+    When its entries would take more than the bound, it starts afresh.
+*/
+
+#include <pthread.h>
+
+#include "espresso.h"
+
+#define MEMO_MIN_CUBES 16    /* smaller lists are quicker to solve again */
+#define MEMO_BUCKETS   1024 /* initial size of the hash table */
+
+typedef struct memo_entry_struct {
+    struct memo_entry_struct *next; /* next entry of the bucket */
+    unsigned long long hash;
+    int n;                          /* cubes of the key */
+    bool result;
+    set_word_t cubes[1];            /* n cubes of LOOP(T[0]) words */
+} memo_entry_t;
+
+struct memo_struct {
+    memo_entry_t **bucket;
+    int nbuckets;                   /* a power of 2 */
+    int entries;
+    long long bytes;                /* taken by the entries */
+};
+
+static long long memo_limit; /* bytes (0 if there is no memo) */
+static pthread_once_t memo_once = PTHREAD_ONCE_INIT;
+static struct {
+    long long lookups, hits, stores, flushes;
+} memo_stats;
+static pthread_mutex_t memo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* memo_setup -- read the bound of ESPRESSO_MEMO */
+static void memo_setup() {
+    char *env = getenv("ESPRESSO_MEMO");
+
+    memo_limit = env != NULL && atoi(env) > 0 ? atoi(env) * 1048576LL : 0;
+}
+
+/* memo_of -- the memo of the context owning the geometry (created here) */
+static memo_t *memo_of(pcontext ctx) {
+    memo_t *memo;
+
+    while (ctx->parent != NULL)
+        ctx = ctx->parent;
+    if ((memo = ctx->memo) == NIL(memo_t)) {
+        memo = ctx->memo = ALLOC(memo_t, 1);
+        memo->nbuckets = MEMO_BUCKETS;
+        memo->bucket = ALLOC(memo_entry_t *, memo->nbuckets);
+        memset(memo->bucket, 0, memo->nbuckets * sizeof(memo_entry_t *));
+        memo->entries = 0;
+        memo->bytes = 0;
+    }
+    return memo;
+}
+
+/* memo_empty -- release the entries of a memo */
+static void memo_empty(memo_t *memo) {
+    memo_entry_t *e, *next;
+    int i;
+
+    for (i = 0; i < memo->nbuckets; i++) {
+        for (e = memo->bucket[i]; e != NIL(memo_entry_t); e = next) {
+            next = e->next;
+            FREE(e);
+        }
+        memo->bucket[i] = NIL(memo_entry_t);
+    }
+    memo->entries = 0;
+    memo->bytes = 0;
+}
+
+/* memo_grow -- double the buckets of a memo */
+static void memo_grow(memo_t *memo) {
+    memo_entry_t **old = memo->bucket, *e, *next;
+    int i, n = memo->nbuckets;
+
+    memo->nbuckets = 2 * n;
+    memo->bucket = ALLOC(memo_entry_t *, memo->nbuckets);
+    memset(memo->bucket, 0, memo->nbuckets * sizeof(memo_entry_t *));
+    for (i = 0; i < n; i++)
+        for (e = old[i]; e != NIL(memo_entry_t); e = next) {
+            next = e->next;
+            e->next = memo->bucket[e->hash & (memo->nbuckets - 1)];
+            memo->bucket[e->hash & (memo->nbuckets - 1)] = e;
+        }
+    FREE(old);
+}
+
+/*
+    memo_lookup -- the memorized answer for the list T (TRUE or FALSE),
+    or MAYBE; in that case, "key" is to be given to memo_store() with the
+    answer once it is known (it is left empty if T is not worth keeping).
+*/
+int memo_lookup(pcube *T, memo_key_t *key) {
+    pcube *T1, p, c = T[0];
+    set_word_t *q;
+    unsigned long long h;
+    memo_t *memo;
+    memo_entry_t *e;
+    int i, words = LOOP(T[0]), result = MAYBE;
+
+    key->cubes = NIL(set_word_t);
+    key->n = CUBELISTSIZE(T);
+    if (key->n < MEMO_MIN_CUBES)
+        return MAYBE;
+    (void)pthread_once(&memo_once, memo_setup);
+    if (memo_limit == 0)
+        return MAYBE;
+
+    /* the cubes of the list within the cofactor, and their hash */
+    q = key->cubes = (set_word_t *)arena_alloc(
+        (size_t)key->n * words * sizeof(set_word_t));
+    h = 0xcbf29ce484222325ULL ^ (unsigned long long)key->n;
+    for (T1 = T + 2; (p = *T1++) != NULL;)
+        for (i = 1; i <= words; i++) {
+            *q = p[i] | c[i];
+            h = (h ^ *q++) * 0x100000001b3ULL;
+        }
+    key->hash = h ^ (h >> 31);
+
+    (void)pthread_mutex_lock(&memo_lock);
+    memo_stats.lookups++;
+    memo = memo_of(current_context);
+    for (e = memo->bucket[key->hash & (memo->nbuckets - 1)];
+         e != NIL(memo_entry_t); e = e->next)
+        if (e->hash == key->hash && e->n == key->n &&
+            memcmp(e->cubes, key->cubes,
+                   (size_t)key->n * words * sizeof(set_word_t)) == 0) {
+            memo_stats.hits++;
+            result = e->result;
+            break;
+        }
+    (void)pthread_mutex_unlock(&memo_lock);
+
+    if (result != MAYBE) {
+        arena_free(key->cubes);
+        key->cubes = NIL(set_word_t);
+    }
+    return result;
+}
+
+/* memo_store -- keep the answer for the list of "key" */
+void memo_store(memo_key_t *key, bool result) {
+    memo_t *memo;
+    memo_entry_t *e;
+    size_t size;
+
+    if (key->cubes == NIL(set_word_t))
+        return;
+    size = sizeof(memo_entry_t) +
+           (size_t)key->n * LOOP(cube.fullset) * sizeof(set_word_t);
+    if ((long long)size <= memo_limit / 16) {
+        e = (memo_entry_t *)ALLOC(char, size);
+        e->hash = key->hash;
+        e->n = key->n;
+        e->result = result;
+        memcpy(e->cubes, key->cubes,
+               (size_t)key->n * LOOP(cube.fullset) * sizeof(set_word_t));
+
+        (void)pthread_mutex_lock(&memo_lock);
+        memo = memo_of(current_context);
+        if (memo->bytes + (long long)size > memo_limit) {
+            memo_empty(memo);
+            memo_stats.flushes++;
+        }
+        if (memo->entries >= 2 * memo->nbuckets)
+            memo_grow(memo);
+        e->next = memo->bucket[e->hash & (memo->nbuckets - 1)];
+        memo->bucket[e->hash & (memo->nbuckets - 1)] = e;
+        memo->entries++;
+        memo->bytes += size;
+        memo_stats.stores++;
+        (void)pthread_mutex_unlock(&memo_lock);
+    }
+    arena_free(key->cubes);
+    key->cubes = NIL(set_word_t);
+}
+
+/* memo_free -- release the memo of a context (if it has one) */
+void memo_free(pcontext ctx) {
+    if (ctx->memo != NIL(memo_t)) {
+        memo_empty(ctx->memo);
+        FREE(ctx->memo->bucket);
+        FREE(ctx->memo);
+        ctx->memo = NIL(memo_t);
+    }
+}
+
+/* memo_counts -- the lookups, hits, stores and flushes so far */
+void memo_counts(long long counts[4]) {
+    (void)pthread_mutex_lock(&memo_lock);
+    counts[0] = memo_stats.lookups;
+    counts[1] = memo_stats.hits;
+    counts[2] = memo_stats.stores;
+    counts[3] = memo_stats.flushes;
+    (void)pthread_mutex_unlock(&memo_lock);
+}
+
+/* memo_report -- print the lookups and hits on "fp" (if there is a memo) */
+void memo_report(FILE *fp) {
+    long long counts[4];
+
+    memo_counts(counts);
+    if (counts[0] > 0)
+        fprintf(fp, "# memo: %lld lookups %lld hits %lld stores %lld "
+                    "flushes\n",
+                counts[0], counts[1], counts[2], counts[3]);
+}
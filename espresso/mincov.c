@@ -1,13 +1,36 @@
+#include <pthread.h>
+
 #include "mincov_int.h"
+#include "espresso.h"
 
 /*
  *  mincov.c
+ *
+ *  The exact covering (heuristic == 0) keeps the cost of the best cover
+ *  found so far in a search_t shared by all of its branches, and prunes
+ *  the nodes which cannot reach it; with a thread pool, both branches of
+ *  the nodes near the root, and both blocks of a partition, are searched
+ *  as tasks.  A branch prefers the cover of the column it selects on a
+ *  tie, as the serial search does, so that the cover found does not
+ *  depend on the order in which the tasks finish.
+ *
+ *  The search stops when it has visited a number of nodes, or after a
+ *  number of seconds, given by ESPRESSO_EXACT ("nodes" or
+ *  "nodes,seconds"; by default MINCOV_NODE_LIMIT nodes); the heuristic
+ *  cover is then returned.
  */
 
 #define USE_GIMPEL
 #define USE_INDEP_SET
 
+#define MINCOV_NODE_LIMIT 100000 /* nodes of an exact covering by default */
+#define MINCOV_FORK_DEPTH 12     /* tasks are spawned down to this depth */
+#define MINCOV_FORK_ROWS  16     /* for subproblems of at least these rows */
+
 static int select_column();
+static long long exact_nodes;
+static double exact_seconds;
+static pthread_once_t exact_once = PTHREAD_ONCE_INIT;
 
 #define fail(why)                                                              \
     {                                                                          \
@@ -28,14 +51,41 @@ static int verify_cover(sm_matrix *A, sm_row *cover) {
     return 1;
 }
 
+/* exact_setup -- read the limits of ESPRESSO_EXACT */
+static void exact_setup() {
+    char *env = getenv("ESPRESSO_EXACT");
+
+    exact_nodes = MINCOV_NODE_LIMIT;
+    exact_seconds = 0;
+    if (env != NIL(char) &&
+        sscanf(env, "%lld,%lf", &exact_nodes, &exact_seconds) < 1)
+        exact_nodes = MINCOV_NODE_LIMIT;
+}
+
+/* solve -- the best cover of A (on packed bit matrices if A is dense) */
+static solution_t *solve(sm_matrix *A, int *weight, int nelem, int bound,
+                         stats_t *stats) {
+    solution_t *best, *select;
+    sm_matrix *dup_A;
+
+    if (sm_dense_wanted(A, nelem))
+        return sm_dense_mincov(A, weight, bound, stats);
+    select = solution_alloc();
+    dup_A = sm_dup(A);
+    best = sm_mincov(dup_A, select, weight, 0, bound, 0, stats);
+    sm_free(dup_A);
+    solution_free(select);
+    return best;
+}
+
 sm_row *sm_minimum_cover(sm_matrix *A, int *weight,
                          int heuristic /* set to 1 for a heuristic covering */
 ) {
     stats_t stats;
-    solution_t *best, *select;
+    search_t search;
+    solution_t *best;
     sm_row *prow, *sol;
     sm_col *pcol;
-    sm_matrix *dup_A;
     int nelem, bound;
 
     /* Avoid sillyness */
@@ -49,6 +99,8 @@ sm_row *sm_minimum_cover(sm_matrix *A, int *weight,
     stats.component = stats.comp_count = 0;
     stats.gimpel = stats.gimpel_count = 0;
     stats.no_branching = heuristic != 0;
+    stats.search = NIL(search_t);
+    stats.offset = 0;
 
     /* Check the matrix sparsity */
     nelem = 0;
@@ -62,12 +114,28 @@ sm_row *sm_minimum_cover(sm_matrix *A, int *weight,
         bound += WEIGHT(weight, pcol->col_num);
     }
 
-    /* Perform the covering */
-    select = solution_alloc();
-    dup_A = sm_dup(A);
-    best = sm_mincov(dup_A, select, weight, 0, bound, 0, &stats);
-    sm_free(dup_A);
-    solution_free(select);
+    /* Perform the covering (within the limits, if it is exact) */
+    if (!heuristic) {
+        (void)pthread_once(&exact_once, exact_setup);
+        search.best = bound - 1; /* all of the columns */
+        search.stop = 0;
+        search.nodes = 0;
+        search.node_limit = exact_nodes;
+        search.deadline = exact_seconds > 0 ? wall_time() + exact_seconds : 0;
+        stats.search = &search;
+    }
+    best = solve(A, weight, nelem, bound, &stats);
+    if (stats.search != NIL(search_t) && search.stop) {
+        /* a limit was reached: fall back to the heuristic cover */
+        if (best != NIL(solution_t))
+            solution_free(best);
+        stats.no_branching = 1;
+        stats.search = NIL(search_t);
+        best = solve(A, weight, nelem, bound, &stats);
+    }
+
+    profile_mincov(stats.nodes, stats.max_depth, stats.comp_count,
+                   stats.gimpel_count);
 
     sol = sm_row_dup(best->row);
     if (!verify_cover(A, sol)) {
@@ -159,6 +227,199 @@ static int select_column(sm_matrix *A, int *weight, solution_t *indep) {
     return best_col;
 }
 
+/* mincov_enter -- count a node of the search; 0 if a limit is reached */
+int mincov_enter(stats_t *stats, int depth) {
+    search_t *search = stats->search;
+    long long nodes;
+
+    stats->nodes++;
+    if (depth > stats->max_depth)
+        stats->max_depth = depth;
+    if (search == NIL(search_t))
+        return 1;
+    if (__atomic_load_n(&search->stop, __ATOMIC_RELAXED))
+        return 0;
+    nodes = __atomic_add_fetch(&search->nodes, 1, __ATOMIC_RELAXED);
+    if ((search->node_limit > 0 && nodes > search->node_limit) ||
+        (search->deadline > 0 && nodes % 64 == 0 &&
+         wall_time() > search->deadline)) {
+        __atomic_store_n(&search->stop, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ *  mincov_bound -- "bound" tightened by the best cover of the search: a
+ *  subproblem which cannot reach its cost (ties included) is pruned
+ */
+int mincov_bound(stats_t *stats, int bound) {
+    int best;
+
+    if (stats->search == NIL(search_t))
+        return bound;
+    best = __atomic_load_n(&stats->search->best, __ATOMIC_RELAXED);
+    return MIN(bound, best + 1 - stats->offset);
+}
+
+/* mincov_found -- tell the search about a cover (unless within a block) */
+void mincov_found(stats_t *stats, solution_t *sol) {
+    int best, cost = stats->offset + sol->cost;
+
+    if (stats->search == NIL(search_t) || stats->component > 0)
+        return;
+    best = __atomic_load_n(&stats->search->best, __ATOMIC_RELAXED);
+    while (cost < best &&
+           !__atomic_compare_exchange_n(&stats->search->best, &best, cost, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/* mincov_parallel -- should the subproblems of a node be tasks ? */
+int mincov_parallel(stats_t *stats, int depth, int nrows) {
+    return stats->search != NIL(search_t) && !stats->no_branching &&
+           depth < MINCOV_FORK_DEPTH && nrows >= MINCOV_FORK_ROWS &&
+           parallel_threads() > 1;
+}
+
+/* a subproblem solved as a task; its bound may be tightened meanwhile */
+typedef struct {
+    mincov_solver_t solve;
+    void *A;
+    solution_t *select;
+    int *weight;
+    int lb, bound, depth;
+    stats_t stats; /* of the task, added to the parent's when it is done */
+    solution_t *best;
+} mincov_task_t;
+
+static void mincov_task_init(mincov_task_t *task, stats_t *stats,
+                             mincov_solver_t solve, void *A,
+                             solution_t *select, int *weight, int lb,
+                             int bound, int depth) {
+    task->solve = solve;
+    task->A = A;
+    task->select = select;
+    task->weight = weight;
+    task->lb = lb;
+    task->bound = bound;
+    task->depth = depth;
+    task->stats = *stats;
+    task->stats.nodes = 0;
+    task->stats.max_depth = -1;
+    task->stats.comp_count = 0;
+    task->stats.gimpel_count = 0;
+    task->best = NIL(solution_t);
+}
+
+static void mincov_task(void *arg) {
+    mincov_task_t *task = (mincov_task_t *)arg;
+    int bound = __atomic_load_n(&task->bound, __ATOMIC_RELAXED);
+
+    task->best = (*task->solve)(task->A, task->select, task->weight, task->lb,
+                                bound, task->depth, &task->stats);
+}
+
+/*
+ *  mincov_pair -- solve the first subproblem while the second one waits
+ *  as a task (for another thread to take), and add up their statistics.
+ *  If nobody took it, the second subproblem is solved within "bound2"
+ *  of the first one's cover, just as the serial search would.
+ */
+static void mincov_pair(mincov_task_t *tasks, int (*bound2)(mincov_task_t *),
+                        stats_t *stats) {
+    task_group_t group = {0};
+    int i, bound;
+
+    task_spawn(&group, mincov_task, &tasks[1]);
+    mincov_task(&tasks[0]);
+    bound = MIN(tasks[1].bound, (*bound2)(tasks));
+    __atomic_store_n(&tasks[1].bound, bound, __ATOMIC_RELAXED);
+    task_wait(&group);
+
+    for (i = 0; i < 2; i++) {
+        stats->nodes += tasks[i].stats.nodes;
+        stats->max_depth = MAX(stats->max_depth, tasks[i].stats.max_depth);
+        stats->comp_count += tasks[i].stats.comp_count;
+        stats->gimpel_count += tasks[i].stats.gimpel_count;
+    }
+}
+
+/* the second branch has to beat the cover of the first one */
+static int branch_bound(mincov_task_t *tasks) {
+    return tasks[0].best != NIL(solution_t) ? tasks[0].best->cost : INT_MAX;
+}
+
+/* the second block has to fit in what the first one leaves of the bound */
+static int block_bound(mincov_task_t *tasks) {
+    return tasks[0].best != NIL(solution_t)
+               ? tasks[0].bound - tasks[0].best->cost
+               : 0;
+}
+
+/*
+ *  mincov_branches -- the better of the covers of the two branches of a
+ *  node (that of the first one on a tie), the second one as a task
+ */
+solution_t *mincov_branches(mincov_solver_t solve, void *A1,
+                            solution_t *select1, void *A2,
+                            solution_t *select2, int *weight, int lb,
+                            int bound, int depth, stats_t *stats) {
+    mincov_task_t tasks[2];
+
+    mincov_task_init(&tasks[0], stats, solve, A1, select1, weight, lb, bound,
+                     depth);
+    mincov_task_init(&tasks[1], stats, solve, A2, select2, weight, lb, bound,
+                     depth);
+    mincov_pair(tasks, branch_bound, stats);
+    return solution_choose_best(tasks[0].best, tasks[1].best);
+}
+
+/*
+ *  mincov_blocks -- cover the blocks L and R of a partition, R as a task,
+ *  and add their covers to 'select' (NULL if the result does not beat
+ *  bound)
+ */
+solution_t *mincov_blocks(mincov_solver_t solve, void *L, void *R,
+                          solution_t *select, int *weight, int bound,
+                          int depth, stats_t *stats) {
+    mincov_task_t tasks[2];
+    solution_t *best;
+    sm_element *p;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        mincov_task_init(&tasks[i], stats, solve, i == 0 ? L : R,
+                         solution_alloc(), weight, 0, bound - select->cost,
+                         depth);
+        tasks[i].stats.component++;
+        tasks[i].stats.offset += select->cost;
+    }
+    mincov_pair(tasks, block_bound, stats);
+
+    best = NIL(solution_t);
+    if (tasks[0].best != NIL(solution_t) && tasks[1].best != NIL(solution_t)) {
+        for (i = 0; i < 2; i++)
+            for (p = tasks[i].best->row->first_col; p != 0; p = p->next_col)
+                solution_add(select, weight, p->col_num);
+        if (select->cost < bound) {
+            best = solution_dup(select);
+            mincov_found(stats, best);
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        if (tasks[i].best != NIL(solution_t))
+            solution_free(tasks[i].best);
+        solution_free(tasks[i].select);
+    }
+    return best;
+}
+
+static solution_t *sm_solve(void *A, solution_t *select, int *weight, int lb,
+                            int bound, int depth, stats_t *stats) {
+    return sm_mincov((sm_matrix *)A, select, weight, lb, bound, depth, stats);
+}
+
 /*
  *  Find the best cover for 'A' (given that 'select' already selected);
  *
@@ -174,10 +435,11 @@ solution_t *sm_mincov(sm_matrix *A, solution_t *select, int *weight, int lb,
     solution_t *select1, *select2, *best, *best1, *best2, *indep;
     int pick, lb_new;
 
-    /* Start out with some debugging information */
-    stats->nodes++;
-    if (depth > stats->max_depth)
-        stats->max_depth = depth;
+    /* Start out with some debugging information (and check the limits) */
+    if (!mincov_enter(stats, depth)) {
+        return NIL(solution_t);
+    }
+    bound = mincov_bound(stats, bound);
 
     /* Apply row dominance, column dominance, and select essentials */
     select_essential(A, select, weight, bound);
@@ -214,6 +476,7 @@ solution_t *sm_mincov(sm_matrix *A, solution_t *select, int *weight, int lb,
         /* Check for new best solution */
     } else if (A->nrows == 0) {
         best = solution_dup(select);
+        mincov_found(stats, best);
 
         /* Check for a partition of the problem */
     } else if (sm_block_partition(A, &L, &R)) {
@@ -225,11 +488,22 @@ solution_t *sm_mincov(sm_matrix *A, solution_t *select, int *weight, int lb,
         }
         stats->comp_count++;
 
+        /* Solve the problems for L and R at the same time ? */
+        if (mincov_parallel(stats, depth, A->nrows)) {
+            best = mincov_blocks(sm_solve, L, R, select, weight, bound,
+                                 depth + 1, stats);
+            sm_free(L);
+            sm_free(R);
+            return best;
+        }
+
         /* Solve problem for L */
         select1 = solution_alloc();
         stats->component++;
+        stats->offset += select->cost;
         best1 = sm_mincov(L, select1, weight, 0, bound - select->cost,
                           depth + 1, stats);
+        stats->offset -= select->cost;
         stats->component--;
         solution_free(select1);
         sm_free(L);
@@ -255,6 +529,21 @@ solution_t *sm_mincov(sm_matrix *A, solution_t *select, int *weight, int lb,
         A1 = sm_dup(A);
         select1 = solution_dup(select);
         solution_accept(select1, A1, weight, pick);
+
+        /* ... and, at the same time, that we cannot have it ? */
+        if (mincov_parallel(stats, depth, A->nrows)) {
+            A2 = sm_dup(A);
+            select2 = solution_dup(select);
+            solution_reject(select2, A2, weight, pick);
+            best = mincov_branches(sm_solve, A1, select1, A2, select2, weight,
+                                   lb_new, bound, depth + 1, stats);
+            solution_free(select1);
+            sm_free(A1);
+            solution_free(select2);
+            sm_free(A2);
+            return best;
+        }
+
         best1 = sm_mincov(A1, select1, weight, lb_new, bound, depth + 1, stats);
         solution_free(select1);
         sm_free(A1);
@@ -1 +1,4 @@
 sm_row *sm_minimum_cover(sm_matrix *A, int *weight, int heuristic);
+
+/* profile.c -- told about the search of each call */
+void profile_mincov(int nodes, int max_depth, int components, int gimpel);
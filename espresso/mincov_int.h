@@ -2,6 +2,16 @@
 #include "sparse.h"
 #include "mincov.h"
 
+/* the state shared by the tasks of an exact covering (see mincov.c) */
+typedef struct search_struct search_t;
+struct search_struct {
+    int best;             /* cost of the best complete cover found */
+    int stop;             /* a limit has been reached */
+    long long nodes;      /* nodes visited by all of the tasks */
+    long long node_limit; /* 0: no limit */
+    double deadline;      /* wall time (0: no limit) */
+};
+
 typedef struct stats_struct stats_t;
 struct stats_struct {
     int max_depth;    /* deepest the recursion has gone */
@@ -11,6 +21,8 @@ struct stats_struct {
     int gimpel_count; /* number of times Gimpel reduction applied */
     int gimpel;       /* currently inside Gimpel reduction */
     int no_branching;
+    search_t *search; /* of an exact covering (or NULL) */
+    int offset;       /* cost of the cover outside the current subproblem */
 };
 
 typedef struct solution_struct solution_t;
@@ -19,10 +31,26 @@ struct solution_struct {
     int cost;
 };
 
+/* a solver of a subproblem of an exact covering (see mincov_branches) */
+typedef solution_t *(*mincov_solver_t)(void *A, solution_t *select,
+                                       int *weight, int lb, int bound,
+                                       int depth, stats_t *stats);
+
 /* mincov.c */
 sm_row *sm_minimum_cover(sm_matrix *A, int *weight, int heuristic);
 solution_t *sm_mincov(sm_matrix *A, solution_t *select, int *weight, int lb,
                       int bound, int depth, stats_t *stats);
+int mincov_enter(stats_t *stats, int depth);
+int mincov_bound(stats_t *stats, int bound);
+void mincov_found(stats_t *stats, solution_t *sol);
+int mincov_parallel(stats_t *stats, int depth, int nrows);
+solution_t *mincov_branches(mincov_solver_t solve, void *A1,
+                            solution_t *select1, void *A2,
+                            solution_t *select2, int *weight, int lb,
+                            int bound, int depth, stats_t *stats);
+solution_t *mincov_blocks(mincov_solver_t solve, void *L, void *R,
+                          solution_t *select, int *weight, int bound,
+                          int depth, stats_t *stats);
 /* solution.c */
 solution_t *solution_alloc();
 void solution_free(solution_t *sol);
@@ -35,6 +63,11 @@ solution_t *solution_choose_best(solution_t *best1, solution_t *best2);
 /* indep.c */
 solution_t *sm_maximal_independent_set(sm_matrix *A, int *weight);
 
+/* dense.c */
+int sm_dense_wanted(sm_matrix *A, int nelem);
+solution_t *sm_dense_mincov(sm_matrix *A, int *weight, int bound,
+                            stats_t *stats);
+
 /* gimpel.c */
 int gimpel_reduce(sm_matrix *A, solution_t *select, int *weight, int lb,
                   int bound, int depth, stats_t *stats, solution_t **best);
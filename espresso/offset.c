@@ -0,0 +1,190 @@
+/*
+    module: offset.c
+    purpose: reduced OFF-sets, for minimizing without the OFF-set
+
+    For some functions the OFF-set is far larger than F and D, and computing
+    it takes more time or memory than the minimization itself.  With
+    reduced_offsets, read_pla() leaves R empty for a .type fd PLA, and the
+    expansions of a cube c are checked against a reduced OFF-set instead,
+    computed from F u D (the care set of the context) when c is expanded
+    and released afterwards.
+
+    Any implicant containing c lies within the region U of the parts j for
+    which c raised in j alone (c + j) is an implicant.  The reduced OFF-set
+    is the part of R within U (the complement of the cofactor of F u D by
+    U), and, for each part j which cannot be raised, one cube of R within
+    c + j (outside c), found by halving that region while some half of it
+    is not covered.  These are cubes of R, and a cube containing c meets
+    one of them exactly when it meets R.  The cubes of F u D which can
+    meet a region c + j are those meeting c, and those disjoint from c in
+    the variable of j only, so they are set apart first.
+*/
+
+#include <pthread.h>
+
+#include "espresso.h"
+
+static struct {
+    long long calls; /* reduced OFF-sets computed */
+    int max_cubes;   /* the largest of them */
+    long long max_bytes;
+} offset_stats;
+static pthread_mutex_t offset_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+    reduced_offset_begin -- with reduced_offsets, take a copy of F u D as
+    the care set of the reduced OFF-sets of the context; the care set it
+    replaces is to be given back to reduced_offset_end()
+*/
+pcover reduced_offset_begin(pcover F, pcover D) {
+    pcover save = current_context->care;
+
+    if (reduced_offsets)
+        current_context->care = sf_join(F, D);
+    return save;
+}
+
+/* reduced_offset_end -- release the care set, restoring "save" */
+void reduced_offset_end(pcover save) {
+    if (current_context->care != save)
+        free_cover(current_context->care);
+    current_context->care = save;
+}
+
+/*
+    offset_cube -- a cube of R within the region q, left in w; FALSE if
+    T (the care set) covers q
+*/
+static bool offset_cube(pcube *T, pcube q, pcube w) {
+    pcube *Tw, *T1, left = new_cube(), right = new_cube();
+    bool found;
+
+    /* if q is not covered, keep a half of w which is not (split as the
+       recursions do), until no cube of the care set meets w */
+    (void)set_copy(w, q);
+    Tw = cofactor(T, w);
+    found = !tautology(cofactor(Tw, w));
+    while (found && Tw[2] != NULL) {
+        massive_count(Tw);
+        (void)binate_split_select(Tw, left, right);
+        (void)set_and(left, left, w);
+        (void)set_and(right, right, w);
+        (void)set_copy(w, tautology(cofactor(Tw, left)) ? right : left);
+        T1 = cofactor(Tw, w);
+        free_cubelist(Tw);
+        Tw = T1;
+    }
+    free_cubelist(Tw);
+    free_cube(left);
+    free_cube(right);
+    return found;
+}
+
+/* offset_within -- append to R the cubes of X (disposed of) within c */
+static pcover offset_within(pcover R, pcover X, pcube c) {
+    pcube x, last;
+
+    foreach_set(X, last, x) {
+        if (cdist0(x, c))
+            R = sf_addset(R, set_and(x, x, c));
+    }
+    free_cover(X);
+    return R;
+}
+
+/* reduced_offset -- the reduced OFF-set of the cube c (see above) */
+pcover reduced_offset(pcube c) {
+    pcube *T, *T1, *pnear, *near, p, last, region, cj, w;
+    pcover R;
+    int var, j, k, n0, n1, nbound, *dvar, *bound;
+
+    /* the cubes of the care set meeting c, then those at distance 1 from
+       it (with the variable in which they are disjoint from c) */
+    T = cube1list(current_context->care);
+    near = ALLOC(pcube, current_context->care->count + 1);
+    dvar = ALLOC(int, current_context->care->count + 1);
+    bound = ALLOC(int, cube.num_vars);
+    for (nbound = var = 0; var < cube.num_vars; var++)
+        if (!setp_implies(cube.var_mask[var], c))
+            bound[nbound++] = var;
+    n0 = n1 = 0;
+    w = new_cube();
+    foreach_set(current_context->care, last, p) {
+        if ((k = cdist01(p, c)) == 0) {
+            near[n0++] = p;
+        } else if (k == 1) {
+            n1++;
+            (void)set_and(w, p, c);
+            for (k = 0; !setp_disjoint(w, cube.var_mask[bound[k]]); k++)
+                ;
+            near[current_context->care->count - n1] = p;
+            dvar[current_context->care->count - n1] = bound[k];
+        }
+    }
+
+    /* the parts which can be raised alone, and R within the others */
+    R = new_cover(16);
+    region = set_copy(new_cube(), c);
+    cj = new_cube();
+    for (var = 0; var < cube.num_vars; var++) {
+        T1 = NULL;
+        for (j = cube.first_part[var]; j <= cube.last_part[var]; j++)
+            if (!is_in_set(c, j)) {
+                /* the cubes which can meet c + j (once for the variable) */
+                if (T1 == NULL) {
+                    pnear = T1 = new_cubelist(n0 + n1 + 3);
+                    pnear += 2;
+                    for (k = 0; k < n0; k++)
+                        *pnear++ = near[k];
+                    for (k = current_context->care->count - n1;
+                         k < current_context->care->count; k++)
+                        if (dvar[k] == var)
+                            *pnear++ = near[k];
+                    *pnear++ = NULL;
+                    T1[1] = (pcube)pnear;
+                }
+
+                /* c + j is covered if its part outside c is */
+                (void)set_diff(cj, c, cube.var_mask[var]);
+                set_insert(cj, j);
+                if (offset_cube(T1, cj, w))
+                    R = sf_addset(R, w);
+                else
+                    set_insert(region, j);
+            }
+        if (T1 != NULL)
+            free_cubelist(T1);
+    }
+    FREE(near);
+    FREE(dvar);
+    FREE(bound);
+
+    /* R within the region */
+    if (!setp_equal(region, c))
+        R = offset_within(R, complement(cofactor(T, region)), region);
+    free_cubelist(T);
+    free_cube(region);
+    free_cube(cj);
+    free_cube(w);
+    R = sf_contain(R);
+
+    (void)pthread_mutex_lock(&offset_lock);
+    offset_stats.calls++;
+    if (R->count > offset_stats.max_cubes) {
+        offset_stats.max_cubes = R->count;
+        offset_stats.max_bytes =
+            (long long)R->count * R->wsize * sizeof(set_word_t);
+    }
+    (void)pthread_mutex_unlock(&offset_lock);
+    return R;
+}
+
+/* reduced_offset_report -- print the sizes of the reduced OFF-sets on "fp" */
+void reduced_offset_report(FILE *fp) {
+    (void)pthread_mutex_lock(&offset_lock);
+    if (offset_stats.calls > 0)
+        fprintf(fp, "# reduced OFF-sets: %lld, at most %d cubes (%lld KB)\n",
+                offset_stats.calls, offset_stats.max_cubes,
+                (offset_stats.max_bytes + 1023) / 1024);
+    (void)pthread_mutex_unlock(&offset_lock);
+}
@@ -0,0 +1,138 @@
+/*
+    module: opart.c
+    purpose: output-partitioned minimization
+
+    The outputs are split into groups of consecutive outputs, and the
+    function restricted to each group is minimized on its own (and
+    concurrently, when there is a thread pool).  For a group, the slice
+    of F, D or R is made of the cubes which assert an output of the
+    group, with their other outputs cleared; a cube asserting every
+    output outside of the group is added to the OFF-set, so that no cube
+    can be expanded into the other groups.
+
+    A product term shared by outputs of different groups ends up in each
+    of the groups, so the union of the results is then merged: cubes
+    with the same input part are joined, the union is expanded against
+    the complete OFF-set (which recovers the sharing of the remaining
+    terms), and is made irredundant and sparse once.  The final cover is
+    never larger than the union of the group results.
+*/
+
+#include "espresso.h"
+
+typedef struct {
+    pcover F, D, R;          /* slices (F is replaced by the result) */
+    bool toggle;             /* of the caller's context, for each group */
+    bool unwrap_flipped;
+    unsigned long long seed;
+    bool truncated;          /* the minimization stopped at a limit */
+} opart_group_t;
+
+/* opart_slice -- the cubes of A asserting some output in "group" */
+static pcover opart_slice(pcover A, pset group, pset keep) {
+    pcover B;
+    pset last, p, q;
+
+    B = new_cover(A->count);
+    foreach_set(A, last, p) {
+        if (!setp_disjoint(p, group)) {
+            q = GETSET(B, B->count++);
+            (void)set_and(set_clear(q, cube.size), p, keep);
+        }
+    }
+    return B;
+}
+
+/*
+    opart_minimize -- minimize a group, from the state of the caller's
+    context whether the task runs inline (and after other groups) or not
+*/
+static void opart_minimize(void *arg) {
+    opart_group_t *g = (opart_group_t *)arg;
+    pcontext ctx = current_context; /* maybe the caller's, without a pool */
+    bool toggle = ctx->toggle, unwrap_flipped = ctx->unwrap_flipped;
+    unsigned long long seed = ctx->seed;
+
+    ctx->toggle = g->toggle;
+    ctx->unwrap_flipped = g->unwrap_flipped;
+    ctx->seed = g->seed;
+    g->truncated = FALSE;
+    if (g->F->count > 0) {
+        g->F = espresso(g->F, g->D, g->R);
+        g->truncated = ctx->truncated;
+    }
+    ctx->toggle = toggle;
+    ctx->unwrap_flipped = unwrap_flipped;
+    ctx->seed = seed;
+}
+
+/*
+    espresso_partitioned -- minimize F with its outputs split into
+    "ngroups" groups; the cube counts before and after the merge are
+    reported on stderr
+*/
+pcover espresso_partitioned(pcover F, pcover D, pcover R, int ngroups) {
+    opart_group_t *groups;
+    task_group_t tasks = {0};
+    pset group, keep, last, p;
+    pcover Fnew, care;
+    int g, i, out, nout, before;
+
+    out = cube.output;
+    nout = out < 0 ? 0 : cube.part_size[out];
+    ngroups = MIN(ngroups, nout);
+    if (ngroups < 2)
+        return espresso(F, D, R);
+
+    group = new_cube();
+    keep = new_cube();
+    groups = ALLOC(opart_group_t, ngroups);
+    for (g = 0; g < ngroups; g++) {
+        (void)set_clear(group, cube.size);
+        for (i = g * nout / ngroups; i < (g + 1) * nout / ngroups; i++)
+            set_insert(group, cube.first_part[out] + i);
+        set_or(keep, set_diff(keep, cube.fullset, cube.var_mask[out]), group);
+
+        groups[g].F = opart_slice(F, group, keep);
+        groups[g].D = opart_slice(D, group, keep);
+        groups[g].R = opart_slice(R, group, keep);
+        groups[g].R = sf_addset(groups[g].R,
+                                set_diff(keep, cube.fullset, group));
+        groups[g].toggle = current_context->toggle;
+        groups[g].unwrap_flipped = current_context->unwrap_flipped;
+        groups[g].seed = current_context->seed;
+    }
+    free_cube(group);
+    free_cube(keep);
+
+    for (g = 0; g < ngroups; g++)
+        task_spawn(&tasks, opart_minimize, &groups[g]);
+    task_wait(&tasks);
+
+    Fnew = new_cover(F->count);
+    current_context->truncated = FALSE;
+    for (g = 0; g < ngroups; g++) {
+        current_context->truncated |= groups[g].truncated;
+        Fnew = sf_append(Fnew, groups[g].F);
+        free_cover(groups[g].D);
+        free_cover(groups[g].R);
+    }
+    FREE(groups);
+    free_cover(F);
+    before = Fnew->count;
+
+    /* Recover the product terms shared between the groups */
+    F = d1merge(Fnew, out);
+    foreach_set(F, last, p) {
+        RESET(p, PRIME);
+    }
+    care = reduced_offset_begin(F, D);
+    F = expand(F, R, FALSE);
+    F = irredundant(F, D);
+    F = make_sparse(F, D, R);
+    reduced_offset_end(care);
+
+    fprintf(stderr, "# output partition: %d groups, %d cubes, %d after merge\n",
+            ngroups, before, F->count);
+    return F;
+}
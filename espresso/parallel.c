@@ -0,0 +1,245 @@
+/*
+    module: parallel.c
+    purpose: a small fork-join task pool
+
+    The pool has a deque of tasks for each of its threads.  A thread
+    pushes the tasks it spawns onto the bottom of its own deque and takes
+    work from the bottom as well; a thread which runs out of work steals
+    from the top of the other deques.  A thread waiting for a task group
+    keeps running tasks while it waits, so nested task groups cannot
+    deadlock.
+
+    Each task runs in a context shared from the context which spawned it,
+    so it sees the same cube geometry but has private temporary cubes and
+    cdata.  The pool belongs to the thread which called parallel_setup();
+    any other thread (and every thread when the pool has only a single
+    thread) runs the tasks it spawns immediately, in its own context.
+*/
+
+#include <pthread.h>
+#include "espresso.h"
+
+typedef struct task_struct {
+    void (*func)(void *); /* what to run */
+    void *arg;            /* its argument */
+    pcontext owner;       /* context of the spawning thread */
+    task_group_t *group;  /* group to notify when done */
+} task_t;
+
+typedef struct {
+    task_t *tasks; /* tasks[first] ... tasks[last-1] are queued */
+    int first, last, size;
+} deque_t;
+
+static struct {
+    int nthreads;          /* number of threads (including the owner) */
+    pthread_t *threads;    /* the worker threads */
+    deque_t *deques;       /* one per thread */
+    int queued;            /* total number of queued tasks */
+    bool shutdown;         /* tells the workers to exit */
+    pthread_mutex_t lock;  /* protects everything above and the groups */
+    pthread_cond_t change; /* a task was queued or a group finished */
+} pool = {1};
+
+/* index of the calling thread in the pool, or -1 if not a pool thread */
+static THREAD_LOCAL int pool_index = -1;
+
+/* task_take -- find a task for thread "me" (with the pool locked) */
+static bool task_take(int me, task_t *task) {
+    deque_t *dq = &pool.deques[me];
+    int i;
+
+    if (dq->first < dq->last) {
+        *task = dq->tasks[--dq->last];
+    } else {
+        for (i = 1; i < pool.nthreads; i++) {
+            dq = &pool.deques[(me + i) % pool.nthreads];
+            if (dq->first < dq->last)
+                break;
+        }
+        if (i == pool.nthreads)
+            return FALSE;
+        *task = dq->tasks[dq->first++];
+    }
+    if (dq->first == dq->last)
+        dq->first = dq->last = 0;
+    pool.queued--;
+    return TRUE;
+}
+
+/* task_run -- run a task (with the pool unlocked) */
+static void task_run(task_t *task) {
+    pcontext ctx, save;
+
+    ctx = context_share(task->owner);
+    save = context_set(ctx);
+    (*task->func)(task->arg);
+    (void)context_set(save);
+    context_free(ctx);
+
+    pthread_mutex_lock(&pool.lock);
+    if (--task->group->pending == 0)
+        pthread_cond_broadcast(&pool.change);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void *pool_worker(void *arg) {
+    task_t task;
+
+    pool_index = (int)(long)arg;
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.shutdown) {
+        if (task_take(pool_index, &task)) {
+            pthread_mutex_unlock(&pool.lock);
+            task_run(&task);
+            pthread_mutex_lock(&pool.lock);
+        } else {
+            pthread_cond_wait(&pool.change, &pool.lock);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    sm_cleanup(); /* the free nodes of the thread go to the others */
+    return NULL;
+}
+
+/* parallel_setup -- start a pool of "nthreads" threads owned by the caller */
+void parallel_setup(int nthreads) {
+    int i;
+
+    pool.nthreads = MAX(nthreads, 1);
+    pool.queued = 0;
+    pool.shutdown = FALSE;
+    pool.deques = ALLOC(deque_t, pool.nthreads);
+    for (i = 0; i < pool.nthreads; i++) {
+        pool.deques[i].tasks = NIL(task_t);
+        pool.deques[i].first = pool.deques[i].last = pool.deques[i].size = 0;
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.change, NULL);
+
+    pool_index = 0;
+    pool.threads = ALLOC(pthread_t, pool.nthreads);
+    for (i = 1; i < pool.nthreads; i++)
+        if (pthread_create(&pool.threads[i], NULL, pool_worker,
+                           (void *)(long)i))
+            fatal("parallel_setup: cannot create worker thread");
+}
+
+/* parallel_setdown -- stop the pool (which must be idle) */
+void parallel_setdown() {
+    int i;
+
+    if (pool_index != 0)
+        return;
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = TRUE;
+    pthread_cond_broadcast(&pool.change);
+    pthread_mutex_unlock(&pool.lock);
+    for (i = 1; i < pool.nthreads; i++)
+        pthread_join(pool.threads[i], NULL);
+    for (i = 0; i < pool.nthreads; i++)
+        FREE(pool.deques[i].tasks);
+    FREE(pool.deques);
+    FREE(pool.threads);
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.change);
+    pool.nthreads = 1;
+    pool_index = -1;
+}
+
+/* parallel_threads -- number of threads which can run tasks for the caller */
+int parallel_threads() {
+    return pool_index >= 0 ? pool.nthreads : 1;
+}
+
+/* task_spawn -- run func(arg) as part of "group" (maybe concurrently) */
+void task_spawn(task_group_t *group, void (*func)(void *), void *arg) {
+    deque_t *dq;
+
+    if (parallel_threads() == 1) {
+        (*func)(arg);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    dq = &pool.deques[pool_index];
+    if (dq->last == dq->size) {
+        dq->size = dq->size * 2 + 16;
+        dq->tasks = REALLOC(task_t, dq->tasks, dq->size);
+    }
+    dq->tasks[dq->last].func = func;
+    dq->tasks[dq->last].arg = arg;
+    dq->tasks[dq->last].owner = current_context;
+    dq->tasks[dq->last].group = group;
+    dq->last++;
+    pool.queued++;
+    group->pending++;
+    pthread_cond_broadcast(&pool.change);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* task_wait -- wait for every task of "group", helping out meanwhile */
+void task_wait(task_group_t *group) {
+    task_t task;
+
+    if (parallel_threads() == 1)
+        return;
+
+    pthread_mutex_lock(&pool.lock);
+    while (group->pending > 0) {
+        if (task_take(pool_index, &task)) {
+            pthread_mutex_unlock(&pool.lock);
+            task_run(&task);
+            pthread_mutex_lock(&pool.lock);
+        } else {
+            pthread_cond_wait(&pool.change, &pool.lock);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+typedef struct {
+    void (*func)(void *, int);
+    void *arg;
+    int first, last; /* range of indices for this chunk */
+} chunk_t;
+
+static void run_chunk(void *arg) {
+    chunk_t *chunk = (chunk_t *)arg;
+    int i;
+
+    for (i = chunk->first; i < chunk->last; i++)
+        (*chunk->func)(chunk->arg, i);
+}
+
+/*
+    parallel_for -- call func(arg, i) for 0 <= i < n; the calls may run
+    concurrently and in any order, so func must only write into storage
+    of its own for each i
+*/
+void parallel_for(int n, void (*func)(void *, int), void *arg) {
+    task_group_t group = {0};
+    chunk_t *chunks;
+    int i, nchunks, size;
+
+    if (parallel_threads() == 1 || n < 2) {
+        for (i = 0; i < n; i++)
+            (*func)(arg, i);
+        return;
+    }
+
+    /* a few chunks per thread to even out the load */
+    nchunks = MIN(n, parallel_threads() * 4);
+    size = (n + nchunks - 1) / nchunks;
+    nchunks = (n + size - 1) / size;
+    chunks = ALLOC(chunk_t, nchunks);
+    for (i = 0; i < nchunks; i++) {
+        chunks[i].func = func;
+        chunks[i].arg = arg;
+        chunks[i].first = i * size;
+        chunks[i].last = MIN(n, (i + 1) * size);
+        task_spawn(&group, run_chunk, &chunks[i]);
+    }
+    task_wait(&group);
+    FREE(chunks);
+}
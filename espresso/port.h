@@ -10,18 +10,41 @@
 #include <string.h>
 #include <assert.h>
 #include <limits.h>
+#include <setjmp.h>
 
-#define NIL(type)        ((type *)0)
-#define ALLOC(type, num) ((type *)malloc(sizeof(type) * (num)))
-#define REALLOC(type, obj, num)                                    \
-    (obj) ? ((type *)realloc((char *)(obj), sizeof(type) * (num))) \
-          : ((type *)malloc(sizeof(type) * (num)))
-#define FREE(obj)                  \
-    if ((obj)) {                   \
-        (void)free((char *)(obj)); \
-        (obj) = 0;                 \
+/* with ESPRESSO_ALLOC_PROFILE, the storage goes through alloc.c */
+extern int alloc_profiling;
+void *alloc_malloc(size_t size, const char *file, int line);
+void *alloc_realloc(void *obj, size_t size, const char *file, int line);
+void alloc_free(void *obj);
+
+#define NIL(type) ((type *)0)
+#define ALLOC(type, num)                                                   \
+    ((type *)(alloc_profiling                                              \
+                  ? alloc_malloc(sizeof(type) * (num), __FILE__, __LINE__) \
+                  : malloc(sizeof(type) * (num))))
+#define REALLOC(type, obj, num)                                            \
+    ((type *)(alloc_profiling                                              \
+                  ? alloc_realloc((char *)(obj), sizeof(type) * (num),     \
+                                  __FILE__, __LINE__)                      \
+              : (obj) ? realloc((char *)(obj), sizeof(type) * (num))       \
+                      : malloc(sizeof(type) * (num))))
+#define FREE(obj)                      \
+    if ((obj)) {                       \
+        if (alloc_profiling)           \
+            alloc_free((char *)(obj)); \
+        else                           \
+            (void)free((char *)(obj)); \
+        (obj) = 0;                     \
     }
 
+/* Storage class for per-thread state */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 #ifndef MAX
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif /* MAX */
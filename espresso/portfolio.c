@@ -0,0 +1,108 @@
+/*
+    module: portfolio.c
+    purpose: minimization from several starts, keeping the best result
+
+    The cover espresso() finds depends on the order in which the cubes
+    are taken: reduce() alternates between two orderings (starting with
+    the one given by the toggle of the context), the cubes of the same
+    weight are ordered by their contents, and the outputs may be unwrapped
+    or not.  With portfolio_starts > 1, the function is
+    minimized once per start (concurrently, when there is a thread pool),
+    each start changing these choices, and the cheapest cover is kept:
+
+        start 0         as espresso() alone
+        bit 0 of k      start reduce() with the other ordering
+        bit 1 of k      unwrap the outputs unless unwrap_onset (and v.v.)
+        k >> 2          seed of the order of the cubes which the
+                        orderings leave tied (0: by their contents)
+
+    The result does not depend on the number of threads (ties between
+    starts go to the lowest one).  With portfolio_target > 0, a start
+    reaching that many cubes stops the others at their next pass; since
+    which ones have stopped then depends on the timing, the result is
+    reported as truncated.
+*/
+
+#include "espresso.h"
+
+typedef struct {
+    int k;            /* number of the start */
+    pcover F, D, R;   /* private copies (F is replaced by the result) */
+    cost_t cost;      /* of the result */
+    bool truncated;   /* the start stopped at a limit */
+    int *cancel;      /* set when the target has been reached */
+} portfolio_start_t;
+
+static void portfolio_run(void *arg) {
+    portfolio_start_t *s = (portfolio_start_t *)arg;
+    pcontext ctx = current_context; /* maybe the caller's, without a pool */
+    bool toggle = ctx->toggle, unwrap_flipped = ctx->unwrap_flipped;
+    unsigned long long seed = ctx->seed;
+    int *cancel = ctx->cancel;
+
+    ctx->toggle = (s->k & 1) == 0;
+    ctx->unwrap_flipped = (s->k & 2) != 0;
+    ctx->seed = (unsigned long long)(s->k >> 2);
+    ctx->cancel = portfolio_target > 0 ? s->cancel : NIL(int);
+
+    s->F = espresso(s->F, s->D, s->R);
+    s->truncated = ctx->truncated;
+    cover_cost(s->F, &s->cost);
+    if (portfolio_target > 0 && s->cost.cubes <= portfolio_target)
+        __atomic_store_n(s->cancel, 1, __ATOMIC_RELAXED);
+
+    ctx->toggle = toggle;
+    ctx->unwrap_flipped = unwrap_flipped;
+    ctx->seed = seed;
+    ctx->cancel = cancel;
+}
+
+/*
+    espresso_portfolio -- minimize F from portfolio_starts starts (see
+    above); the costs of the starts are reported on stderr
+*/
+pcover espresso_portfolio(pcover F, pcover D, pcover R) {
+    portfolio_start_t *starts;
+    task_group_t tasks = {0};
+    int k, best, nstarts = portfolio_starts, cancel = 0;
+
+    if (nstarts <= 1)
+        return espresso(F, D, R);
+
+    starts = ALLOC(portfolio_start_t, nstarts);
+    for (k = 0; k < nstarts; k++) {
+        starts[k].k = k;
+        starts[k].F = sf_save(F);
+        starts[k].D = sf_save(D);
+        starts[k].R = sf_save(R);
+        starts[k].cancel = &cancel;
+        task_spawn(&tasks, portfolio_run, &starts[k]);
+    }
+    task_wait(&tasks);
+
+    /* the cheapest cover (cubes first, then literals) */
+    best = 0;
+    for (k = 1; k < nstarts; k++)
+        if (starts[k].cost.cubes < starts[best].cost.cubes ||
+            (starts[k].cost.cubes == starts[best].cost.cubes &&
+             starts[k].cost.total < starts[best].cost.total))
+            best = k;
+
+    fprintf(stderr, "# portfolio: %d starts, cubes", nstarts);
+    for (k = 0; k < nstarts; k++)
+        fprintf(stderr, " %d%s", starts[k].cost.cubes,
+                starts[k].truncated ? "*" : "");
+    fprintf(stderr, ", best is start %d\n", best);
+
+    free_cover(F);
+    F = starts[best].F;
+    current_context->truncated = starts[best].truncated || cancel;
+    for (k = 0; k < nstarts; k++) {
+        if (k != best)
+            free_cover(starts[k].F);
+        free_cover(starts[k].D);
+        free_cover(starts[k].R);
+    }
+    FREE(starts);
+    return F;
+}
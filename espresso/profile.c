@@ -0,0 +1,145 @@
+/*
+    module: profile.c
+    purpose: counters of where the time of a run goes, written as JSON
+
+    With -P, the top-level phases of espresso() (and the complement
+    computed by read_pla()) are timed, and the size of the cover after
+    each of them is kept as a trace.  The unate recursions count their
+    calls and their depth in the current context, whether profiling or
+    not; those counts are added to the totals when a context is freed
+    (a task, or a file of batch mode) and when the profile is written.
+    The statistics of sm_minimum_cover() are added after each call, and
+    those of the memo of tautology() (memo.c) are taken at the end.
+
+    Phases of minimizations which run concurrently (batch mode, or the
+    groups of -g) are added together, so they may exceed the wall time.
+*/
+
+#include <pthread.h>
+
+#include "espresso.h"
+
+bool profiling = FALSE;
+
+static char *phase_name[PHASES] = {
+    "complement", "expand", "irredundant", "essential",
+    "reduce",     "gasp",   "make_sparse"};
+
+static char *recursion_name[RECURSIONS] = {"complement", "tautology", "sccc"};
+
+typedef struct {
+    int phase;
+    int cubes;
+    double seconds;
+} profile_step_t;
+
+static struct {
+    double start;                     /* when profiling began */
+    int calls[PHASES];                /* calls of each phase */
+    double seconds[PHASES];           /* time spent in them */
+    long long nodes[RECURSIONS];      /* calls of each recursion */
+    int max_depth[RECURSIONS];        /* deepest level reached */
+    int mincov_calls, mincov_depth;   /* sm_minimum_cover() calls, depth */
+    long long mincov_nodes;           /* ... nodes of their searches */
+    long long mincov_components;      /* ... components split off */
+    long long mincov_gimpel;          /* ... Gimpel reductions */
+    profile_step_t *trace;            /* the phases in the order run */
+    int steps, size;
+} totals;
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* profile_open -- start profiling */
+void profile_open() {
+    profiling = TRUE;
+    totals.start = wall_time();
+}
+
+/* profile_start -- the time a phase begins (if profiling) */
+double profile_start() {
+    return profiling ? wall_time() : 0;
+}
+
+/* profile_phase -- a phase begun at "start" has left the cover "F" */
+void profile_phase(int phase, double start, pcover F) {
+    double t;
+
+    if (!profiling)
+        return;
+    t = wall_time() - start;
+    (void)pthread_mutex_lock(&profile_lock);
+    totals.calls[phase]++;
+    totals.seconds[phase] += t;
+    if (totals.steps == totals.size)
+        totals.trace = REALLOC(profile_step_t, totals.trace,
+                               totals.size = 2 * totals.size + 64);
+    totals.trace[totals.steps].phase = phase;
+    totals.trace[totals.steps].cubes = F->count;
+    totals.trace[totals.steps++].seconds = t;
+    (void)pthread_mutex_unlock(&profile_lock);
+}
+
+/* profile_merge -- add the recursion counts of "ctx" to the totals */
+void profile_merge(pcontext ctx) {
+    int r;
+
+    if (!profiling)
+        return;
+    (void)pthread_mutex_lock(&profile_lock);
+    for (r = 0; r < RECURSIONS; r++) {
+        totals.nodes[r] += ctx->prof.nodes[r];
+        totals.max_depth[r] = MAX(totals.max_depth[r], ctx->prof.max_depth[r]);
+    }
+    (void)pthread_mutex_unlock(&profile_lock);
+    memset(&ctx->prof, 0, sizeof(ctx->prof));
+}
+
+/* profile_mincov -- add the statistics of a call of sm_minimum_cover() */
+void profile_mincov(int nodes, int max_depth, int components, int gimpel) {
+    if (!profiling)
+        return;
+    (void)pthread_mutex_lock(&profile_lock);
+    totals.mincov_calls++;
+    totals.mincov_nodes += nodes;
+    totals.mincov_depth = MAX(totals.mincov_depth, max_depth);
+    totals.mincov_components += components;
+    totals.mincov_gimpel += gimpel;
+    (void)pthread_mutex_unlock(&profile_lock);
+}
+
+/* profile_write -- write the totals as a JSON object on "fp" */
+void profile_write(FILE *fp) {
+    long long memo[4];
+    int i;
+
+    profile_merge(current_context);
+    fprintf(fp, "{\n  \"seconds\": %.6f,\n  \"phases\": {", wall_time() -
+                                                          totals.start);
+    for (i = 0; i < PHASES; i++)
+        fprintf(fp, "%s\n    \"%s\": {\"calls\": %d, \"seconds\": %.6f}",
+                i == 0 ? "" : ",", phase_name[i], totals.calls[i],
+                totals.seconds[i]);
+    fprintf(fp, "\n  },\n  \"recursions\": {");
+    for (i = 0; i < RECURSIONS; i++)
+        fprintf(fp, "%s\n    \"%s\": {\"calls\": %lld, \"max_depth\": %d}",
+                i == 0 ? "" : ",", recursion_name[i], totals.nodes[i],
+                totals.max_depth[i]);
+    fprintf(fp,
+            "\n  },\n  \"mincov\": {\"calls\": %d, \"nodes\": %lld, "
+            "\"max_depth\": %d, \"components\": %lld, \"gimpel\": %lld},\n",
+            totals.mincov_calls, totals.mincov_nodes, totals.mincov_depth,
+            totals.mincov_components, totals.mincov_gimpel);
+    memo_counts(memo);
+    fprintf(fp,
+            "  \"memo\": {\"lookups\": %lld, \"hits\": %lld, "
+            "\"stores\": %lld, \"flushes\": %lld},\n",
+            memo[0], memo[1], memo[2], memo[3]);
+    if (alloc_profiling)
+        alloc_profile_write(fp, phase_name);
+    fprintf(fp, "  \"trace\": [");
+    for (i = 0; i < totals.steps; i++)
+        fprintf(fp, "%s\n    {\"phase\": \"%s\", \"cubes\": %d, "
+                    "\"seconds\": %.6f}",
+                i == 0 ? "" : ",", phase_name[totals.trace[i].phase],
+                totals.trace[i].cubes, totals.trace[i].seconds);
+    fprintf(fp, "\n  ]\n}\n");
+}
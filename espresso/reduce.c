@@ -9,7 +9,7 @@
 
 #include "espresso.h"
 
-static bool toggle = TRUE;
+#define toggle (current_context->toggle)
 
 /*
     reduce -- replace each cube in F with its reduction
@@ -47,7 +47,7 @@ pcover reduce(pcover F, pcover D) {
     pcube last, p, cunder, *FD;
 
     /* Order the cubes */
-    F = toggle ? sort_reduce(F) : mini_sort(F, descend);
+    F = toggle ? sort_reduce(F) : mini_sort(F, SORT_DESCEND);
     toggle = !toggle;
 
     /* Try to reduce each cube */
@@ -88,6 +88,7 @@ pcube sccc(pcube *T /* T will be disposed of */
     pcube cl, cr;
     int best;
 
+    RECUR_ENTER(RECUR_SCCC);
     if (sccc_special_cases(T, &r) == MAYBE) {
         cl = new_cube();
         cr = new_cube();
@@ -96,6 +97,7 @@ pcube sccc(pcube *T /* T will be disposed of */
                        sccc(scofactor(T, cr, best)), cl, cr);
         free_cubelist(T);
     }
+    RECUR_LEAVE(RECUR_SCCC);
 
     return r;
 }
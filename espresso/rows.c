@@ -7,15 +7,14 @@
 sm_row *sm_row_alloc() {
     sm_row *prow;
 
-#ifdef FAST_AND_LOOSE
-    if (sm_row_freelist == NIL(sm_row)) {
-        prow = ALLOC(sm_row, 1);
-    } else {
-        prow = sm_row_freelist;
-        sm_row_freelist = prow->next_row;
-    }
-#else
+#ifdef NO_SM_POOL
     prow = ALLOC(sm_row, 1);
+#else
+    if (sm_pool.rows == NIL(sm_row))
+        sm_pool_refill(SM_ROWS);
+    prow = sm_pool.rows;
+    sm_pool.rows = prow->next_row;
+    sm_pool.nrows--;
 #endif
 
     prow->row_num = 0;
@@ -23,28 +22,15 @@ sm_row *sm_row_alloc() {
     prow->first_col = prow->last_col = NIL(sm_element);
     prow->next_row = prow->prev_row = NIL(sm_row);
     prow->flag = 0;
-    prow->user_word = NIL(char); /* for our user ... */
     return prow;
 }
 
 /*
- *  free a row vector -- for FAST_AND_LOOSE, this is real cheap for rows;
- *  however, freeing a column must still walk down the column discarding
- *  the elements one-by-one; that is the only use for the extra '-DCOLS'
- *  compile flag ...
+ *  free a row vector -- this is real cheap for rows, as the elements are
+ *  linked by next_col already
  */
 void sm_row_free(sm_row *prow) {
-#if defined(FAST_AND_LOOSE) && !defined(COLS)
-    if (prow->first_col != NIL(sm_element)) {
-        /* Add the linked list of row items to the free list */
-        prow->last_col->next_col = sm_element_freelist;
-        sm_element_freelist = prow->first_col;
-    }
-
-    /* Add the row to the free list of rows */
-    prow->next_row = sm_row_freelist;
-    sm_row_freelist = prow;
-#else
+#ifdef NO_SM_POOL
     sm_element *p, *pnext;
 
     for (p = prow->first_col; p != 0; p = pnext) {
@@ -52,6 +38,18 @@ void sm_row_free(sm_row *prow) {
         sm_element_free(p);
     }
     FREE(prow);
+#else
+    if (prow->first_col != NIL(sm_element)) {
+        /* Add the linked list of row items to the free list */
+        prow->last_col->next_col = sm_pool.elements;
+        sm_pool.elements = prow->first_col;
+        sm_pool.nelements += prow->length;
+    }
+
+    /* Add the row to the free list of rows */
+    prow->next_row = sm_pool.rows;
+    sm_pool.rows = prow;
+    sm_pool.nrows++;
 #endif
 }
 
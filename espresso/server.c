@@ -0,0 +1,450 @@
+/*
+    module: server.c
+    purpose: minimize a stream of PLAs in one long-running process
+
+    A flow which minimizes many small PLAs spends more time starting
+    espresso, setting up the cube structure and releasing its storage
+    than minimizing.  With -l, espresso reads PLAs one after the other
+    from the standard input, or from the connections to a Unix socket,
+    and minimizes them on a pool of worker threads.
+
+    A request is the text of a PLA, up to its .e (or .end) line.  The
+    answer is a line
+
+        # seconds cubes_in -> cubes_out status
+
+    followed by the minimized PLA, or by .e alone when the request failed.
+    The answers of a connection come in the order of its requests, which
+    may be sent without waiting for the answers of the earlier ones.
+
+    Each worker keeps a context of its own from one request to the next
+    (see context_reset()): the storage of its recursions, its free set
+    families and, while the PLAs have the same shape, the cube structure.
+*/
+
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "espresso.h"
+
+typedef struct server_conn_struct server_conn_t;
+
+typedef struct server_job_struct {
+    server_conn_t *conn;
+    char *text;                     /* the request */
+    size_t len;
+    int ni, no;                     /* its .i and .o (0 if not seen) */
+    char *answer;                   /* once minimized (or NULL) */
+    size_t answer_len;
+    char *status;                   /* "ok", or the reason for the failure */
+    int cubes_in, cubes_out;
+    struct server_job_struct *next; /* in the order of the connection */
+    struct server_job_struct *next_queued; /* waiting for a worker */
+} server_job_t;
+
+struct server_conn_struct {
+    int fd;                     /* where the answers go */
+    bool own_fd;                /* closed with the connection */
+    bool broken;                /* a write failed: the answers are dropped */
+    bool reading;               /* more requests may come */
+    server_job_t *first, *last; /* the requests not answered yet */
+    pthread_mutex_t lock;
+};
+
+static struct {
+    server_job_t *head, *tail; /* waiting for a worker */
+    int pending;               /* queued or running */
+    bool stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t work; /* a job was queued (or stopping was set) */
+    pthread_cond_t idle; /* pending dropped to 0 */
+} server;
+
+/* server_write -- write all of "buf" on the connection (unless broken) */
+static void server_write(server_conn_t *conn, char *buf, size_t len) {
+    ssize_t n;
+
+    while (len > 0 && !conn->broken) {
+        if ((n = write(conn->fd, buf, len)) < 0) {
+            if (errno != EINTR)
+                conn->broken = TRUE;
+        } else {
+            buf += n;
+            len -= n;
+        }
+    }
+}
+
+static server_conn_t *server_conn_new(int fd, bool own_fd) {
+    server_conn_t *conn = ALLOC(server_conn_t, 1);
+
+    conn->fd = fd;
+    conn->own_fd = own_fd;
+    conn->broken = FALSE;
+    conn->reading = TRUE;
+    conn->first = conn->last = NIL(server_job_t);
+    pthread_mutex_init(&conn->lock, NULL);
+    return conn;
+}
+
+static void server_conn_free(server_conn_t *conn) {
+    if (conn->own_fd)
+        (void)close(conn->fd);
+    pthread_mutex_destroy(&conn->lock);
+    FREE(conn);
+}
+
+static void server_job_free(server_job_t *job) {
+    FREE(job->text);
+    FREE(job->answer);
+    FREE(job);
+}
+
+/*
+    server_answer -- give the answer of a job to its connection, writing
+    out the answers which are no longer waiting for an earlier one; the
+    connection is released once it has answered its last request
+*/
+static void server_answer(server_job_t *job, char *answer, size_t len) {
+    server_conn_t *conn = job->conn;
+    server_job_t *j;
+    bool done;
+
+    pthread_mutex_lock(&conn->lock);
+    job->answer = answer;
+    job->answer_len = len;
+    while ((j = conn->first) != NIL(server_job_t) && j->answer != NIL(char)) {
+        server_write(conn, j->answer, j->answer_len);
+        if ((conn->first = j->next) == NIL(server_job_t))
+            conn->last = NIL(server_job_t);
+        server_job_free(j);
+    }
+    done = !conn->reading && conn->first == NIL(server_job_t);
+    pthread_mutex_unlock(&conn->lock);
+    if (done)
+        server_conn_free(conn);
+}
+
+/* server_submit -- queue a request of the connection */
+static void server_submit(server_conn_t *conn, server_job_t *job) {
+    job->conn = conn;
+    job->answer = NIL(char);
+    job->next = job->next_queued = NIL(server_job_t);
+
+    pthread_mutex_lock(&conn->lock);
+    if (conn->last == NIL(server_job_t))
+        conn->first = job;
+    else
+        conn->last->next = job;
+    conn->last = job;
+    pthread_mutex_unlock(&conn->lock);
+
+    pthread_mutex_lock(&server.lock);
+    if (server.tail == NIL(server_job_t))
+        server.head = job;
+    else
+        server.tail->next_queued = job;
+    server.tail = job;
+    server.pending++;
+    pthread_cond_signal(&server.work);
+    pthread_mutex_unlock(&server.lock);
+}
+
+/*
+    server_read_request -- read the next request from "in"; NULL at the
+    end of the input
+*/
+static server_job_t *server_read_request(FILE *in) {
+    server_job_t *job;
+    char *line = NIL(char), *p, word[8];
+    size_t size = 0, capacity = 4096;
+    ssize_t n;
+    bool blank = TRUE;
+
+    job = ALLOC(server_job_t, 1);
+    job->text = ALLOC(char, capacity);
+    job->len = 0;
+    job->ni = job->no = 0;
+    job->answer = NIL(char);
+    while ((n = getline(&line, &size, in)) > 0) {
+        if (job->len + n + 1 > capacity) {
+            capacity = 2 * (job->len + n + 1);
+            job->text = REALLOC(char, job->text, capacity);
+        }
+        memcpy(job->text + job->len, line, n);
+        job->len += n;
+
+        for (p = line; isspace((unsigned char)*p); p++)
+            ;
+        if (*p == '\0')
+            continue;
+        blank = FALSE;
+        if (*p == '.' && sscanf(p + 1, "%7s", word) == 1) {
+            if (equal(word, "i") && job->ni == 0)
+                (void)sscanf(p + 2, "%d", &job->ni);
+            else if (equal(word, "o") && job->no == 0)
+                (void)sscanf(p + 2, "%d", &job->no);
+            else if (equal(word, "e") || equal(word, "end"))
+                break;
+        }
+    }
+    free(line); /* (from getline(), see alloc.c) */
+    if (blank) {
+        server_job_free(job);
+        return NIL(server_job_t);
+    }
+    job->text[job->len] = '\0';
+    return job;
+}
+
+/* server_read -- submit the requests read from "in" until its end */
+static void server_read(server_conn_t *conn, FILE *in) {
+    server_job_t *job;
+    bool done;
+
+    while ((job = server_read_request(in)) != NIL(server_job_t))
+        server_submit(conn, job);
+
+    pthread_mutex_lock(&conn->lock);
+    conn->reading = FALSE;
+    done = conn->first == NIL(server_job_t);
+    pthread_mutex_unlock(&conn->lock);
+    if (done)
+        server_conn_free(conn);
+}
+
+/*
+    server_run_job -- minimize the request of a job in the current
+    context, and answer it; FALSE if the context was left by fatal()
+*/
+static bool server_run_job(server_job_t *job) {
+    pcontext ctx = current_context;
+    jmp_buf env;
+    FILE *out;
+    pPLA PLA;
+    pcover F0;
+    bool solved;
+    cache_key_t key;
+    char mode[64], *text = NIL(char), *answer;
+    size_t size = 0, len;
+    double start;
+    bool ok, clean;
+
+    start = wall_time();
+    job->cubes_in = job->cubes_out = 0;
+    if ((out = open_memstream(&text, &size)) == NULL)
+        fatal("server: cannot open a memory stream");
+
+    ctx->fatal_env = &env;
+    if (setjmp(env) != 0) {
+        /* fatal() was called; the covers of this request are abandoned */
+        job->status = "fatal error";
+    } else if (read_pla_text(job->text, job->len, &PLA) == EOF) {
+        job->status = "no PLA found";
+        free_PLA(PLA);
+    } else {
+        job->cubes_in = PLA->F->count;
+        (void)sprintf(mode, "groups 1 passes %d strategy %d starts %d",
+                      pass_limit, espresso_strategy(), portfolio_starts);
+        cache_key(&key, CACHE_RESULT, PLA, mode);
+        F0 = verify_result ? sf_save(PLA->F) : (pcover)NULL;
+        solved = !cache_get(&key, PLA);
+        if (solved) {
+            if (decompose_function)
+                PLA->F = espresso_decomposed(PLA->F, PLA->D, PLA->R);
+            else
+                PLA->F = espresso_portfolio(PLA->F, PLA->D, PLA->R);
+        }
+        job->cubes_out = PLA->F->count;
+        if (F0 != (pcover)NULL && !espresso_verify(PLA->F, F0, PLA->D)) {
+            job->status = "verification failed";
+        } else {
+            if (solved && !ctx->truncated)
+                cache_put(&key, PLA);
+            fprint_pla(out, PLA);
+            job->status = ctx->truncated ? "ok (stopped early)" : "ok";
+        }
+        if (F0 != (pcover)NULL)
+            free_cover(F0);
+        free_PLA(PLA);
+    }
+    ctx->fatal_env = NULL;
+
+    (void)fclose(out);
+    ok = strncmp(job->status, "ok", 2) == 0;
+    answer = ALLOC(char, size + 128);
+    len = sprintf(answer, "# %.6fs %d -> %d %s\n", wall_time() - start,
+                  job->cubes_in, job->cubes_out, job->status);
+    if (ok) {
+        memcpy(answer + len, text, size);
+        len += size;
+    } else {
+        len += sprintf(answer + len, ".e\n");
+    }
+    free(text); /* (from open_memstream()) */
+    clean = strcmp(job->status, "fatal error") != 0;
+    server_answer(job, answer, len); /* (which may free the job) */
+    return clean;
+}
+
+/* server_worker -- minimize the requests of the queue, in a context kept */
+static void *server_worker(void *arg) {
+    pcontext ctx = context_new();
+    server_job_t *job;
+    bool clean = TRUE;
+
+    (void)arg;
+    (void)context_set(ctx);
+    for (;;) {
+        pthread_mutex_lock(&server.lock);
+        while (server.head == NIL(server_job_t) && !server.stopping)
+            pthread_cond_wait(&server.work, &server.lock);
+        if ((job = server.head) != NIL(server_job_t) &&
+            (server.head = job->next_queued) == NIL(server_job_t))
+            server.tail = NIL(server_job_t);
+        pthread_mutex_unlock(&server.lock);
+        if (job == NIL(server_job_t))
+            break;
+
+        /* the cube structure is kept for a PLA of the same shape */
+        context_reset(ctx, clean && cube.fullset != NULL &&
+                               cube.num_vars == cube.num_binary_vars + 1 &&
+                               cube.num_binary_vars == job->ni &&
+                               cube.part_size[cube.num_vars - 1] == job->no);
+        clean = server_run_job(job);
+
+        pthread_mutex_lock(&server.lock);
+        if (--server.pending == 0)
+            pthread_cond_broadcast(&server.idle);
+        pthread_mutex_unlock(&server.lock);
+    }
+    (void)context_set(NULL);
+    context_free(ctx);
+    sm_cleanup();
+    return NULL;
+}
+
+/* server_connection -- read the requests of a connection to the socket */
+static void *server_connection(void *arg) {
+    server_conn_t *conn = (server_conn_t *)arg;
+    FILE *in;
+    int fd;
+
+    /* the input has a descriptor of its own, the answers may outlive it */
+    if ((fd = dup(conn->fd)) < 0 || (in = fdopen(fd, "r")) == NULL) {
+        if (fd >= 0)
+            (void)close(fd);
+        pthread_mutex_lock(&conn->lock);
+        conn->reading = FALSE;
+        pthread_mutex_unlock(&conn->lock);
+        server_conn_free(conn);
+        return NULL;
+    }
+    server_read(conn, in);
+    (void)fclose(in);
+    return NULL;
+}
+
+/* server_listen -- a socket listening at "path" (or -1) */
+static int server_listen(char *path) {
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "espresso: socket name too long: %s\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    (void)strcpy(addr.sun_path, path);
+
+    /* a socket left by an earlier server is replaced */
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        (void)unlink(path);
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, 64) != 0) {
+        fprintf(stderr, "espresso: cannot listen on %s: %s\n", path,
+                strerror(errno));
+        if (fd >= 0)
+            (void)close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+    server_run -- serve the requests read from the standard input (path
+    "-", answered on the standard output) until its end, or from the
+    connections to a Unix socket at "path" until killed, with "nthreads"
+    workers; returns the exit status
+*/
+int server_run(char *path, int nthreads) {
+    pthread_t *threads, thread;
+    pthread_attr_t attr;
+    server_conn_t *conn;
+    int i, fd, lfd, status = 0;
+
+    /* a client which goes away must not take the server with it */
+    (void)signal(SIGPIPE, SIG_IGN);
+
+    server.head = server.tail = NIL(server_job_t);
+    server.pending = 0;
+    server.stopping = FALSE;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.work, NULL);
+    pthread_cond_init(&server.idle, NULL);
+    threads = ALLOC(pthread_t, nthreads);
+    for (i = 0; i < nthreads; i++)
+        if (pthread_create(&threads[i], NULL, server_worker, NULL) != 0)
+            fatal("server: cannot create worker thread");
+
+    if (equal(path, "-")) {
+        server_read(server_conn_new(STDOUT_FILENO, FALSE), stdin);
+    } else if ((lfd = server_listen(path)) < 0) {
+        status = 1;
+    } else {
+        fprintf(stderr, "# serving on %s with %d threads\n", path, nthreads);
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        for (;;) {
+            if ((fd = accept(lfd, NULL, NULL)) < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                fprintf(stderr, "espresso: accept on %s: %s\n", path,
+                        strerror(errno));
+                status = 1;
+                break;
+            }
+            conn = server_conn_new(fd, TRUE);
+            if (pthread_create(&thread, &attr, server_connection, conn) != 0) {
+                /* (no request was read, so the connection is released) */
+                conn->reading = FALSE;
+                server_conn_free(conn);
+            }
+        }
+        pthread_attr_destroy(&attr);
+        (void)close(lfd);
+    }
+
+    /* answer what was submitted, then stop the workers */
+    pthread_mutex_lock(&server.lock);
+    while (server.pending > 0)
+        pthread_cond_wait(&server.idle, &server.lock);
+    server.stopping = TRUE;
+    pthread_cond_broadcast(&server.work);
+    pthread_mutex_unlock(&server.lock);
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    FREE(threads);
+    pthread_mutex_destroy(&server.lock);
+    pthread_cond_destroy(&server.work);
+    pthread_cond_destroy(&server.idle);
+    sm_cleanup();
+    return status;
+}
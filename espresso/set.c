@@ -3,9 +3,14 @@
  */
 
 #include "espresso.h"
-static pset_family set_family_garbage = NULL;
 
-static void intcpy(unsigned int *d, unsigned int *s, long n) {
+/* set families free'd by sf_free() are kept on a per-context list */
+#define set_family_garbage (current_context->set_family_garbage)
+
+/* bit-sliced planes for sf_count_restricted (the weights are at most 1024) */
+#define RESTRICT_PLANES 16
+
+static void intcpy(set_word_t *d, set_word_t *s, long n) {
     int i;
     for (i = 0; i < n; i++) {
         *d++ = *s++;
@@ -13,7 +18,7 @@ static void intcpy(unsigned int *d, unsigned int *s, long n) {
 }
 
 /* bit_index -- find first bit (from LSB) in a word (MSB=bit n, LSB=bit 0) */
-int bit_index(unsigned int a) {
+int bit_index(set_word_t a) {
     int i;
     if (a == 0)
         return -1;
@@ -25,7 +30,7 @@ int bit_index(unsigned int a) {
 /* set_ord -- count number of elements in a set */
 int set_ord(pset a) {
     int i, sum = 0;
-    unsigned int val;
+    set_word_t val;
     for (i = LOOP(a); i > 0; i--)
         if ((val = a[i]) != 0)
             sum += count_ones(val);
@@ -35,7 +40,7 @@ int set_ord(pset a) {
 /* set_dist -- distance between two sets (# elements in common) */
 int set_dist(pset a, pset b) {
     int i, sum = 0;
-    unsigned int val;
+    set_word_t val;
     for (i = LOOP(a); i > 0; i--)
         if ((val = a[i] & b[i]) != 0)
             sum += count_ones(val);
@@ -45,7 +50,8 @@ int set_dist(pset a, pset b) {
 /* set_clear -- make "r" the empty set of "size" elements */
 pset set_clear(pset r, int size) {
     int i = LOOPINIT(size);
-    *r = i;
+    *r = (set_word_t)i << LOOPSHIFT;
+    r[i + 1] = 0;
     do
         r[i] = 0;
     while (--i > 0);
@@ -55,11 +61,12 @@ pset set_clear(pset r, int size) {
 /* set_fill -- make "r" the universal set of "size" elements */
 pset set_fill(pset r, int size) {
     int i = LOOPINIT(size);
-    *r = i;
-    r[i] = ~(unsigned)0;
+    *r = (set_word_t)i << LOOPSHIFT;
+    r[i + 1] = 0;
+    r[i] = ~(set_word_t)0;
     r[i] >>= i * BPI - size;
     while (--i > 0)
-        r[i] = ~(unsigned)0;
+        r[i] = ~(set_word_t)0;
     return r;
 }
 
@@ -142,16 +149,6 @@ bool setp_disjoint(pset a, pset b) {
     return TRUE;
 }
 
-/* setp_implies -- check if "a" implies "b" ("b" contains "a") */
-bool setp_implies(pset a, pset b) {
-    int i = LOOP(a);
-    do
-        if (a[i] & ~b[i])
-            return FALSE;
-    while (--i > 0);
-    return TRUE;
-}
-
 /* sf_active -- make all members of the set family active */
 pset_family sf_active(pset_family A) {
     pset p, last;
@@ -185,7 +182,7 @@ pset_family sf_copy(pset_family R, pset_family A) {
     R->sf_size = A->sf_size;
     R->wsize = A->wsize;
     /*R->capacity = A->count;*/
-    /*R->data = REALLOC(unsigned int, R->data, (long) R->capacity * R->wsize);*/
+    /*R->data = REALLOC(set_word_t, R->data, (long) R->capacity * R->wsize);*/
     R->count = A->count;
     R->active_count = A->active_count;
     intcpy(R->data, A->data, (long)A->wsize * A->count);
@@ -208,6 +205,23 @@ pset_family sf_join(pset_family A, pset_family B) {
     return R;
 }
 
+/* sf_resize -- change the number of sets allocated (moving mapped sets) */
+static void sf_resize(pset_family A, int capacity) {
+    pset data;
+
+    if (A->mapped) {
+        data = ALLOC(set_word_t, (long)capacity * A->wsize);
+        intcpy(data, A->data, (long)A->count * A->wsize);
+        A->data = data;
+        A->mapped = FALSE;
+    } else {
+        A->data = REALLOC(set_word_t, A->data, (long)capacity * A->wsize);
+    }
+    A->capacity = capacity;
+    if (alloc_profiling)
+        alloc_family(A);
+}
+
 /* sf_append -- append the sets of B to the end of A, and dispose of B */
 pset_family sf_append(pset_family A, pset_family B) {
     long asize = A->count * A->wsize;
@@ -215,8 +229,7 @@ pset_family sf_append(pset_family A, pset_family B) {
 
     if (A->sf_size != B->sf_size)
         fatal("sf_append: sf_size mismatch");
-    A->capacity = A->count + B->count;
-    A->data = REALLOC(unsigned int, A->data, (long)A->capacity * A->wsize);
+    sf_resize(A, A->count + B->count);
     intcpy(A->data + asize, B->data, bsize);
     A->count += B->count;
     A->active_count += B->active_count;
@@ -236,9 +249,23 @@ pset_family sf_new(int num, int size) {
     A->sf_size = size;
     A->wsize = SET_SIZE(size);
     A->capacity = num;
-    A->data = ALLOC(unsigned int, (long)A->capacity * A->wsize);
+    A->data = ALLOC(set_word_t, (long)A->capacity * A->wsize);
+    A->mapped = FALSE;
     A->count = 0;
     A->active_count = 0;
+    if (alloc_profiling)
+        alloc_family(A);
+    return A;
+}
+
+/* sf_mapped -- a family of the "num" sets at "data", which it does not own */
+pset_family sf_mapped(pset data, int num, int size) {
+    pset_family A = sf_new(0, size);
+
+    FREE(A->data);
+    A->data = data;
+    A->mapped = TRUE;
+    A->capacity = A->count = num;
     return A;
 }
 
@@ -249,6 +276,8 @@ pset_family sf_save(pset_family A) {
 
 /* sf_free -- free the storage allocated for a set family */
 void sf_free(pset_family A) {
+    if (A->mapped)
+        A->data = NIL(set_word_t);
     FREE(A->data);
     A->next = set_family_garbage;
     set_family_garbage = A;
@@ -268,10 +297,8 @@ void sf_cleanup() {
 pset_family sf_addset(pset_family A, pset s) {
     pset p;
 
-    if (A->count >= A->capacity) {
-        A->capacity = A->capacity + A->capacity / 2 + 1;
-        A->data = REALLOC(unsigned int, A->data, (long)A->capacity * A->wsize);
-    }
+    if (A->count >= A->capacity)
+        sf_resize(A, A->capacity + A->capacity / 2 + 1);
     p = GETSET(A, A->count++);
     INLINEset_copy(p, s);
     return A;
@@ -280,7 +307,7 @@ pset_family sf_addset(pset_family A, pset s) {
 /* set_adjcnt -- adjust the counts for a set by "weight" */
 void set_adjcnt(pset a, int *count, int weight) {
     int i, base;
-    unsigned int val;
+    set_word_t val;
 
     for (i = LOOP(a); i > 0;) {
         for (val = a[i], base = --i << LOGBPI; val != 0; base++, val >>= 1) {
@@ -291,57 +318,120 @@ void set_adjcnt(pset a, int *count, int weight) {
     }
 }
 
+/* bitcount_flush -- add the bit-sliced counts to "count" and clear them */
+void bitcount_flush(set_word_t *plane, int nplanes, int nwords, int *count) {
+    int w, j;
+    set_word_t val;
+
+    for (w = 0; w < nwords; w++, plane += nplanes, count += BPI)
+        for (j = 0; j < nplanes; j++)
+            if ((val = plane[j]) != 0) {
+                plane[j] = 0;
+                for (; val != 0; val &= val - 1)
+                    count[LOWEST_BIT(val)] += 1 << j;
+            }
+}
+
 /* sf_count -- perform a column sum over a set family */
 int *sf_count(pset_family A) {
     pset p, last;
-    int i, base, *count;
-    unsigned int val;
-
-    count = ALLOC(int, A->sf_size);
-    for (i = A->sf_size - 1; i >= 0; i--) {
-        count[i] = 0;
+    int i, n, nwords, *count, *wide;
+    set_word_t *plane;
+
+    /* count into whole words, the counts past sf_size are all zero */
+    nwords = LOOPINIT(A->sf_size);
+    wide = ALLOC(int, nwords * BPI);
+    for (i = nwords * BPI - 1; i >= 0; i--) {
+        wide[i] = 0;
+    }
+    plane = ALLOC(set_word_t, nwords * COUNT_PLANES);
+    for (i = nwords * COUNT_PLANES - 1; i >= 0; i--) {
+        plane[i] = 0;
     }
 
+    n = 0;
     foreach_set(A, last, p) {
-        for (i = LOOP(p); i > 0;) {
-            for (val = p[i], base = --i << LOGBPI; val != 0;
-                 base++, val >>= 1) {
-                if (val & 1) {
-                    count[base]++;
-                }
-            }
+        for (i = LOOP(p); i > 0; i--)
+            if (p[i] != 0)
+                BITCOUNT_ADD(plane + (i - 1) * COUNT_PLANES, p[i]);
+        if (++n == COUNT_FLUSH) {
+            bitcount_flush(plane, COUNT_PLANES, nwords, wide);
+            n = 0;
         }
     }
+    bitcount_flush(plane, COUNT_PLANES, nwords, wide);
+    FREE(plane);
+
+    count = ALLOC(int, A->sf_size);
+    memcpy(count, wide, sizeof(int) * A->sf_size);
+    FREE(wide);
     return count;
 }
 
+/* adjcnt_restricted -- add "weight" to the counts of the elements of a & r */
+static void adjcnt_restricted(pset a, pset r, int *count, int weight) {
+    int i, base;
+    set_word_t val;
+
+    for (i = LOOP(a); i > 0;) {
+        for (val = a[i] & r[i], base = --i << LOGBPI; val != 0;
+             base++, val >>= 1) {
+            if (val & 1) {
+                count[base] += weight;
+            }
+        }
+    }
+}
+
 /* sf_count_restricted -- perform a column sum over a set family, restricting
  * to only the columns which are in r; also, the columns are weighted by the
  * number of elements which are in each row
  */
 int *sf_count_restricted(pset_family A, pset r) {
-    pset p;
-    int i, base, *count;
-    unsigned int val;
-    int weight;
-    pset last;
-
-    count = ALLOC(int, A->sf_size);
-    for (i = A->sf_size - 1; i >= 0; i--) {
-        count[i] = 0;
+    pset p, last;
+    int i, nwords, weight, bits, total, *count, *wide;
+    set_word_t val, *plane;
+
+    /*
+     * Bit-sliced as in sf_count, with enough planes for any weight: a set
+     * is added once for each bit of its weight, from that bit's plane on
+     * (a set whose weight has more than two bits is added to the counts
+     * directly instead)
+     */
+    nwords = LOOPINIT(A->sf_size);
+    wide = ALLOC(int, nwords * BPI);
+    for (i = nwords * BPI - 1; i >= 0; i--) {
+        wide[i] = 0;
+    }
+    plane = ALLOC(set_word_t, nwords * RESTRICT_PLANES);
+    for (i = nwords * RESTRICT_PLANES - 1; i >= 0; i--) {
+        plane[i] = 0;
     }
 
-    /* Loop for each set */
+    total = 0;
     foreach_set(A, last, p) {
         weight = 1024 / (set_ord(p) - 1);
-        for (i = LOOP(p); i > 0;) {
-            for (val = p[i] & r[i], base = --i << LOGBPI; val != 0;
-                 base++, val >>= 1) {
-                if (val & 1) {
-                    count[base] += weight;
-                }
-            }
+        if (bit_count[weight & 0xff] + bit_count[weight >> 8] > 2) {
+            adjcnt_restricted(p, r, wide, weight);
+            continue;
         }
+        if (total > (1 << RESTRICT_PLANES) - 1 - weight) {
+            bitcount_flush(plane, RESTRICT_PLANES, nwords, wide);
+            total = 0;
+        }
+        total += weight;
+        for (bits = weight; bits != 0; bits &= bits - 1)
+            for (i = LOOP(p); i > 0; i--)
+                if ((val = p[i] & r[i]) != 0)
+                    BITCOUNT_ADD(plane + (i - 1) * RESTRICT_PLANES +
+                                     LOWEST_BIT(bits),
+                                 val);
     }
+    bitcount_flush(plane, RESTRICT_PLANES, nwords, wide);
+    FREE(plane);
+
+    count = ALLOC(int, A->sf_size);
+    memcpy(count, wide, sizeof(int) * A->sf_size);
+    FREE(wide);
     return count;
 }
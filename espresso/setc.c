@@ -41,7 +41,7 @@
 #include "espresso.h"
 
 /* see if the cube has a full row of 1's (with respect to cof) */
-bool full_row(pcube p, pcube cof) {
+static bool scalar_full_row(pcube p, pcube cof) {
     int i = LOOP(p);
     do
         if ((p[i] | cof[i]) != cube.fullset[i])
@@ -50,14 +50,24 @@ bool full_row(pcube p, pcube cof) {
     return TRUE;
 }
 
+/* setp_implies -- check if "a" implies "b" ("b" contains "a") */
+static bool scalar_setp_implies(pset a, pset b) {
+    int i = LOOP(a);
+    do
+        if (a[i] & ~b[i])
+            return FALSE;
+    while (--i > 0);
+    return TRUE;
+}
+
 /*
     cdist0 -- return TRUE if a and b are distance 0 apart
 */
 
-bool cdist0(pcube a, pcube b) {
+static bool scalar_cdist0(pcube a, pcube b) {
     { /* Check binary variables */
         int w, last;
-        unsigned int x;
+        set_word_t x;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             x = a[last] & b[last];
@@ -95,12 +105,12 @@ bool cdist0(pcube a, pcube b) {
     exceeds 1, the value 2 is returned.
 */
 
-int cdist01(pset a, pset b) {
+static int scalar_cdist01(pset a, pset b) {
     int dist = 0;
 
     { /* Check binary variables */
         int w, last;
-        unsigned int x;
+        set_word_t x;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             x = a[last] & b[last];
@@ -140,12 +150,12 @@ int cdist01(pset a, pset b) {
     number of null variables in their intersection).
 */
 
-int cdist(pset a, pset b) {
+static int scalar_cdist(pset a, pset b) {
     int dist = 0;
 
     { /* Check binary variables */
         int w, last;
-        unsigned int x;
+        set_word_t x;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             x = a[last] & b[last];
@@ -181,10 +191,10 @@ int cdist(pset a, pset b) {
     force_lower -- Determine which variables of a do not intersect b.
 */
 
-pset force_lower(pset xlower, pset a, pset b) {
+static pset scalar_force_lower(pset xlower, pset a, pset b) {
     { /* Check binary variables (if any) */
         int w, last;
-        unsigned int x;
+        set_word_t x;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             x = a[last] & b[last];
@@ -230,12 +240,12 @@ pset force_lower(pset xlower, pset a, pset b) {
     represents the consensus when a and b are distance 1 apart.
 */
 
-void consensus(pcube r, pcube a, pcube b) {
+static void scalar_consensus(pcube r, pcube a, pcube b) {
     INLINEset_clear(r, cube.size);
 
     { /* Check binary variables (if any) */
         int w, last;
-        unsigned int x;
+        set_word_t x;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             r[last] = x = a[last] & b[last];
@@ -254,7 +264,7 @@ void consensus(pcube r, pcube a, pcube b) {
     { /* Check the multiple-valued variables */
         bool empty;
         int var;
-        unsigned int x;
+        set_word_t x;
         int w, last;
         pcube mask;
         for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
@@ -281,7 +291,7 @@ int cactive(pcube a) {
 
     { /* Check binary variables */
         int w, last;
-        unsigned int x;
+        set_word_t x;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             x = a[last];
@@ -326,11 +336,11 @@ int cactive(pcube a) {
     active variables include variables that are empty;
 */
 
-bool ccommon(pcube a, pcube b, pcube cof) {
+static bool scalar_ccommon(pcube a, pcube b, pcube cof) {
     { /* Check binary variables */
         int last;
         int w;
-        unsigned int x, y;
+        set_word_t x, y;
         if ((last = cube.inword) != -1) {
             /* Check the partial word of binary variables */
             x = a[last] | cof[last];
@@ -425,7 +435,7 @@ int ascend(pset *a, pset *b) {
 int d1_order(pset *a, pset *b) {
     pset a1 = *a, b1 = *b, c1 = cube.temp[0];
     int i = LOOP(a1);
-    unsigned int x1, x2;
+    set_word_t x1, x2;
     do
         if ((x1 = a1[i] | c1[i]) > (x2 = b1[i] | c1[i]))
             return -1;
@@ -434,3 +444,18 @@ int d1_order(pset *a, pset *b) {
     while (--i > 0);
     return 0;
 }
+
+/* the primitives of this file, for processors without vector support */
+const setc_kernels_t setc_scalar = {
+    .name = "scalar",
+    .width = 1,
+    .full_row = scalar_full_row,
+    .setp_implies = scalar_setp_implies,
+    .cdist0 = scalar_cdist0,
+    .cdist01 = scalar_cdist01,
+    .cdist = scalar_cdist,
+    .force_lower = scalar_force_lower,
+    .consensus = scalar_consensus,
+    .ccommon = scalar_ccommon,
+    .cofactor = NULL,
+};
@@ -0,0 +1,83 @@
+/*
+    module: setc_fixed.c
+    purpose: the cube primitives of setc.c for cubes of 1 to 8 words
+
+    Most functions have a few dozen inputs, so their cubes fit in a few
+    words, and the loops of the primitives spend more time finding their
+    bounds (the word holding the last binary variable, the words of each
+    multiple-valued variable) than on the words themselves.  The
+    primitives, and cofactor(), are compiled here for each number of words
+    from 1 to 8 with loops the compiler unrolls, and cube_setup() picks the
+    ones for the size of the cubes when the vector versions do not apply
+    (see setc_select()).  scofactor() is left as it is: it looks at the
+    words of a single variable, which is mostly one word.
+*/
+
+#include "espresso.h"
+
+#define FNW      1
+#define FNAME(f) fixed1_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      2
+#define FNAME(f) fixed2_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      3
+#define FNAME(f) fixed3_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      4
+#define FNAME(f) fixed4_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      5
+#define FNAME(f) fixed5_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      6
+#define FNAME(f) fixed6_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      7
+#define FNAME(f) fixed7_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+#define FNW      8
+#define FNAME(f) fixed8_##f
+#include "setc_fixed.h"
+#undef FNW
+#undef FNAME
+
+/* setc_fixed -- the kernels for cubes of "words" words (or NULL) */
+const setc_kernels_t *setc_fixed(int words) {
+    static const setc_kernels_t *const all[] = {
+        NULL,
+        &fixed1_kernels,
+        &fixed2_kernels,
+        &fixed3_kernels,
+        &fixed4_kernels,
+        &fixed5_kernels,
+        &fixed6_kernels,
+        &fixed7_kernels,
+        &fixed8_kernels,
+    };
+
+    if (words < 1 || words > 8)
+        return NULL;
+    return all[words];
+}
@@ -0,0 +1,189 @@
+/*
+ *  setc_fixed.h -- the setc.c primitives for cubes of a fixed number of
+ *  words
+ *
+ *  This file is included by setc_fixed.c once for each width, with the
+ *  following defined:
+ *
+ *      FNW         number of words of a cube (LOOP(cube.fullset))
+ *      FNAME(f)    name of "f" for this width
+ *
+ *  The loops over the words of a cube run at most FNW times, so that the
+ *  compiler unrolls them: the binary variables are checked in the words
+ *  up to cube.inword, with the mask of their first parts (rather than
+ *  handling the last of these words apart), and the multiple-valued
+ *  variables with their masks over the whole cube.
+ */
+
+/* FBIN -- the first parts of the binary variables in word w (of "bin") */
+#define FBIN(w) (bin[w] & DISJOINT)
+
+/* FNAME(meets) -- TRUE if a & b & mask is not empty */
+static inline bool FNAME(meets)(pcube a, pcube b, pcube mask) {
+    set_word_t x = 0;
+    int w;
+
+    for (w = 1; w <= FNW; w++)
+        x |= a[w] & b[w] & mask[w];
+    return x != 0;
+}
+
+static bool FNAME(full_row)(pcube p, pcube cof) {
+    set_word_t x = 0;
+    int w;
+
+    for (w = 1; w <= FNW; w++)
+        x |= (p[w] | cof[w]) ^ cube.fullset[w];
+    return x == 0;
+}
+
+static bool FNAME(setp_implies)(pset a, pset b) {
+    set_word_t x = 0;
+    int w;
+
+    /* this one is also used on sets which are not cubes */
+    if (LOOP(a) != FNW)
+        return (*setc_scalar.setp_implies)(a, b);
+    for (w = 1; w <= FNW; w++)
+        x |= a[w] & ~b[w];
+    return x == 0;
+}
+
+static inline bool FNAME(cdist0)(pcube a, pcube b) {
+    set_word_t x;
+    pcube bin = cube.binary_mask;
+    int w, var, nbin = cube.inword;
+
+    for (w = 1; w <= FNW && w <= nbin; w++) {
+        x = a[w] & b[w];
+        if (~(x | x >> 1) & FBIN(w))
+            return FALSE;
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++)
+        if (!FNAME(meets)(a, b, cube.var_mask[var]))
+            return FALSE;
+    return TRUE;
+}
+
+static int FNAME(cdist01)(pset a, pset b) {
+    set_word_t x;
+    pcube bin = cube.binary_mask;
+    int w, var, nbin = cube.inword, dist = 0;
+
+    for (w = 1; w <= FNW && w <= nbin; w++) {
+        x = a[w] & b[w];
+        if ((x = ~(x | x >> 1) & FBIN(w)))
+            dist += count_ones(x);
+    }
+    if (dist > 1)
+        return 2;
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++)
+        if (!FNAME(meets)(a, b, cube.var_mask[var]) && ++dist > 1)
+            return 2;
+    return dist;
+}
+
+static int FNAME(cdist)(pset a, pset b) {
+    set_word_t x;
+    pcube bin = cube.binary_mask;
+    int w, var, nbin = cube.inword, dist = 0;
+
+    for (w = 1; w <= FNW && w <= nbin; w++) {
+        x = a[w] & b[w];
+        if ((x = ~(x | x >> 1) & FBIN(w)))
+            dist += count_ones(x);
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++)
+        if (!FNAME(meets)(a, b, cube.var_mask[var]))
+            dist++;
+    return dist;
+}
+
+static pset FNAME(force_lower)(pset xlower, pset a, pset b) {
+    set_word_t x;
+    pcube mask, bin = cube.binary_mask;
+    int w, var, nbin = cube.inword;
+
+    for (w = 1; w <= FNW && w <= nbin; w++) {
+        x = a[w] & b[w];
+        x = ~(x | x >> 1) & FBIN(w);
+        xlower[w] |= (x | (x << 1)) & a[w];
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+        mask = cube.var_mask[var];
+        if (!FNAME(meets)(a, b, mask))
+            for (w = 1; w <= FNW; w++)
+                xlower[w] |= a[w] & mask[w];
+    }
+    return xlower;
+}
+
+static void FNAME(consensus)(pcube r, pcube a, pcube b) {
+    set_word_t x;
+    pcube mask, bin = cube.binary_mask;
+    int w, var, nbin = cube.inword;
+
+    INLINEset_clear(r, cube.size);
+    for (w = 1; w <= FNW; w++)
+        r[w] = a[w] & b[w];
+    for (w = 1; w <= FNW && w <= nbin; w++) {
+        x = ~(r[w] | r[w] >> 1) & FBIN(w);
+        r[w] |= (x | (x << 1)) & (a[w] | b[w]);
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+        mask = cube.var_mask[var];
+        if (!FNAME(meets)(a, b, mask))
+            for (w = 1; w <= FNW; w++)
+                r[w] |= mask[w] & (a[w] | b[w]);
+    }
+}
+
+static bool FNAME(ccommon)(pcube a, pcube b, pcube cof) {
+    set_word_t x, y;
+    pcube mask, bin = cube.binary_mask;
+    int w, var, nbin = cube.inword;
+
+    for (w = 1; w <= FNW && w <= nbin; w++) {
+        x = a[w] | cof[w];
+        y = b[w] | cof[w];
+        if (~(x & x >> 1) & ~(y & y >> 1) & FBIN(w))
+            return TRUE;
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+        mask = cube.var_mask[var];
+        x = y = 0;
+        for (w = 1; w <= FNW; w++) {
+            x |= mask[w] & ~a[w] & ~cof[w];
+            y |= mask[w] & ~b[w] & ~cof[w];
+        }
+        if (x != 0 && y != 0)
+            return TRUE; /* both active */
+    }
+    return FALSE;
+}
+
+/* cofactor (see cofactor.c), with the distance check above inline */
+static pcube *FNAME(cofactor)(pcube *T, pcube c) {
+    pcube temp = cube.temp[0], *Tc_save, *Tc, *T1, p;
+
+    Tc_save = Tc = new_cubelist(CUBELISTSIZE(T) + 5);
+    (void)set_or(*Tc++, T[0], set_diff(temp, cube.fullset, c));
+    Tc++;
+    for (T1 = T + 2; (p = *T1++) != NULL;)
+        if (p != c && FNAME(cdist0)(p, c))
+            *Tc++ = p;
+    *Tc++ = (pcube)NULL;
+    Tc_save[1] = (pcube)Tc;
+    return Tc_save;
+}
+
+static const setc_kernels_t FNAME(kernels) = {
+    "fixed",          FNW,
+    FNAME(full_row),  FNAME(setp_implies),
+    FNAME(cdist0),    FNAME(cdist01),
+    FNAME(cdist),     FNAME(force_lower),
+    FNAME(consensus), FNAME(ccommon),
+    FNAME(cofactor),
+};
+
+#undef FBIN
@@ -0,0 +1,131 @@
+/*
+    module: setc_simd.c
+    purpose: vector versions of the cube primitives of setc.c
+
+    The primitives are compiled for each vector instruction set the
+    compiler knows (SSE2, AVX2 and AVX-512 on x86, NEON on ARM), and
+    cube_setup() picks the widest one the processor supports, provided
+    that the binary variables fill at least one vector (otherwise the
+    vector loops never run, and the plain versions are faster).  The
+    plain versions are then those of setc_fixed.c for cubes of up to 8
+    words.  The environment variable ESPRESSO_SIMD may name the
+    instruction set to use ("scalar", "sse2", "avx2", "avx512" or "neon",
+    or "fixed").
+*/
+
+#include "espresso.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SETC_X86 1
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define SETC_NEON 1
+#endif
+
+#if defined(SETC_X86) || defined(SETC_NEON)
+/* whether some bit of a 16-byte vector is set */
+typedef unsigned long long setc_v2 __attribute__((vector_size(16)));
+#define ANY16(v) (((setc_v2)(v))[0] != 0 || ((setc_v2)(v))[1] != 0)
+#endif
+
+#ifdef SETC_X86
+#define VNAME     "sse2"
+#define KNAME(f)  sse2_##f
+#define KATTR     __attribute__((target("sse2")))
+#define VBYTES    16
+#define KANY(v)   ANY16(v)
+#include "setc_simd.h"
+#undef VNAME
+#undef KNAME
+#undef KATTR
+#undef VBYTES
+#undef KANY
+
+#define VNAME     "avx2"
+#define KNAME(f)  avx2_##f
+#define KATTR     __attribute__((target("avx2")))
+#define VBYTES    32
+#define KANY(v)   (!_mm256_testz_si256((__m256i)(v), (__m256i)(v)))
+#include "setc_simd.h"
+#undef VNAME
+#undef KNAME
+#undef KATTR
+#undef VBYTES
+#undef KANY
+
+#define VNAME     "avx512"
+#define KNAME(f)  avx512_##f
+#define KATTR     __attribute__((target("avx512f")))
+#define VBYTES    64
+#define KANY(v)   (_mm512_test_epi64_mask((__m512i)(v), (__m512i)(v)) != 0)
+#include "setc_simd.h"
+#undef VNAME
+#undef KNAME
+#undef KATTR
+#undef VBYTES
+#undef KANY
+#endif
+
+#ifdef SETC_NEON
+#define VNAME     "neon"
+#define KNAME(f)  neon_##f
+#define KATTR
+#define VBYTES    16
+#define KANY(v)   ANY16(v)
+#include "setc_simd.h"
+#undef VNAME
+#undef KNAME
+#undef KATTR
+#undef VBYTES
+#undef KANY
+#endif
+
+/* setc_supported -- can the processor run the kernels "k" ? */
+static bool setc_supported(const setc_kernels_t *k) {
+    if (k == &setc_scalar)
+        return TRUE;
+#ifdef SETC_X86
+    __builtin_cpu_init();
+    if (k == &sse2_kernels)
+        return __builtin_cpu_supports("sse2");
+    if (k == &avx2_kernels)
+        return __builtin_cpu_supports("avx2");
+    if (k == &avx512_kernels)
+        return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef SETC_NEON
+    if (k == &neon_kernels)
+        return TRUE;
+#endif
+    return FALSE;
+}
+
+/* setc_select -- choose the kernels for the cube primitives (of "cube") */
+const setc_kernels_t *setc_select() {
+    static const setc_kernels_t *const all[] = {
+#ifdef SETC_X86
+        &avx512_kernels, &avx2_kernels, &sse2_kernels,
+#endif
+#ifdef SETC_NEON
+        &neon_kernels,
+#endif
+        &setc_scalar,
+    };
+    const setc_kernels_t *fixed = setc_fixed(LOOP(cube.fullset));
+    int i, n = sizeof(all) / sizeof(all[0]);
+    int full_words = cube.inword - 1; /* full words of binary variables */
+    char *name = getenv("ESPRESSO_SIMD");
+
+    if (name != NULL) {
+        for (i = 0; i < n; i++)
+            if (equal(all[i]->name, name) && setc_supported(all[i]))
+                return all[i];
+        if (equal(name, "fixed") && fixed != NULL)
+            return fixed;
+    }
+    for (i = 0; i < n; i++)
+        if (all[i] != &setc_scalar && all[i]->width <= full_words &&
+            setc_supported(all[i]))
+            return all[i];
+    return fixed != NULL ? fixed : &setc_scalar;
+}
@@ -0,0 +1,294 @@
+/*
+ *  setc_simd.h -- the setc.c primitives for one vector instruction set
+ *
+ *  This file is included by setc_simd.c once for each instruction set,
+ *  with the following defined:
+ *
+ *      VNAME       name of the instruction set (a string)
+ *      KNAME(f)    name of "f" for this instruction set
+ *      KATTR       attributes which enable the instruction set
+ *      VBYTES      width of a vector in bytes
+ *      KANY(v)     TRUE if some bit of the vector v is set
+ *
+ *  Only the words of binary variables, and multiple-valued variables
+ *  which span at least a vector of words, are handled a vector at a
+ *  time; the partial word of binary variables and any words left over
+ *  are handled as in setc.c.
+ */
+
+typedef set_word_t KNAME(vec) __attribute__((vector_size(VBYTES)));
+
+#define VEC KNAME(vec)
+#define VW  ((int)(VBYTES / sizeof(set_word_t))) /* words per vector */
+
+static KATTR inline VEC KNAME(load)(pcube p) {
+    VEC v;
+    memcpy(&v, p, VBYTES);
+    return v;
+}
+
+static KATTR inline void KNAME(store)(pcube p, VEC v) {
+    memcpy(p, &v, VBYTES);
+}
+
+/* count the variables flagged in each word of v */
+static KATTR inline int KNAME(count)(VEC v) {
+    int i, n = 0;
+    for (i = 0; i < VW; i++)
+        n += count_ones(v[i]);
+    return n;
+}
+
+/* any_and3 -- TRUE if a & b & mask is not empty in words first .. last */
+static KATTR inline bool KNAME(any_and3)(pcube a, pcube b, pcube mask,
+                                         int first, int last) {
+    int w;
+    for (w = first; w + VW - 1 <= last; w += VW)
+        if (KANY(KNAME(load)(a + w) & KNAME(load)(b + w) &
+                 KNAME(load)(mask + w)))
+            return TRUE;
+    for (; w <= last; w++)
+        if (a[w] & b[w] & mask[w])
+            return TRUE;
+    return FALSE;
+}
+
+static KATTR bool KNAME(full_row)(pcube p, pcube cof) {
+    int w, last = LOOP(p);
+    pcube full = cube.fullset;
+
+    for (w = 1; w + VW - 1 <= last; w += VW)
+        if (KANY((KNAME(load)(p + w) | KNAME(load)(cof + w)) ^
+                 KNAME(load)(full + w)))
+            return FALSE;
+    for (; w <= last; w++)
+        if ((p[w] | cof[w]) != full[w])
+            return FALSE;
+    return TRUE;
+}
+
+static KATTR bool KNAME(setp_implies)(pset a, pset b) {
+    int w, last = LOOP(a);
+
+    for (w = 1; w + VW - 1 <= last; w += VW)
+        if (KANY(KNAME(load)(a + w) & ~KNAME(load)(b + w)))
+            return FALSE;
+    for (; w <= last; w++)
+        if (a[w] & ~b[w])
+            return FALSE;
+    return TRUE;
+}
+
+static KATTR bool KNAME(cdist0)(pcube a, pcube b) {
+    int w, var, last;
+    set_word_t x;
+    VEC v, zero = {0};
+
+    if ((last = cube.inword) != -1) {
+        x = a[last] & b[last];
+        if (~(x | x >> 1) & cube.inmask)
+            return FALSE;
+        for (w = 1; w + VW - 1 < last; w += VW) {
+            v = KNAME(load)(a + w) & KNAME(load)(b + w);
+            if (KANY(~(v | v >> 1) & (zero + DISJOINT)))
+                return FALSE;
+        }
+        for (; w < last; w++) {
+            x = a[w] & b[w];
+            if (~(x | x >> 1) & DISJOINT)
+                return FALSE;
+        }
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++)
+        if (!KNAME(any_and3)(a, b, cube.var_mask[var], cube.first_word[var],
+                             cube.last_word[var]))
+            return FALSE;
+    return TRUE;
+}
+
+static KATTR int KNAME(cdist01)(pset a, pset b) {
+    int w, var, last, dist = 0;
+    set_word_t x;
+    VEC v, zero = {0};
+
+    if ((last = cube.inword) != -1) {
+        x = a[last] & b[last];
+        if ((x = ~(x | x >> 1) & cube.inmask))
+            if ((dist = count_ones(x)) > 1)
+                return 2;
+        for (w = 1; w + VW - 1 < last; w += VW) {
+            v = KNAME(load)(a + w) & KNAME(load)(b + w);
+            v = ~(v | v >> 1) & (zero + DISJOINT);
+            if (KANY(v))
+                if (dist == 1 || (dist += KNAME(count)(v)) > 1)
+                    return 2;
+        }
+        for (; w < last; w++) {
+            x = a[w] & b[w];
+            if ((x = ~(x | x >> 1) & DISJOINT))
+                if (dist == 1 || (dist += count_ones(x)) > 1)
+                    return 2;
+        }
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++)
+        if (!KNAME(any_and3)(a, b, cube.var_mask[var], cube.first_word[var],
+                             cube.last_word[var]))
+            if (++dist > 1)
+                return 2;
+    return dist;
+}
+
+static KATTR int KNAME(cdist)(pset a, pset b) {
+    int w, var, last, dist = 0;
+    set_word_t x;
+    VEC v, zero = {0};
+
+    if ((last = cube.inword) != -1) {
+        x = a[last] & b[last];
+        if ((x = ~(x | x >> 1) & cube.inmask))
+            dist = count_ones(x);
+        for (w = 1; w + VW - 1 < last; w += VW) {
+            v = KNAME(load)(a + w) & KNAME(load)(b + w);
+            v = ~(v | v >> 1) & (zero + DISJOINT);
+            if (KANY(v))
+                dist += KNAME(count)(v);
+        }
+        for (; w < last; w++) {
+            x = a[w] & b[w];
+            if ((x = ~(x | x >> 1) & DISJOINT))
+                dist += count_ones(x);
+        }
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++)
+        if (!KNAME(any_and3)(a, b, cube.var_mask[var], cube.first_word[var],
+                             cube.last_word[var]))
+            dist++;
+    return dist;
+}
+
+static KATTR pset KNAME(force_lower)(pset xlower, pset a, pset b) {
+    int w, var, last;
+    set_word_t x;
+    VEC v, va, zero = {0};
+    pcube mask;
+
+    if ((last = cube.inword) != -1) {
+        x = a[last] & b[last];
+        if ((x = ~(x | x >> 1) & cube.inmask))
+            xlower[last] |= (x | (x << 1)) & a[last];
+        for (w = 1; w + VW - 1 < last; w += VW) {
+            va = KNAME(load)(a + w);
+            v = va & KNAME(load)(b + w);
+            v = ~(v | v >> 1) & (zero + DISJOINT);
+            if (KANY(v))
+                KNAME(store)(xlower + w,
+                             KNAME(load)(xlower + w) | ((v | (v << 1)) & va));
+        }
+        for (; w < last; w++) {
+            x = a[w] & b[w];
+            if ((x = ~(x | x >> 1) & DISJOINT))
+                xlower[w] |= (x | (x << 1)) & a[w];
+        }
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+        mask = cube.var_mask[var];
+        last = cube.last_word[var];
+        if (!KNAME(any_and3)(a, b, mask, cube.first_word[var], last))
+            for (w = cube.first_word[var]; w <= last; w++)
+                xlower[w] |= a[w] & mask[w];
+    }
+    return xlower;
+}
+
+static KATTR void KNAME(consensus)(pcube r, pcube a, pcube b) {
+    int w, var, last;
+    set_word_t x;
+    VEC v, va, vb, zero = {0};
+    bool empty;
+    pcube mask;
+
+    INLINEset_clear(r, cube.size);
+    if ((last = cube.inword) != -1) {
+        r[last] = x = a[last] & b[last];
+        if ((x = ~(x | x >> 1) & cube.inmask))
+            r[last] |= (x | (x << 1)) & (a[last] | b[last]);
+        for (w = 1; w + VW - 1 < last; w += VW) {
+            va = KNAME(load)(a + w);
+            vb = KNAME(load)(b + w);
+            v = ~((va & vb) | (va & vb) >> 1) & (zero + DISJOINT);
+            KNAME(store)(r + w, (va & vb) | ((v | (v << 1)) & (va | vb)));
+        }
+        for (; w < last; w++) {
+            r[w] = x = a[w] & b[w];
+            if ((x = ~(x | x >> 1) & DISJOINT))
+                r[w] |= (x | (x << 1)) & (a[w] | b[w]);
+        }
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+        mask = cube.var_mask[var];
+        last = cube.last_word[var];
+        empty = TRUE;
+        for (w = cube.first_word[var]; w <= last; w++)
+            if ((x = a[w] & b[w] & mask[w]))
+                empty = FALSE, r[w] |= x;
+        if (empty)
+            for (w = cube.first_word[var]; w <= last; w++)
+                r[w] |= mask[w] & (a[w] | b[w]);
+    }
+}
+
+static KATTR bool KNAME(ccommon)(pcube a, pcube b, pcube cof) {
+    int w, var, last;
+    set_word_t x, y;
+    VEC vx, vy, vc, zero = {0};
+    pcube mask;
+
+    if ((last = cube.inword) != -1) {
+        x = a[last] | cof[last];
+        y = b[last] | cof[last];
+        if (~(x & x >> 1) & ~(y & y >> 1) & cube.inmask)
+            return TRUE;
+        for (w = 1; w + VW - 1 < last; w += VW) {
+            vc = KNAME(load)(cof + w);
+            vx = KNAME(load)(a + w) | vc;
+            vy = KNAME(load)(b + w) | vc;
+            if (KANY(~(vx & vx >> 1) & ~(vy & vy >> 1) & (zero + DISJOINT)))
+                return TRUE;
+        }
+        for (; w < last; w++) {
+            x = a[w] | cof[w];
+            y = b[w] | cof[w];
+            if (~(x & x >> 1) & ~(y & y >> 1) & DISJOINT)
+                return TRUE;
+        }
+    }
+    for (var = cube.num_binary_vars; var < cube.num_vars; var++) {
+        mask = cube.var_mask[var];
+        last = cube.last_word[var];
+        for (w = cube.first_word[var]; w <= last; w++)
+            if (mask[w] & ~a[w] & ~cof[w]) {
+                for (w = cube.first_word[var]; w <= last; w++)
+                    if (mask[w] & ~b[w] & ~cof[w])
+                        return TRUE;
+                break;
+            }
+    }
+    return FALSE;
+}
+
+static const setc_kernels_t KNAME(kernels) = {
+    .name = VNAME,
+    .width = VW,
+    .full_row = KNAME(full_row),
+    .setp_implies = KNAME(setp_implies),
+    .cdist0 = KNAME(cdist0),
+    .cdist01 = KNAME(cdist01),
+    .cdist = KNAME(cdist),
+    .force_lower = KNAME(force_lower),
+    .consensus = KNAME(consensus),
+    .ccommon = KNAME(ccommon),
+    .cofactor = NULL,
+};
+
+#undef VEC
+#undef VW
@@ -6,7 +6,7 @@ pset do_sm_minimum_cover(pset_family A) {
     sm_element *pe;
     pset cover;
     int i, base, rownum;
-    unsigned val;
+    set_word_t val;
     pset last, p;
 
     M = sm_alloc();
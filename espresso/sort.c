@@ -0,0 +1,217 @@
+/*
+    module: sort.c
+    purpose: sorting the sets of a family by integer keys
+
+    The cubes are sorted by a key (their size, or a weight), ascending or
+    descending; the ties are broken by a hash of the cube when the context
+    has a seed (see portfolio.c), and then by the words of the cube, from
+    the last one down, in the direction of the key.  This is the order of
+    the comparisons ascend() and descend() (with the seed, that of the
+    stable qsort() which sorted with them), so that the covers come out
+    the same.
+
+    Rather than calling a comparison through qsort() for each pair, the
+    (key, index) pairs are sorted by a radix sort on the key (8 bits at a
+    time, skipping the bytes which are the same for all keys), and only
+    the runs of equal keys are sorted further, by a merge sort comparing
+    the cubes inline.  The cubes are then moved into their order in place.
+*/
+
+#include "espresso.h"
+
+typedef struct {
+    unsigned int key; /* the key, complemented for a descending order */
+    int index;        /* of the set in the family */
+} sort_item_t;
+
+/* what breaks the ties of the key */
+typedef struct {
+    pset_family A;
+    pset mask;                /* the words are or'ed with it (or NULL) */
+    unsigned long long *hash; /* of each set (or NULL) */
+    bool descend;
+} sort_ties_t;
+
+/* set_hash -- a hash of the set, drawn from the seed of the context */
+static unsigned long long set_hash(pset p) {
+    unsigned long long h = current_context->seed;
+    int i;
+
+    for (i = LOOP(p); i > 0; i--)
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    return h ^ (h >> 29);
+}
+
+/* ties_compare -- the order of two items of equal keys */
+static inline int ties_compare(sort_ties_t *t, sort_item_t *x,
+                               sort_item_t *y) {
+    pset a = GETSET(t->A, x->index), b = GETSET(t->A, y->index);
+    pset m = t->mask;
+    set_word_t wa, wb;
+    int i;
+
+    if (t->hash != NULL && t->hash[x->index] != t->hash[y->index])
+        return t->hash[x->index] < t->hash[y->index] ? -1 : 1;
+    for (i = LOOP(a); i > 0; i--) {
+        wa = m != NULL ? a[i] | m[i] : a[i];
+        wb = m != NULL ? b[i] | m[i] : b[i];
+        if (wa != wb)
+            return (wa > wb) == t->descend ? -1 : 1;
+    }
+    return 0;
+}
+
+/* merge_sort -- stable sort of the n items at "a" ("tmp" holds n / 2) */
+static void merge_sort(sort_ties_t *t, sort_item_t *a, sort_item_t *tmp,
+                       int n) {
+    sort_item_t x, *left, *right, *end;
+    int i, j, h;
+
+    if (n <= 8) {
+        for (i = 1; i < n; i++) {
+            x = a[i];
+            for (j = i; j > 0 && ties_compare(t, &a[j - 1], &x) > 0; j--)
+                a[j] = a[j - 1];
+            a[j] = x;
+        }
+        return;
+    }
+
+    h = n / 2;
+    merge_sort(t, a, tmp, h);
+    merge_sort(t, a + h, tmp, n - h);
+    if (ties_compare(t, &a[h - 1], &a[h]) <= 0)
+        return;
+
+    /* merge the first half (moved to tmp) and the second one into a */
+    memcpy(tmp, a, h * sizeof(sort_item_t));
+    left = tmp, right = a + h, end = a + n;
+    for (i = 0; left < tmp + h; i++)
+        if (right < end && ties_compare(t, right, left) < 0)
+            a[i] = *right++;
+        else
+            a[i] = *left++;
+}
+
+/* radix_sort -- stable sort of the n items at "a" by key ("tmp" holds n) */
+static void radix_sort(sort_item_t *a, sort_item_t *tmp, int n) {
+    sort_item_t *from = a, *to = tmp, *swap;
+    int count[256], shift, i, d, sum, c;
+
+    if (n == 0)
+        return;
+
+    for (shift = 0; shift < 32; shift += 8) {
+        for (d = 0; d < 256; d++)
+            count[d] = 0;
+        for (i = 0; i < n; i++)
+            count[(from[i].key >> shift) & 255]++;
+        if (count[(from[0].key >> shift) & 255] == n)
+            continue; /* the same byte for all of the keys */
+        for (sum = d = 0; d < 256; d++)
+            c = count[d], count[d] = sum, sum += c;
+        for (i = 0; i < n; i++)
+            to[count[(from[i].key >> shift) & 255]++] = from[i];
+        swap = from, from = to, to = swap;
+    }
+    if (from != a)
+        memcpy(a, from, n * sizeof(sort_item_t));
+}
+
+/*
+    sf_order -- the order of the sets of A (so many indices of sets), by
+    "key" (one per set, or NULL for none) and their words or'ed with
+    "mask" (or NULL); "flags" is SORT_ASCEND or SORT_DESCEND, with
+    SORT_SEEDED to break the ties of the key by the seed of the context
+*/
+int *sf_order(pset_family A, unsigned int *key, pset mask, int flags) {
+    sort_item_t *items, *tmp;
+    sort_ties_t ties;
+    int i, j, n = A->count, *order;
+
+    items = ALLOC(sort_item_t, MAX(n, 1));
+    tmp = ALLOC(sort_item_t, MAX(n, 1));
+    ties.A = A;
+    ties.mask = mask;
+    ties.hash = NIL(unsigned long long);
+    ties.descend = (flags & SORT_DESCEND) != 0;
+    for (i = 0; i < n; i++) {
+        items[i].key = key == NULL ? 0 : ties.descend ? ~key[i] : key[i];
+        items[i].index = i;
+    }
+    if (key != NULL)
+        radix_sort(items, tmp, n);
+
+    if ((flags & SORT_SEEDED) && current_context->seed != 0) {
+        ties.hash = ALLOC(unsigned long long, MAX(n, 1));
+        for (i = 0; i < n; i++)
+            ties.hash[i] = set_hash(GETSET(A, i));
+    }
+
+    /* the runs of equal keys */
+    for (i = 0; i < n; i = j) {
+        for (j = i + 1; j < n && items[j].key == items[i].key; j++)
+            ;
+        if (j - i > 1)
+            merge_sort(&ties, items + i, tmp, j - i);
+    }
+
+    order = ALLOC(int, MAX(n, 1));
+    for (i = 0; i < n; i++)
+        order[i] = items[i].index;
+    FREE(items);
+    FREE(tmp);
+    if (ties.hash != NULL)
+        FREE(ties.hash);
+    return order;
+}
+
+/*
+    sf_permute -- move set order[i] of A to place i, for each i, in place
+    (following the cycles of the permutation); "order" is freed
+*/
+void sf_permute(pset_family A, int *order) {
+    pset temp = ALLOC(set_word_t, A->wsize);
+    int i, j, k, bytes = A->wsize * sizeof(set_word_t);
+
+    for (i = 0; i < A->count; i++) {
+        if (order[i] < 0 || order[i] == i)
+            continue;
+        memcpy(temp, GETSET(A, i), bytes);
+        for (j = i; (k = order[j]) != i; j = k) {
+            memcpy(GETSET(A, j), GETSET(A, k), bytes);
+            order[j] = -1;
+        }
+        memcpy(GETSET(A, j), temp, bytes);
+        order[j] = -1;
+    }
+    FREE(temp);
+    FREE(order);
+}
+
+/*
+    sf_keep -- keep the "cnt" sets of the list A1 (sets of A) in A, in the
+    order of the list, dropping the others; A1 is freed
+*/
+pset_family sf_keep(pset_family A, pset *A1, int cnt) {
+    int i, n, *order;
+    bool *listed;
+
+    order = ALLOC(int, MAX(A->count, 1));
+    listed = ALLOC(bool, MAX(A->count, 1));
+    for (i = 0; i < A->count; i++)
+        listed[i] = FALSE;
+    for (i = 0; i < cnt; i++) {
+        order[i] = (A1[i] - A->data) / A->wsize;
+        listed[order[i]] = TRUE;
+    }
+    for (n = cnt, i = 0; i < A->count; i++)
+        if (!listed[i])
+            order[n++] = i;
+    sf_permute(A, order);
+    A->count = cnt;
+    A->active_count = 0;
+    FREE(listed);
+    FREE(A1);
+    return A;
+}
@@ -20,7 +20,6 @@ struct sm_element_struct {
     sm_element *prev_row; /* previous row in this column */
     sm_element *next_col; /* next column in this row */
     sm_element *prev_col; /* previous column in this row */
-    char *user_word;      /* user-defined word */
 };
 
 /*
@@ -34,7 +33,6 @@ struct sm_row_struct {
     sm_element *last_col;  /* last element in this row */
     sm_row *next_row;      /* next row (in sm_matrix linked list) */
     sm_row *prev_row;      /* previous row (in sm_matrix linked list) */
-    char *user_word;       /* user-defined word */
 };
 
 /*
@@ -48,7 +46,6 @@ struct sm_col_struct {
     sm_element *last_row;  /* last element in this column */
     sm_col *next_col;      /* next column (in sm_matrix linked list) */
     sm_col *prev_col;      /* prev column (in sm_matrix linked list) */
-    char *user_word;       /* user-defined word */
 };
 
 /*
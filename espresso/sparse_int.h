@@ -73,29 +73,41 @@
         count--;                                      \
     }
 
-#ifdef FAST_AND_LOOSE
-extern sm_element *sm_element_freelist;
-extern sm_row *sm_row_freelist;
-extern sm_col *sm_col_freelist;
+/*
+ *  the free elements, rows and columns of a thread (see matrix.c)
+ */
+typedef struct {
+    sm_element *elements; /* linked by next_col */
+    sm_row *rows;         /* linked by next_row */
+    sm_col *cols;         /* linked by next_col */
+    long nelements;       /* on each of the lists */
+    long nrows;
+    long ncols;
+} sm_pool_t;
 
-#define sm_element_alloc(newobj)                             \
-    if (sm_element_freelist == NIL(sm_element)) {            \
-        newobj = ALLOC(sm_element, 1);                       \
-    } else {                                                 \
-        newobj = sm_element_freelist;                        \
-        sm_element_freelist = sm_element_freelist->next_col; \
-    }                                                        \
-    newobj->user_word = NIL(char);
+#define SM_ELEMENTS 0
+#define SM_ROWS     1
+#define SM_COLS     2
 
-#define sm_element_free(e) \
-    (e->next_col = sm_element_freelist, sm_element_freelist = e)
+extern THREAD_LOCAL sm_pool_t sm_pool;
+void sm_pool_refill(int kind);
 
+#ifdef NO_SM_POOL
+#define sm_element_alloc(newobj) newobj = ALLOC(sm_element, 1);
+#define sm_element_free(e)       FREE(e)
 #else
+#define sm_element_alloc(newobj)                 \
+    {                                            \
+        if (sm_pool.elements == NIL(sm_element)) \
+            sm_pool_refill(SM_ELEMENTS);         \
+        newobj = sm_pool.elements;               \
+        sm_pool.elements = newobj->next_col;     \
+        sm_pool.nelements--;                     \
+    }
 
-#define sm_element_alloc(newobj)   \
-    newobj = ALLOC(sm_element, 1); \
-    newobj->user_word = NIL(char);
-#define sm_element_free(e) FREE(e)
+#define sm_element_free(e)                                 \
+    (e->next_col = sm_pool.elements, sm_pool.elements = e, \
+     sm_pool.nelements++)
 #endif
 
 void sm_row_remove_element(sm_row *prow, sm_element *p);
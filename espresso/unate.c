@@ -5,7 +5,8 @@
 #include "espresso.h"
 
 pcover map_cover_to_unate(pcube *T) {
-    unsigned int word_test, word_set, bit_test, bit_set;
+    int word_test, word_set;
+    set_word_t bit_test, bit_set;
     pcube p, pA;
     pset_family A;
     pcube *T1;
@@ -24,9 +25,9 @@ pcover map_cover_to_unate(pcube *T) {
 
             /* Copy a column from T to A */
             word_test = WHICH_WORD(i);
-            bit_test = 1 << WHICH_BIT(i);
+            bit_test = BIT(i);
             word_set = WHICH_WORD(ncol);
-            bit_set = 1 << WHICH_BIT(ncol);
+            bit_set = BIT(ncol);
 
             pA = A->data;
             for (T1 = T + 2; (p = *T1++) != 0;) {
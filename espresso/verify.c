@@ -0,0 +1,72 @@
+/*
+    module: verify.c
+    purpose: checking that a minimized cover is equivalent to the function
+
+    The result F of minimizing F0 (with the don't-care set D) is a cover
+    of the function if F0 is within F u D, and F within F0 u D: each cube
+    of F0 is checked against the cube list of F u D, and each cube of F
+    against that of F0 u D, with cube_is_covered().  The cubes are
+    checked concurrently (see parallel_for()), and once one is found which
+    is not covered, the cubes not checked yet are skipped.
+*/
+
+#include "espresso.h"
+
+typedef struct {
+    pcover A;      /* the cubes to check */
+    pcube *T;      /* the cube list they must be covered by */
+    bool *covered; /* for each cube of A (TRUE when it was skipped) */
+    int failed;    /* a cube was found which is not covered */
+} verify_t;
+
+static void verify_cube(void *arg, int i) {
+    verify_t *v = (verify_t *)arg;
+
+    v->covered[i] = TRUE;
+    if (__atomic_load_n(&v->failed, __ATOMIC_RELAXED))
+        return;
+    if (!cube_is_covered(v->T, GETSET(v->A, i))) {
+        v->covered[i] = FALSE;
+        __atomic_store_n(&v->failed, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* verify_within -- the first cube of A found outside of B u D (or -1) */
+static int verify_within(pcover A, pcover B, pcover D) {
+    verify_t v;
+    int i;
+
+    v.A = A;
+    v.T = cube2list(B, D);
+    v.covered = ALLOC(bool, MAX(A->count, 1));
+    v.failed = 0;
+    parallel_for(A->count, verify_cube, &v);
+    free_cubelist(v.T);
+    for (i = 0; i < A->count && v.covered[i]; i++)
+        ;
+    FREE(v.covered);
+    return i < A->count ? i : -1;
+}
+
+/*
+    espresso_verify -- TRUE if F is a cover of the function of F0 and D;
+    otherwise a cube which is in one of F and F0 and not in the other (nor
+    in D) is printed on stderr
+*/
+bool espresso_verify(pcover F, pcover F0, pcover D) {
+    int i;
+
+    if ((i = verify_within(F0, F, D)) >= 0) {
+        fprintf(stderr, "espresso: verify: cube %d of the ON-set is not "
+                        "covered by the result:\n", i + 1);
+        print_cube(stderr, GETSET(F0, i), "01");
+        return FALSE;
+    }
+    if ((i = verify_within(F, F0, D)) >= 0) {
+        fprintf(stderr, "espresso: verify: cube %d of the result is not "
+                        "within the ON-set and DC-set:\n", i + 1);
+        print_cube(stderr, GETSET(F, i), "01");
+        return FALSE;
+    }
+    return TRUE;
+}